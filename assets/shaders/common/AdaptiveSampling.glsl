@@ -0,0 +1,48 @@
+// Variance driven sample counts, the including shader picks the binding. Accumulate.comp keeps the luminance moments of
+// every pixel and writes a relative error per tile of ADAPTIVE_TILE_WIDTH x ADAPTIVE_TILE_HEIGHT pixels, summing the
+// frame's total into the slot of its parity. The next frame traces NumberOfSamples per pixel on average: every pixel
+// keeps one, the rest of the budget goes to the tiles by their share of the total error.
+layout(binding = ADAPTIVE_BINDING) buffer AdaptiveTileArray { uint AdaptiveTiles[]; };
+
+uint AdaptiveTileCount(uvec2 size)
+{
+	return ((size.x + ADAPTIVE_TILE_WIDTH - 1) / ADAPTIVE_TILE_WIDTH) * ((size.y + ADAPTIVE_TILE_HEIGHT - 1) / ADAPTIVE_TILE_HEIGHT);
+}
+
+// the first two slots hold the totals
+uint AdaptiveTileSlot(uvec2 pixel, uvec2 size)
+{
+	const uint columns = (size.x + ADAPTIVE_TILE_WIDTH - 1) / ADAPTIVE_TILE_WIDTH;
+	return 2 + pixel.y / ADAPTIVE_TILE_HEIGHT * columns + pixel.x / ADAPTIVE_TILE_WIDTH;
+}
+
+// relative standard error of the accumulated mean from x = E[L], y = E[L^2] and z = frames of history. Dark pixels hide
+// their noise under the tonemap, so the mean gets a floor, and a history of less than two frames knows nothing yet
+float AdaptivePixelError(vec3 moments)
+{
+	if (moments.z < 2.0)
+	{
+		return 1.0;
+	}
+	const float variance = max(0.0, moments.y - moments.x * moments.x);
+	return min(1.0, sqrt(variance / moments.z) / (moments.x + 1.0));
+}
+
+// the samples the pixel traces this frame, from the errors the last frame left behind
+uint AdaptiveSampleCount(uvec2 pixel, uvec2 size, uint frame, uint budget)
+{
+	const uint total = AdaptiveTiles[(frame + 1) & 1u];
+	if (frame == 0 || total == 0 || budget <= 1)
+	{
+		return budget;
+	}
+
+	const float share = float(AdaptiveTiles[AdaptiveTileSlot(pixel, size)]) / float(total);
+	const float extra = float(budget - 1) * float(AdaptiveTileCount(size)) * share;
+
+	// an ordered dither inside the tile, so the tile spends the fraction of a sample it was given
+	const uint tilePixels = ADAPTIVE_TILE_WIDTH * ADAPTIVE_TILE_HEIGHT;
+	const uint slot = (pixel.y % ADAPTIVE_TILE_HEIGHT) * ADAPTIVE_TILE_WIDTH + pixel.x % ADAPTIVE_TILE_WIDTH;
+	const float threshold = (float((slot * 13 + frame * 7) % tilePixels) + 0.5) / float(tilePixels);
+	return min(1 + uint(extra) + (fract(extra) > threshold ? 1u : 0u), ADAPTIVE_MAX_SAMPLES);
+}
@@ -0,0 +1,47 @@
+#include "Const_Func.glsl"
+#include "Random.glsl"
+
+#ifndef environmentsampling_inc
+#define environmentsampling_inc
+
+// Importance sampling of the hdri sky through the alias table the texture pool builds when it loads, see
+// Assets::LightSampler::BuildEnvironmentTable. The including shader declares EnvironmentTables; only valid while
+// Camera.HasSkyTable is set. Both pdfs are per solid angle.
+const uint EnvironmentTableWidth = ENVIRONMENT_TABLE_WIDTH;
+const uint EnvironmentTableHeight = ENVIRONMENT_TABLE_HEIGHT;
+const uint EnvironmentTableCells = EnvironmentTableWidth * EnvironmentTableHeight;
+
+vec3 SampleEnvironment(inout uvec4 seed, out float pdf)
+{
+	const uint base = Camera.SkyIdx * EnvironmentTableCells;
+	const float u = RandomFloat(seed) * EnvironmentTableCells;
+	const uint slot = min(uint(u), EnvironmentTableCells - 1);
+	const LightAlias entry = EnvironmentTables[base + slot];
+	const uint cell = u - slot < entry.Probability ? slot : entry.Alias;
+
+	// a uniform point of the cell, whose share of the sphere shrinks with sin theta
+	const vec2 jitter = RandomFloat2(seed);
+	const float theta = M_PI * (float(cell / EnvironmentTableWidth) + jitter.y) / EnvironmentTableHeight;
+	const float phi = M_TWO_PI * (float(cell % EnvironmentTableWidth) + jitter.x) / EnvironmentTableWidth - M_PI * Camera.SkyRotation;
+	const float sinTheta = sin(theta);
+	pdf = sinTheta > 0 ? EnvironmentTables[base + cell].Pdf * EnvironmentTableCells / (2 * M_PI * M_PI * sinTheta) : 0;
+	return vec3(sinTheta * sin(phi), cos(theta), sinTheta * cos(phi));
+}
+
+float EnvironmentPdf(const vec3 direction)
+{
+	const vec3 d = normalize(direction);
+	const float sinTheta = sqrt(max(0.0, 1.0 - d.y * d.y));
+	if (sinTheta <= 0)
+	{
+		return 0;
+	}
+
+	// the same mapping as equirectangularSample
+	const vec2 t = vec2((atan(d.x, d.z) + M_PI * Camera.SkyRotation) * M_1_OVER_TWO_PI, acos(clamp(d.y, -1.0, 1.0)) * M_1_PI);
+	const uint x = min(uint(fract(t.x) * EnvironmentTableWidth), EnvironmentTableWidth - 1);
+	const uint y = min(uint(t.y * EnvironmentTableHeight), EnvironmentTableHeight - 1);
+	return EnvironmentTables[Camera.SkyIdx * EnvironmentTableCells + y * EnvironmentTableWidth + x].Pdf * EnvironmentTableCells / (2 * M_PI * M_PI * sinTheta);
+}
+
+#endif
@@ -29,6 +29,34 @@ struct LightObject
 	vec4 p1;
 	vec4 p3;
 	vec4 normal_area;
+	uint MaterialIndex;
+	uint Triangle;
+	uint Reserved1;
+	uint Reserved2;
+};
+
+// one slot of the light alias table: keep the slot's own light with Probability, else take Alias.
+// Pdf is the selection probability of the slot's own light
+struct LightAlias
+{
+	float Probability;
+	uint Alias;
+	float Pdf;
+	float Reserved0;
+};
+
+// node of the light bvh. The two children of an inner node sit next to each other from Child on, a leaf holds one
+// light and Child is its index. The normals of all lights below lie within HalfAngle of Axis
+struct LightTreeNode
+{
+	vec4 BoundsMin;	// w: power of the lights below
+	vec4 BoundsMax;	// w: HalfAngle
+	vec3 Axis;
+	uint Child;
+	uint IsLeaf;
+	uint Parent;
+	uint Reserved0;
+	uint Reserved1;
 };
 
 struct NodeProxy
@@ -1,13 +1,86 @@
 #extension GL_EXT_ray_query : require
 #extension GL_EXT_nonuniform_qualifier : require
 
-#define USE_FIREFLY_FILTER 1
 #include "Vertex.glsl"
 #include "Random.glsl"
 #include "common/equirectangularSample.glsl"
 #include "Scatter.glsl"
 #include "RTSimple.glsl"
 
+// what the lights below a node can add at position, mirrors Assets::LightSampler::Importance
+float LightTreeImportance(const LightTreeNode node, const vec3 position, const vec3 normal)
+{
+	const vec3 center = (node.BoundsMin.xyz + node.BoundsMax.xyz) * 0.5;
+	const float radius = length(node.BoundsMax.xyz - node.BoundsMin.xyz) * 0.5;
+	const vec3 toReceiver = position - center;
+	const float distanceSquared = dot(toReceiver, toReceiver);
+	const vec3 direction = distanceSquared > 0 ? toReceiver * inversesqrt(distanceSquared) : normal;
+	const float bounds = distanceSquared > radius * radius ? asin(radius * inversesqrt(distanceSquared)) : M_PI;
+
+	const float emitterAngle = max(0.0, acos(clamp(dot(node.Axis, direction), -1.0, 1.0)) - node.BoundsMax.w - bounds);
+	const float receiverAngle = max(0.0, acos(clamp(dot(normal, -direction), -1.0, 1.0)) - bounds);
+	if (emitterAngle >= M_PI_2 || receiverAngle >= M_PI_2)
+	{
+		return 0;
+	}
+	return node.BoundsMin.w * cos(emitterAngle) * cos(receiverAngle) / max(distanceSquared, radius * radius);
+}
+
+// descends the light bvh picking a child by importance and reusing the rest of u below it
+uint SampleLightTree(const float random, const vec3 position, const vec3 normal, out float pdf)
+{
+	float u = random;
+	uint index = 0;
+	pdf = 1;
+	while (LightTree[index].IsLeaf == 0)
+	{
+		const uint child = LightTree[index].Child;
+		const float left = LightTreeImportance(LightTree[child], position, normal);
+		const float right = LightTreeImportance(LightTree[child + 1], position, normal);
+		if (left + right <= 0)
+		{
+			pdf = 0;
+			return 0;
+		}
+
+		const float probability = left / (left + right);
+		if (u < probability)
+		{
+			u = min(u / probability, 0.99999);
+			pdf *= probability;
+			index = child;
+		}
+		else
+		{
+			u = min((u - probability) / (1 - probability), 0.99999);
+			pdf *= 1 - probability;
+			index = child + 1;
+		}
+	}
+	return LightTree[index].Child;
+}
+
+// pdf is the probability of the returned light, 0 when none can be picked. Camera.UseLightTree picks by what a light
+// adds at position, otherwise by power alone from the scene's alias table
+uint SampleLight(inout uvec4 seed, const vec3 position, const vec3 normal, out float pdf)
+{
+	if (Camera.LightCount == 0)
+	{
+		pdf = 0;
+		return 0;
+	}
+	if (Camera.UseLightTree)
+	{
+		return SampleLightTree(RandomFloat(seed), position, normal, pdf);
+	}
+	const float u = RandomFloat(seed) * Camera.LightCount;
+	const uint slot = min(uint(u), Camera.LightCount - 1);
+	const LightAlias entry = LightAliases[slot];
+	const uint light = u - slot < entry.Probability ? slot : entry.Alias;
+	pdf = LightAliases[light].Pdf;
+	return light;
+}
+
 void ProcessHit(const int InstCustIndex, const vec3 RayDirection, const float RayDist, const mat4x3 WorldToObject, const vec2 TwoBaryCoords, const vec3 HitPos, const int PrimitiveIndex, const int InstanceID)
 {
     // Get the material.
@@ -37,13 +110,14 @@ void ProcessHit(const int InstCustIndex, const vec3 RayDirection, const float Ra
 
 	mat3 TBN = mat3(tangent, bitangent, normal);
 
-	int lightIdx = int(floor(RandomFloat(Ray.RandomSeed) * .99999 * Camera.LightCount));
+	float lightPdf;
+	const uint lightIdx = SampleLight(Ray.RandomSeed, HitPos, dot(normal, RayDirection) < 0 ? normal : -normal, lightPdf);
 	Ray.HitPos = HitPos;
 
 	Ray.primitiveId = (InstanceID + 1) << 16 | v0.MaterialIndex;
 	Ray.BounceCount++;
 	Ray.Exit = false;
-	Scatter(Ray, material, Lights[lightIdx], RayDirection, TBN, texCoord, RayDist, v0.MaterialIndex);
+	Scatter(Ray, material, Lights[lightIdx], lightPdf, RayDirection, TBN, texCoord, RayDist, v0.MaterialIndex);
 }
 
 void ProcessMiss(const vec3 RayDirection)
@@ -54,18 +128,19 @@ void ProcessMiss(const vec3 RayDirection)
 	Ray.Exit = true;
 	Ray.Distance = 1000.0;
 	Ray.pdf = 1.0;
+	Ray.Attenuation = vec3(1);
+	Ray.EmitColor = vec4(0, 0, 0, -1);
 	if (Camera.HasSky)
 	{
 		// Sky color
-		const vec3 skyColor = equirectangularSample(RayDirection, Camera.SkyRotation).rgb * Camera.SkyIntensity;
-        Ray.Attenuation = vec3(1);
-		Ray.EmitColor = vec4(skyColor, -1);
+		Ray.EmitColor.rgb = equirectangularSample(RayDirection, Camera.SkyRotation).rgb * Camera.SkyIntensity;
 	}
-	else
+	if (Ray.SunVisible && dot(RayDirection, Camera.SunDirection.xyz) >= cos_0_5degree)
 	{
-		Ray.Attenuation = vec3(0);
-		Ray.EmitColor = vec4(0);
+		// the radiance of the sun's disc, only seen by bounces that counted it in their pdf
+		Ray.EmitColor.rgb += Camera.SunColor.rgb * (M_PI / SUN_SOLID_ANGLE);
 	}
+	Ray.SunVisible = false;
 }
 
 #ifdef RT_PIPELINE
@@ -108,6 +183,7 @@ void traceRay(in vec3 origin, in vec3 scatterDir)
 
 bool GetRayColor(inout vec3 origin, inout vec3 scatterDir, inout vec3 outRayColor)
 {
+    RayStatsTrace(Ray.BounceCount == 0);
     traceRay(origin, scatterDir);
     // out of limit, invalid sample, return
     if(Ray.BounceCount == Camera.NumberOfBounces)
@@ -120,15 +196,42 @@ bool GetRayColor(inout vec3 origin, inout vec3 scatterDir, inout vec3 outRayColo
     if(!Ray.HitRefract) origin -= scatterDir * EPS2;
     scatterDir = Ray.ScatterDirection;
 
+#ifdef RADIANCE_CACHE_BINDING
+    // a lambertian hit past the first bounces may end the path with the radiance its cell has seen leaving it
+    if(Camera.RadianceCacheBounce > 0 && RadianceCacheBound() && !Ray.Exit && Materials[Ray.MaterialIndex].MaterialModel == MaterialLambertian)
+    {
+        const vec3 normal = Ray.FrontFace ? Ray.GBuffer.xyz : -Ray.GBuffer.xyz;
+        if(RadianceCacheVisit(Ray.HitPos, normal, Camera.ModelViewInverse[3].xyz, Ray.BounceCount > Camera.RadianceCacheBounce, outRayColor))
+        {
+            return true;
+        }
+    }
+#endif
+
     outRayColor *= Ray.Exit ? Ray.EmitColor.rgb : Ray.Attenuation * Ray.pdf;
     
-#if USE_FIREFLY_FILTER
-  float lum = luminance(outRayColor);
-  if(lum > 1000.0F)
-  {
-    outRayColor *= 1000.0F / lum;
-  }
-#endif
+    // optional safety net, biased but hides the fireflies of paths no strategy samples well
+    if(Camera.FireflyClamp)
+    {
+        float lum = luminance(outRayColor);
+        if(lum > 1000.0F)
+        {
+            outRayColor *= 1000.0F / lum;
+        }
+    }
+
+    // russian roulette past the minimum depth on the path's throughput, survivors carry the weight of the ended ones
+    if(!Ray.Exit && Ray.BounceCount >= Camera.RussianRouletteDepth)
+    {
+        const float survive = clamp(max(outRayColor.r, max(outRayColor.g, outRayColor.b)), 0.05, 1.0);
+        if(RandomFloat(Ray.RandomSeed) >= survive)
+        {
+            outRayColor = vec3(0);
+            RayStatsRoulette();
+            return true;
+        }
+        outRayColor /= survive;
+    }
 
     return Ray.Exit;
 }
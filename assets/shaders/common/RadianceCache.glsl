@@ -0,0 +1,187 @@
+#ifndef radiancecache_inc
+#define radiancecache_inc
+
+// World space radiance cache of the diffuse hits, mirrors Assets::RadianceCache. A cell is keyed by its position, its
+// level and the dominant axis of the normal, it lives in one slot of the bucket its hash lands on and is told apart from
+// the other cells of the bucket by a second hash. Paths add the radiance they found leaving their hits to Accumulated,
+// RadianceCacheResolve.comp blends the frame's mean into Radiance and evicts the cells nobody updated for a while.
+struct RadianceCacheEntry
+{
+	uint Key;           // checksum of the cell, 0 for a free slot
+	uint Age;           // resolves since the last update
+	uint SampleCount;   // samples blended into Radiance, saturates at RADIANCE_CACHE_MAX_SAMPLES
+	uint Reserved;
+	vec4 Radiance;
+	uvec4 Accumulated;  // this frame's radiance in fixed point and its sample count in w
+};
+
+// the including shader picks the binding
+layout(binding = RADIANCE_CACHE_BINDING) buffer RadianceCacheArray { RadianceCacheEntry RadianceCache[]; };
+
+// the renderer binds a one entry placeholder until the cache is turned on, the frame that turns it on may still see it
+bool RadianceCacheBound()
+{
+	return RadianceCache.length() >= RADIANCE_CACHE_SIZE;
+}
+
+// Wellons' lowbias32
+uint RadianceCacheHash(uint x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+// the bucket hash in x and the checksum in y, which is never 0
+uvec2 RadianceCacheKey(vec3 position, vec3 normal, vec3 camera)
+{
+	const float distanceToCamera = length(position - camera);
+	const uint level = uint(clamp(floor(log2(max(distanceToCamera, 1e-6) / RADIANCE_CACHE_LEVEL_DISTANCE)) + 1.0, 0.0, 15.0));
+	const ivec3 cell = ivec3(floor(position / (RADIANCE_CACHE_CELL_SIZE * exp2(float(level)))));
+
+	const vec3 axis = abs(normal);
+	const uint dominant = axis.x >= axis.y && axis.x >= axis.z ? 0u : (axis.y >= axis.z ? 1u : 2u);
+	const uint facing = dominant * 2u + (normal[dominant] < 0.0 ? 1u : 0u);
+	const uint lod = level << 3 | facing;
+
+	const uint bucket = RadianceCacheHash(uint(cell.x) ^ RadianceCacheHash(uint(cell.y) ^ RadianceCacheHash(uint(cell.z) ^ RadianceCacheHash(lod))));
+	const uint checksum = RadianceCacheHash(uint(cell.z) * 0x9e3779b9u ^ RadianceCacheHash(uint(cell.x) ^ RadianceCacheHash(uint(cell.y) + lod * 0x85ebca6bu)));
+	return uvec2(bucket, max(checksum, 1u));
+}
+
+// the slot of the cell, RADIANCE_CACHE_SIZE when it is not cached
+uint RadianceCacheFind(uvec2 key)
+{
+	const uint bucket = (key.x % RADIANCE_CACHE_SIZE) & ~(RADIANCE_CACHE_PROBES - 1u);
+	for (uint i = 0; i < RADIANCE_CACHE_PROBES; ++i)
+	{
+		if (RadianceCache[bucket + i].Key == key.y)
+		{
+			return bucket + i;
+		}
+	}
+	return RADIANCE_CACHE_SIZE;
+}
+
+// the slot of the cell, taking the first free one of its bucket when it is not cached yet. RADIANCE_CACHE_SIZE when
+// the bucket is full, evictions leave holes, so looking the cell up first keeps it from being inserted twice
+uint RadianceCacheInsert(uvec2 key)
+{
+	const uint found = RadianceCacheFind(key);
+	if (found < RADIANCE_CACHE_SIZE)
+	{
+		return found;
+	}
+
+	const uint bucket = (key.x % RADIANCE_CACHE_SIZE) & ~(RADIANCE_CACHE_PROBES - 1u);
+	for (uint i = 0; i < RADIANCE_CACHE_PROBES; ++i)
+	{
+		const uint stored = atomicCompSwap(RadianceCache[bucket + i].Key, 0u, key.y);
+		if (stored == 0u || stored == key.y)
+		{
+			return bucket + i;
+		}
+	}
+	return RADIANCE_CACHE_SIZE;
+}
+
+void RadianceCacheAccumulate(uint slot, vec3 radiance)
+{
+	const uvec3 value = uvec3(clamp(radiance, vec3(0.0), vec3(RADIANCE_CACHE_MAX_RADIANCE)) * RADIANCE_CACHE_FIXED_POINT + 0.5);
+	atomicAdd(RadianceCache[slot].Accumulated.x, value.x);
+	atomicAdd(RadianceCache[slot].Accumulated.y, value.y);
+	atomicAdd(RadianceCache[slot].Accumulated.z, value.z);
+	atomicAdd(RadianceCache[slot].Accumulated.w, 1u);
+}
+
+// blends the frame's samples into the cell, the history weighs up to RADIANCE_CACHE_MAX_SAMPLES so the cell follows
+// changes of the lighting, then ages or evicts the cells that got none
+void RadianceCacheResolve(uint slot)
+{
+	const RadianceCacheEntry entry = RadianceCache[slot];
+	if (entry.Key == 0u)
+	{
+		return;
+	}
+
+	if (entry.Accumulated.w == 0u)
+	{
+		if (entry.Age + 1u > RADIANCE_CACHE_MAX_AGE)
+		{
+			RadianceCache[slot] = RadianceCacheEntry(0u, 0u, 0u, 0u, vec4(0.0), uvec4(0u));
+		}
+		else
+		{
+			RadianceCache[slot].Age = entry.Age + 1u;
+		}
+		return;
+	}
+
+	const float samples = float(entry.Accumulated.w);
+	const vec3 mean = vec3(entry.Accumulated.xyz) / (float(RADIANCE_CACHE_FIXED_POINT) * samples);
+	const uint count = min(entry.SampleCount + entry.Accumulated.w, uint(RADIANCE_CACHE_MAX_SAMPLES));
+	RadianceCache[slot].Radiance = vec4(mix(entry.Radiance.rgb, mean, min(samples / float(count), 1.0)), 0.0);
+	RadianceCache[slot].SampleCount = count;
+	RadianceCache[slot].Age = 0u;
+	RadianceCache[slot].Accumulated = uvec4(0u);
+}
+
+// the diffuse hits of the path being traced, their slots and the path's throughput in front of them
+uint CachePathSlots[RADIANCE_CACHE_PATH_VERTICES];
+vec3 CachePathThroughput[RADIANCE_CACHE_PATH_VERTICES];
+uint CachePathLength = 0u;
+bool CachePathUpdateOnly = false;
+
+void RadianceCacheBeginPath(uvec2 pixel, uint sampleIndex)
+{
+	CachePathLength = 0u;
+	CachePathUpdateOnly = RadianceCacheHash(pixel.x ^ RadianceCacheHash(pixel.y ^ RadianceCacheHash(sampleIndex))) % RADIANCE_CACHE_UPDATE_PATHS == 0;
+}
+
+// at a diffuse hit with the path's throughput in front of it. When query is set and the cell has seen enough samples
+// the path ends with the radiance leaving it and true is returned, otherwise the hit is recorded for the update
+bool RadianceCacheVisit(vec3 position, vec3 normal, vec3 camera, bool query, inout vec3 throughput)
+{
+	const uvec2 key = RadianceCacheKey(position, normal, camera);
+	if (query && !CachePathUpdateOnly)
+	{
+		const uint slot = RadianceCacheFind(key);
+		if (slot < RADIANCE_CACHE_SIZE && RadianceCache[slot].SampleCount >= RADIANCE_CACHE_MIN_SAMPLES)
+		{
+			throughput *= RadianceCache[slot].Radiance.rgb;
+			return true;
+		}
+	}
+
+	if (CachePathLength < RADIANCE_CACHE_PATH_VERTICES)
+	{
+		const uint slot = RadianceCacheInsert(key);
+		if (slot < RADIANCE_CACHE_SIZE)
+		{
+			CachePathSlots[CachePathLength] = slot;
+			CachePathThroughput[CachePathLength] = throughput;
+			CachePathLength++;
+		}
+	}
+	return false;
+}
+
+// the path's color over the throughput in front of a recorded hit is the radiance that left it. A channel the
+// throughput has all but lost says nothing about that radiance, so those hits are skipped
+void RadianceCacheEndPath(vec3 color)
+{
+	for (uint i = 0; i < CachePathLength; ++i)
+	{
+		const vec3 throughput = CachePathThroughput[i];
+		if (min(throughput.r, min(throughput.g, throughput.b)) > 1e-4)
+		{
+			RadianceCacheAccumulate(CachePathSlots[i], color / throughput);
+		}
+	}
+	CachePathLength = 0u;
+}
+
+#endif
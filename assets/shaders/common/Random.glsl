@@ -16,6 +16,60 @@ void pcg4d(inout uvec4 v)
 // Returns a float between 0 and 1
 #define uint_to_float(x) ( uintBitsToFloat(0x3f800000 | ((x) >> 9)) - 1.0f )
 
+#ifdef SAMPLER_BINDING
+// The owen scrambled sobol sampler of Assets::SobolSampler, the including shader picks the binding. While SobolSeeds is
+// set RandomFloat draws the next dimension of a seed from InitSobolSeed instead of hashing it: x is the ranked sample
+// index, y the next dimension and z the seed of the pixel's tile
+layout(binding = SAMPLER_BINDING) readonly buffer SamplerTableArray { uint SamplerTables[]; };
+bool SobolSeeds = false;
+
+uint SamplerHash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+uint NestedUniformScramble(uint x, uint seed)
+{
+    x = bitfieldReverse(x);
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return bitfieldReverse(x);
+}
+
+uint Sobol(uint index, const uint dimension)
+{
+    uint result = 0;
+    for (uint bit = dimension * 32; index != 0; ++bit, index >>= 1)
+    {
+        if ((index & 1u) != 0) result ^= SamplerTables[bit];
+    }
+    return result;
+}
+
+uvec4 InitSobolSeed(const uvec2 pixel, const uint sampleIndex, const uint dimension)
+{
+    const uint rank = SamplerTables[SAMPLER_DIMENSIONS * 32 + (pixel.y % SAMPLER_RANK_TILE) * SAMPLER_RANK_TILE + pixel.x % SAMPLER_RANK_TILE];
+    const uint tile = SamplerHash(pixel.x / SAMPLER_RANK_TILE ^ SamplerHash(pixel.y / SAMPLER_RANK_TILE));
+    return uvec4(sampleIndex ^ rank, dimension, tile, 0);
+}
+
+float SobolFloat(inout uvec4 v)
+{
+    const uint dimension = v.y++;
+    const uint group = SamplerHash(v.z ^ SamplerHash(dimension / SAMPLER_DIMENSIONS));
+    const uint component = dimension % SAMPLER_DIMENSIONS;
+    return uint_to_float(NestedUniformScramble(Sobol(NestedUniformScramble(v.x, group), component), SamplerHash(group + component + 1)));
+}
+#endif
+
 uvec4 InitRandomSeed(uint val0, uint val1, uint frame_num)
 {
 	return uvec4(val0, val1, frame_num, 0);
@@ -23,12 +77,24 @@ uvec4 InitRandomSeed(uint val0, uint val1, uint frame_num)
 
 float RandomFloat(inout uvec4 v)
 {
+#ifdef SAMPLER_BINDING
+	if (SobolSeeds) return SobolFloat(v);
+#endif
 	pcg4d(v);
 	return uint_to_float(v.x);
 }
 
 vec2 RandomFloat2(inout uvec4 v)
 {
+#ifdef SAMPLER_BINDING
+	if (SobolSeeds)
+	{
+		// both from one padded point, so the pair is stratified in 2d
+		v.y = (v.y + SAMPLER_DIMENSIONS - 1) / SAMPLER_DIMENSIONS * SAMPLER_DIMENSIONS;
+		const float x = SobolFloat(v);
+		return vec2(x, SobolFloat(v));
+	}
+#endif
 	pcg4d(v);
 	return uint_to_float(v.xy);
 }
@@ -20,6 +20,7 @@ struct RayPayload
 	uint MaterialIndex;
 	vec3 HitPos;
 	uint AdaptiveSample;
+	bool SunVisible; // the last bounce had the sun in its mixture, a miss inside its disc picks up its radiance
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+#define RAY_STATS_BOUNCE_BINS 16
+
+// Per frame ray counters, cleared before the frame and read back once its fence signaled. Only written when
+// UniformBufferObject.CollectRayStats is set. A path ends early when it escapes or hits an emitter before the bounce limit,
+// roulette terminations are the paths russian roulette ended instead.
+struct RayStatistics
+{
+	uint PrimaryRays;
+	uint BounceRays;
+	uint ShadowRays;
+	uint Paths;
+	uint EarlyTerminations;
+	uint AdaptiveSamples;
+	uint RouletteTerminations;
+	uint Reserved1;
+	// paths by the number of surfaces they hit, the last bin also holds the deeper ones
+	uint BounceHistogram[RAY_STATS_BOUNCE_BINS];
+};
+
+#ifndef __cplusplus
+#extension GL_KHR_shader_subgroup_basic : require
+#extension GL_KHR_shader_subgroup_arithmetic : require
+
+// the including shader picks the binding
+layout(binding = RAY_STATS_BINDING) buffer RayStatisticsBuffer { RayStatistics RayStats; };
+
+// counted per invocation and flushed once through a subgroup sum, so the atomics do not distort the ray rate much.
+// the histogram packs 16 byte wide bins into a uvec4, a pixel never ends more than 255 paths in a frame
+uint rsPrimaryRays = 0;
+uint rsBounceRays = 0;
+uint rsShadowRays = 0;
+uint rsPaths = 0;
+uint rsEarlyTerminations = 0;
+uint rsAdaptiveSamples = 0;
+uint rsRouletteTerminations = 0;
+uvec4 rsHistogram = uvec4(0);
+
+void RayStatsTrace(bool primary)
+{
+	if (primary) rsPrimaryRays++; else rsBounceRays++;
+}
+
+void RayStatsShadow()
+{
+	rsShadowRays++;
+}
+
+void RayStatsPathEnd(uint depth, bool early)
+{
+	const uint bin = min(depth, RAY_STATS_BOUNCE_BINS - 1u);
+	rsHistogram[bin >> 2] += 1u << ((bin & 3u) * 8u);
+	rsPaths++;
+	if (early) rsEarlyTerminations++;
+}
+
+void RayStatsRoulette()
+{
+	rsRouletteTerminations++;
+}
+
+void RayStatsSamples(uint samples)
+{
+	rsAdaptiveSamples += samples;
+}
+
+// call once at the end of main, under the CollectRayStats check
+void RayStatsFlush()
+{
+	const uint primary = subgroupAdd(rsPrimaryRays);
+	const uint bounce = subgroupAdd(rsBounceRays);
+	const uint shadow = subgroupAdd(rsShadowRays);
+	const uint paths = subgroupAdd(rsPaths);
+	const uint early = subgroupAdd(rsEarlyTerminations);
+	const uint samples = subgroupAdd(rsAdaptiveSamples);
+	const uint roulette = subgroupAdd(rsRouletteTerminations);
+	if (subgroupElect())
+	{
+		atomicAdd(RayStats.PrimaryRays, primary);
+		atomicAdd(RayStats.BounceRays, bounce);
+		atomicAdd(RayStats.ShadowRays, shadow);
+		atomicAdd(RayStats.Paths, paths);
+		atomicAdd(RayStats.EarlyTerminations, early);
+		atomicAdd(RayStats.AdaptiveSamples, samples);
+		atomicAdd(RayStats.RouletteTerminations, roulette);
+	}
+
+	// unpacked before the sum, a whole subgroup overflows a byte
+	for (uint i = 0; i < RAY_STATS_BOUNCE_BINS; ++i)
+	{
+		const uint count = subgroupAdd((rsHistogram[i >> 2] >> ((i & 3u) * 8u)) & 0xffu);
+		if (count > 0 && subgroupElect())
+		{
+			atomicAdd(RayStats.BounceHistogram[i], count);
+		}
+	}
+}
+#endif
@@ -5,6 +5,7 @@
 #include "common/Const_Func.glsl"
 #include "common/ColorFunc.glsl"
 #include "common/GGXSample.glsl"
+#include "common/EnvironmentSampling.glsl"
 
 #ifndef scatter_inc
 #define scatter_inc
@@ -26,54 +27,92 @@ void ScatterDiffuseLight(inout RayPayload ray, const Material m, const LightObje
 	}
 }
 
-void ScatterLambertian(inout RayPayload ray, const Material m, const LightObject light, const vec3 direction, const mat3 TBN, const vec2 texCoord)
+// solid angle of the sun's disc, its radiance is spread over it so a lit lambertian gets SunColor * albedo * ndotl
+#define SUN_SOLID_ANGLE (M_TWO_PI * (1 - cos_0_5degree))
+
+// solid angle pdf of direction when a uniform point of light is picked from origin, 0 when the ray misses it
+float LightDirectionPdf(const LightObject light, const vec3 origin, const vec3 direction)
 {
-	ray.Attenuation = ray.Albedo.rgb;
-	ray.ScatterDirection = AlignWithNormal( RandomInHemiSphere1(ray.RandomSeed), TBN);
-	ray.pdf = 1.0;
-	ray.EmitColor = vec4(0);
+	const vec3 e1 = light.p1.xyz - light.p0.xyz;
+	const vec3 e2 = light.p3.xyz - light.p0.xyz;
+	const vec3 perp = cross(e1, e2);
+	const float cosine = dot(direction, perp);
+	if (cosine == 0)
+	{
+		return 0;
+	}
 
-	// Global Sun Check
-	if(Camera.HasSun)
-	{
-		const vec3 hitpos = ray.HitPos;
-		const vec3 lightVector = AlignWithNormal( RandomInCone(ray.RandomSeed, cos_0_5degree), Camera.SunDirection.xyz);
-		if(RandomFloat(ray.RandomSeed) < 0.33) {
-			rayQueryEXT rayQuery;
-			rayQueryInitializeEXT(rayQuery, Scene, gl_RayFlagsNoneEXT, 0xFF, hitpos, EPS, lightVector, INF);
-			rayQueryProceedEXT(rayQuery);
-			if (rayQueryGetIntersectionTypeEXT(rayQuery, true) == gl_RayQueryCommittedIntersectionNoneEXT  ) {
-				// sun
-				float ndotl = clamp(dot(lightVector, TBN[2]), 0, 1);
-				ray.Exit = true;
-				ray.EmitColor = vec4(Camera.SunColor.xyz * ray.Albedo.rgb, 1.0) * ndotl;
-			}
-			return;
-		}
+	const float t = dot(light.p0.xyz - origin, perp) / cosine;
+	if (t <= 0)
+	{
+		return 0;
 	}
-	
-	if( light.normal_area.w > 0 && RandomFloat(ray.RandomSeed) < 0.5 )
+
+	const vec3 offset = origin + direction * t - light.p0.xyz;
+	const float area2 = dot(perp, perp);
+	const float u = dot(cross(offset, e2), perp) / area2;
+	const float v = dot(cross(e1, offset), perp) / area2;
+	if (u < 0 || v < 0 || u > 1 || v > 1 || (light.Triangle != 0 && u + v > 1))
 	{
-		// scatter to light
-		vec3 lightpos = light.p0.xyz + (light.p1.xyz - light.p0.xyz) * RandomFloat(ray.RandomSeed) + (light.p3.xyz - light.p0.xyz) *  RandomFloat(ray.RandomSeed);
-		vec3 worldPos = ray.HitPos;
-		vec3 tolight = lightpos - worldPos;
+		return 0;
+	}
+
+	// |perp| is the parallelogram's area and cancels against the cosine at the light, a triangle is half of it
+	return t * t / abs(cosine) * (light.Triangle != 0 ? 2.0 : 1.0);
+}
+
+// One sample of the mixture of the cosine lobe, the picked light, the sky's table and the sun, each strategy taken
+// with the same probability and weighted by the balance heuristic. The lights were picked before and only decide
+// which one joins the mixture, so their pdf does not enter the weight.
+void ScatterLambertian(inout RayPayload ray, const Material m, const LightObject light, const float lightPdf, const vec3 direction, const mat3 TBN, const vec2 texCoord)
+{
+	ray.Attenuation = ray.Albedo.rgb;
+	ray.EmitColor = vec4(0);
+	ray.SunVisible = Camera.HasSun;
 
-		float ndotl = dot(tolight, TBN[2]);
-		
-		if(ndotl >= 0)
-		{
-			float dist = length(tolight);
-			tolight /= dist;
+	// the power or tree selection only picks which light joins the mixture. The estimate is unbiased given that light,
+	// so its selection pdf stays out of the weight on purpose, it only rules out lights that could not be picked
+	const bool useLight = light.normal_area.w > 0 && lightPdf > 0;
+	const bool useSky = Camera.HasSky && Camera.HasSkyTable;
+	const bool useSun = Camera.HasSun;
+	const uint strategies = 1 + uint(useLight) + uint(useSky) + uint(useSun);
 
-			const float epsVariance = .01;
-			float cosine = max(dot(light.normal_area.xyz, -tolight), epsVariance);
-			float light_pdf = dist * dist / (cosine * light.normal_area.w);
+	// 0 lobe, 1 light, 2 sky, 3 sun, the disabled ones are skipped
+	uint strategy = min(uint(RandomFloat(ray.RandomSeed) * strategies), strategies - 1);
+	if (strategy >= 1 && !useLight) strategy++;
+	if (strategy >= 2 && !useSky) strategy++;
 
-			ray.ScatterDirection = tolight;
-			ray.pdf = M_1_PI / light_pdf;
-		}
+	if (strategy == 1)
+	{
+		// a point of the far half of the parallelogram is mirrored into the triangle
+		vec2 uv = vec2(RandomFloat(ray.RandomSeed), RandomFloat(ray.RandomSeed));
+		if (light.Triangle != 0 && uv.x + uv.y > 1) uv = 1 - uv;
+		const vec3 lightpos = light.p0.xyz + (light.p1.xyz - light.p0.xyz) * uv.x + (light.p3.xyz - light.p0.xyz) * uv.y;
+		const vec3 tolight = lightpos - ray.HitPos;
+		ray.ScatterDirection = dot(tolight, tolight) > 0 ? normalize(tolight) : TBN[2];
 	}
+	else if (strategy == 2)
+	{
+		float skyPdf;
+		ray.ScatterDirection = SampleEnvironment(ray.RandomSeed, skyPdf);
+	}
+	else if (strategy == 3)
+	{
+		ray.ScatterDirection = AlignWithNormal(RandomInCone(ray.RandomSeed, cos_0_5degree), Camera.SunDirection.xyz);
+	}
+	else
+	{
+		ray.ScatterDirection = AlignWithNormal(RandomInHemiSphere1(ray.RandomSeed), TBN);
+	}
+
+	const float lobePdf = max(dot(ray.ScatterDirection, TBN[2]), 0) * M_1_PI;
+	float mixturePdf = lobePdf;
+	if (useLight) mixturePdf += LightDirectionPdf(light, ray.HitPos, ray.ScatterDirection);
+	if (useSky) mixturePdf += EnvironmentPdf(ray.ScatterDirection);
+	if (useSun && dot(ray.ScatterDirection, Camera.SunDirection.xyz) >= cos_0_5degree) mixturePdf += 1.0 / SUN_SOLID_ANGLE;
+	mixturePdf /= strategies;
+
+	ray.pdf = mixturePdf > 0 ? lobePdf / mixturePdf : 0;
 }
 
 void ScatterDieletricOpaque(inout RayPayload ray, const Material m, const LightObject light, const vec3 direction, const mat3 TBN, const vec2 texCoord)
@@ -129,7 +168,7 @@ void ScatterDieletric(inout RayPayload ray, const Material m, const LightObject
 }
 
 // Mixture
-void ScatterMixture(inout RayPayload ray, const Material m, const LightObject light, const vec3 direction, const mat3 TBN, const vec2 texCoord)
+void ScatterMixture(inout RayPayload ray, const Material m, const LightObject light, const float lightPdf, const vec3 direction, const mat3 TBN, const vec2 texCoord)
 {
 	const float reflectProb = Schlick(ray.FrontFace ? -dot(direction, TBN[2]) : m.RefractionIndex * dot(direction, TBN[2]), m.RefractionIndex);
 	
@@ -143,11 +182,11 @@ void ScatterMixture(inout RayPayload ray, const Material m, const LightObject li
 	}
 	else
 	{
-		ScatterLambertian(ray, m, light, direction, TBN, texCoord);
+		ScatterLambertian(ray, m, light, lightPdf, direction, TBN, texCoord);
 	}
 }
 
-void Scatter(inout RayPayload ray, const Material m, const LightObject light, const vec3 direction, inout mat3 TBN, const vec2 texCoord, const float t, uint MaterialIndex)
+void Scatter(inout RayPayload ray, const Material m, const LightObject light, const float lightPdf, const vec3 direction, inout mat3 TBN, const vec2 texCoord, const float t, uint MaterialIndex)
 {
 	const vec4 texColor = m.DiffuseTextureId >= 0 ? srgbToLinear(texture(TextureSamplers[nonuniformEXT(m.DiffuseTextureId)], texCoord)) : vec4(1);
 	const vec4 mra = m.MRATextureId >= 0 ? texture(TextureSamplers[nonuniformEXT(m.MRATextureId)], texCoord) : vec4(1);
@@ -165,11 +204,12 @@ void Scatter(inout RayPayload ray, const Material m, const LightObject light, co
 	ray.FrontFace = dot(direction, TBN[2]) < 0;
 	ray.MaterialIndex = MaterialIndex;
 	ray.HitRefract = false;
+	ray.SunVisible = false;
 
 	switch (m.MaterialModel)
 	{
 	case MaterialLambertian:
-		ScatterLambertian(ray, m, light, direction, TBN, texCoord);
+		ScatterLambertian(ray, m, light, lightPdf, direction, TBN, texCoord);
 		break;
 	case MaterialMetallic:
 		ScatterMetallic(ray, m, light, direction, TBN, texCoord);
@@ -181,10 +221,10 @@ void Scatter(inout RayPayload ray, const Material m, const LightObject light, co
 		ScatterDiffuseLight(ray, m, light, direction, TBN, texCoord);
 		break;
 	case MaterialMixture:
-		ScatterMixture(ray, m, light, direction, TBN, texCoord);
+		ScatterMixture(ray, m, light, lightPdf, direction, TBN, texCoord);
 	    break;
 	case MaterialIsotropic:
-	    ScatterLambertian(ray, m, light, direction, TBN, texCoord);
+	    ScatterLambertian(ray, m, light, lightPdf, direction, TBN, texCoord);
 	    break;
 	}
 }
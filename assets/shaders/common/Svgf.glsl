@@ -0,0 +1,25 @@
+// edge stopping of the spatiotemporal variance guided filter, after Schied et al. "Spatiotemporal Variance-Guided
+// Filtering". The normal image holds the shading normal in xyz and the primary hit distance in w.
+#define SVGF_SIGMA_DEPTH 1.0
+#define SVGF_SIGMA_NORMAL 128.0
+#define SVGF_SIGMA_LUMINANCE 4.0
+// frames of history before the temporal moments are trusted over a spatial estimate
+#define SVGF_MIN_HISTORY 4.0
+
+vec3 SvgfDemodulate(in vec3 color, in vec3 albedo)
+{
+    return color / (albedo + vec3(0.001));
+}
+
+vec3 SvgfRemodulate(in vec3 illumination, in vec3 albedo)
+{
+    return illumination * (albedo + vec3(0.001));
+}
+
+// the depth gradient scaled by the offset expects a plane through the center, so slanted surfaces are not cut apart
+float SvgfGeometryWeight(in vec4 center, in vec2 depthGradient, in vec4 normalDepth, in vec2 offset)
+{
+    const float wn = pow(max(0.0, dot(center.xyz, normalDepth.xyz)), SVGF_SIGMA_NORMAL);
+    const float wz = exp(-abs(center.w - normalDepth.w) / (SVGF_SIGMA_DEPTH * abs(dot(depthGradient, offset)) + 0.001));
+    return wn * wz;
+}
@@ -4,6 +4,50 @@
 #define glbool bool
 #endif
 
+// importance sampling tables of the hdri skies: cells per table and how many of the first textures get one
+#define ENVIRONMENT_TABLE_WIDTH 128
+#define ENVIRONMENT_TABLE_HEIGHT 64
+#define ENVIRONMENT_TABLE_SLOTS 16
+
+// what draws the path tracer's random numbers, and for the owen scrambled sobol sampler its padded dimensions per point
+// and the side of its blue noise ranking tile
+#define SAMPLER_RANDOM 0
+#define SAMPLER_SOBOL 1
+#define SAMPLER_DIMENSIONS 2
+#define SAMPLER_RANK_TILE 64
+
+// variance driven adaptive sampling: the pixels of a tile share one error estimate, which is stored as a fixed point
+// uint so the frame's total can be summed with atomics, and no pixel traces more than ADAPTIVE_MAX_SAMPLES in a frame
+#define ADAPTIVE_TILE_WIDTH 8
+#define ADAPTIVE_TILE_HEIGHT 4
+#define ADAPTIVE_ERROR_SCALE 1024
+#define ADAPTIVE_MAX_SAMPLES 16
+
+// the denoiser's filter, the joint bilateral one runs inside the final compose, the spatiotemporal variance guided one
+// in front of it with up to SVGF_MAX_ITERATIONS a-trous passes
+#define DENOISE_FILTER_BILATERAL 0
+#define DENOISE_FILTER_SVGF 1
+#define SVGF_MAX_ITERATIONS 5
+
+// world space radiance cache: RADIANCE_CACHE_SIZE cells in buckets of RADIANCE_CACHE_PROBES slots. A cell's side is
+// RADIANCE_CACHE_CELL_SIZE up to RADIANCE_CACHE_LEVEL_DISTANCE from the camera and doubles with every doubling of the
+// distance past it. Radiance sums are fixed point so paths can add them with atomics
+#define RADIANCE_CACHE_SIZE (1 << 18)
+#define RADIANCE_CACHE_PROBES 8
+#define RADIANCE_CACHE_CELL_SIZE 0.025
+#define RADIANCE_CACHE_LEVEL_DISTANCE 2.0
+#define RADIANCE_CACHE_FIXED_POINT 32
+#define RADIANCE_CACHE_MAX_RADIANCE 4096
+// cells answer queries from RADIANCE_CACHE_MIN_SAMPLES on, blend at most RADIANCE_CACHE_MAX_SAMPLES of history and are
+// evicted after RADIANCE_CACHE_MAX_AGE frames without an update. One path in RADIANCE_CACHE_UPDATE_PATHS never ends
+// in the cache so the cells it would end in keep getting fresh samples, every path records its first
+// RADIANCE_CACHE_PATH_VERTICES diffuse hits
+#define RADIANCE_CACHE_MIN_SAMPLES 16
+#define RADIANCE_CACHE_MAX_SAMPLES 1024
+#define RADIANCE_CACHE_MAX_AGE 32
+#define RADIANCE_CACHE_UPDATE_PATHS 8
+#define RADIANCE_CACHE_PATH_VERTICES 4
+
 struct UniformBufferObject
 {
 	mat4 ModelView;
@@ -31,6 +75,7 @@ struct UniformBufferObject
 	uint NumberOfSamples;
 	uint NumberOfBounces;
 	uint RandomSeed;
+	uint SampleOffset;	// passes rendered before TotalFrames 0, the samplers go on after them
 	uint LightCount;
 	glbool HasSky;
 	glbool ShowHeatmap;
@@ -39,8 +84,6 @@ struct UniformBufferObject
 	glbool HasSun;
 	glbool HDR;
 	glbool AdaptiveSample;
-	float AdaptiveVariance;
-	uint AdaptiveSteps;
 	glbool TAA;
 	uint SelectedId;
 	glbool ShowEdge;
@@ -49,4 +92,12 @@ struct UniformBufferObject
 	float BFSigmaLum;
 	float BFSigmaNormal;
 	uint BFSize;
+
+	glbool CollectRayStats;
+	glbool UseLightTree;
+	glbool HasSkyTable;
+	glbool FireflyClamp;
+	uint RussianRouletteDepth;
+	uint Sampler;
+	uint RadianceCacheBounce;
 };
@@ -1,6 +1,4 @@
 @echo off
 pushd bin
-for /L %%i in (0,1,2) do (
-	gkNextRenderer.exe --benchmark --next-scenes --renderer=%%i
-)
+gkNextRenderer.exe --matrix --matrix-renderers=0,1,2 %*
 popd
\ No newline at end of file
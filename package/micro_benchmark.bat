@@ -0,0 +1,4 @@
+@echo off
+pushd bin
+gkNextBenchmark.exe %*
+popd
\ No newline at end of file
@@ -0,0 +1,385 @@
+#include "LightSampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace Assets {
+
+namespace
+{
+	constexpr float Pi = 3.14159265358979f;
+
+	// power of every light, all equal when the scene has none at all
+	std::vector<double> Weights(const std::vector<LightObject>& lights, const std::vector<Material>& materials)
+	{
+		std::vector<double> weights(lights.size());
+		double total = 0;
+		for (size_t i = 0; i < lights.size(); ++i)
+		{
+			weights[i] = std::max(0.0, static_cast<double>(LightSampler::Power(lights[i], materials)));
+			total += weights[i];
+		}
+		if (total <= 0)
+		{
+			std::fill(weights.begin(), weights.end(), 1.0);
+		}
+		return weights;
+	}
+
+	// Vose's alias method over weights that are not all zero
+	std::vector<LightAlias> Alias(const std::vector<double>& weights)
+	{
+		const size_t count = weights.size();
+		std::vector<LightAlias> table(count);
+		if (count == 0)
+		{
+			return table;
+		}
+
+		const double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+
+		// scaled to a mean of 1, slots under it get topped up by one over it
+		std::vector<double> scaled(count);
+		std::vector<uint32_t> small;
+		std::vector<uint32_t> large;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			table[i].Pdf = static_cast<float>(weights[i] / total);
+			table[i].Alias = i;
+			scaled[i] = weights[i] / total * count;
+			(scaled[i] < 1.0 ? small : large).push_back(i);
+		}
+
+		while (!small.empty() && !large.empty())
+		{
+			const uint32_t less = small.back();
+			small.pop_back();
+			const uint32_t more = large.back();
+
+			table[less].Probability = static_cast<float>(scaled[less]);
+			table[less].Alias = more;
+
+			scaled[more] -= 1.0 - scaled[less];
+			if (scaled[more] < 1.0)
+			{
+				large.pop_back();
+				small.push_back(more);
+			}
+		}
+
+		// whatever is left is 1 up to rounding
+		for (uint32_t i : large) table[i].Probability = 1.0f;
+		for (uint32_t i : small) table[i].Probability = 1.0f;
+
+		return table;
+	}
+
+	struct Cone
+	{
+		glm::vec3 Axis;
+		float HalfAngle;
+	};
+
+	// smallest cone around both, after Conty Estevez and Kulla, "Importance Sampling of Many Lights with Adaptive Tree Splitting"
+	Cone Union(Cone a, Cone b)
+	{
+		if (a.HalfAngle < b.HalfAngle)
+		{
+			std::swap(a, b);
+		}
+
+		const float between = std::acos(glm::clamp(glm::dot(a.Axis, b.Axis), -1.0f, 1.0f));
+		if (std::min(between + b.HalfAngle, Pi) <= a.HalfAngle)
+		{
+			return a;
+		}
+
+		const float halfAngle = (a.HalfAngle + between + b.HalfAngle) * 0.5f;
+		if (halfAngle >= Pi)
+		{
+			return {a.Axis, Pi};
+		}
+
+		// turn a's axis towards b's by what the cone grew on a's side
+		const glm::vec3 ortho = b.Axis - a.Axis * glm::dot(a.Axis, b.Axis);
+		if (glm::dot(ortho, ortho) < 1e-12f)
+		{
+			return {a.Axis, halfAngle};
+		}
+		const float turn = halfAngle - a.HalfAngle;
+		return {glm::normalize(a.Axis * std::cos(turn) + glm::normalize(ortho) * std::sin(turn)), halfAngle};
+	}
+
+	void Grow(LightTreeNode& node, const LightTreeNode& other)
+	{
+		node.BoundsMin = glm::vec4(glm::min(glm::vec3(node.BoundsMin), glm::vec3(other.BoundsMin)), node.BoundsMin.w + other.BoundsMin.w);
+		const Cone cone = Union({node.Axis, node.BoundsMax.w}, {other.Axis, other.BoundsMax.w});
+		node.BoundsMax = glm::vec4(glm::max(glm::vec3(node.BoundsMax), glm::vec3(other.BoundsMax)), cone.HalfAngle);
+		node.Axis = cone.Axis;
+	}
+
+	// leaves of [begin, end) go below nodes[index], the children are appended in pairs
+	void Subdivide(std::vector<LightTreeNode>& nodes, const std::vector<LightTreeNode>& leaves, std::vector<uint32_t>& order, uint32_t index, size_t begin, size_t end)
+	{
+		if (end - begin == 1)
+		{
+			const uint32_t parent = nodes[index].Parent;
+			nodes[index] = leaves[order[begin]];
+			nodes[index].Parent = parent;
+			return;
+		}
+
+		glm::vec3 centroidMin(std::numeric_limits<float>::max());
+		glm::vec3 centroidMax(-std::numeric_limits<float>::max());
+		LightTreeNode node = leaves[order[begin]];
+		for (size_t i = begin; i < end; ++i)
+		{
+			const LightTreeNode& leaf = leaves[order[i]];
+			const glm::vec3 centroid = (glm::vec3(leaf.BoundsMin) + glm::vec3(leaf.BoundsMax)) * 0.5f;
+			centroidMin = glm::min(centroidMin, centroid);
+			centroidMax = glm::max(centroidMax, centroid);
+			if (i != begin) Grow(node, leaf);
+		}
+
+		const glm::vec3 extent = centroidMax - centroidMin;
+		const int axis = extent.x > extent.y && extent.x > extent.z ? 0 : extent.y > extent.z ? 1 : 2;
+		const size_t middle = begin + (end - begin) / 2;
+		std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [&leaves, axis](uint32_t a, uint32_t b)
+		{
+			return leaves[a].BoundsMin[axis] + leaves[a].BoundsMax[axis] < leaves[b].BoundsMin[axis] + leaves[b].BoundsMax[axis];
+		});
+
+		const uint32_t child = static_cast<uint32_t>(nodes.size());
+		node.Child = child;
+		node.IsLeaf = 0;
+		node.Parent = nodes[index].Parent;
+		nodes[index] = node;
+
+		nodes.resize(nodes.size() + 2);
+		nodes[child].Parent = index;
+		nodes[child + 1].Parent = index;
+		Subdivide(nodes, leaves, order, child, begin, middle);
+		Subdivide(nodes, leaves, order, child + 1, middle, end);
+	}
+}
+
+float LightSampler::Power(const LightObject& light, const std::vector<Material>& materials)
+{
+	const float area = light.normal_area.w;
+	if (light.MaterialIndex >= materials.size() || materials[light.MaterialIndex].MaterialModel != Material::Enum::DiffuseLight)
+	{
+		return area;
+	}
+
+	const glm::vec3 emission = glm::vec3(materials[light.MaterialIndex].Diffuse);
+	return area * glm::dot(emission, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+std::vector<LightAlias> LightSampler::BuildAliasTable(const std::vector<LightObject>& lights, const std::vector<Material>& materials)
+{
+	return Alias(Weights(lights, materials));
+}
+
+uint32_t LightSampler::Sample(const std::vector<LightAlias>& table, float u, float& pdf)
+{
+	const float scaled = u * table.size();
+	const uint32_t slot = std::min(static_cast<uint32_t>(scaled), static_cast<uint32_t>(table.size()) - 1);
+	const uint32_t light = scaled - slot < table[slot].Probability ? slot : table[slot].Alias;
+	pdf = table[light].Pdf;
+	return light;
+}
+
+std::vector<LightTreeNode> LightSampler::BuildTree(const std::vector<LightObject>& lights, const std::vector<Material>& materials)
+{
+	std::vector<LightTreeNode> nodes;
+	if (lights.empty())
+	{
+		return nodes;
+	}
+
+	const std::vector<double> weights = Weights(lights, materials);
+	std::vector<LightTreeNode> leaves(lights.size());
+	for (uint32_t i = 0; i < lights.size(); ++i)
+	{
+		// the quad spans p0 + (p1 - p0) * u + (p3 - p0) * v, a triangle only up to u + v = 1
+		const LightObject& light = lights[i];
+		const glm::vec3 p0(light.p0), p1(light.p1), p3(light.p3);
+		const glm::vec3 p2 = light.Triangle ? p0 : p1 + p3 - p0;
+
+		LightTreeNode& leaf = leaves[i];
+		leaf.BoundsMin = glm::vec4(glm::min(glm::min(p0, p1), glm::min(p2, p3)), static_cast<float>(weights[i]));
+		leaf.BoundsMax = glm::vec4(glm::max(glm::max(p0, p1), glm::max(p2, p3)), 0.0f);
+		leaf.Axis = glm::vec3(light.normal_area);
+		leaf.Child = i;
+		leaf.IsLeaf = 1;
+	}
+
+	std::vector<uint32_t> order(lights.size());
+	std::iota(order.begin(), order.end(), 0);
+
+	nodes.reserve(lights.size() * 2 - 1);
+	nodes.push_back({});
+	Subdivide(nodes, leaves, order, 0, 0, lights.size());
+	return nodes;
+}
+
+float LightSampler::Importance(const LightTreeNode& node, const glm::vec3& position, const glm::vec3& normal)
+{
+	const glm::vec3 center = (glm::vec3(node.BoundsMin) + glm::vec3(node.BoundsMax)) * 0.5f;
+	const float radius = glm::length(glm::vec3(node.BoundsMax) - glm::vec3(node.BoundsMin)) * 0.5f;
+	const glm::vec3 toReceiver = position - center;
+	const float distanceSquared = glm::dot(toReceiver, toReceiver);
+	const glm::vec3 direction = distanceSquared > 0 ? toReceiver / std::sqrt(distanceSquared) : normal;
+
+	// half angle the bounds cover seen from the receiver, all around once it is inside them
+	const float bounds = distanceSquared > radius * radius ? std::asin(radius / std::sqrt(distanceSquared)) : Pi;
+
+	// the emitting side faces the receiver for some light below, lambertian emitters reach 90 degrees off their normal
+	const float emitter = std::acos(glm::clamp(glm::dot(node.Axis, direction), -1.0f, 1.0f));
+	const float emitterAngle = std::max(0.0f, emitter - node.BoundsMax.w - bounds);
+	if (emitterAngle >= Pi * 0.5f)
+	{
+		return 0;
+	}
+
+	// and the receiver faces some point of the bounds
+	const float receiver = std::acos(glm::clamp(glm::dot(normal, -direction), -1.0f, 1.0f));
+	const float receiverAngle = std::max(0.0f, receiver - bounds);
+	if (receiverAngle >= Pi * 0.5f)
+	{
+		return 0;
+	}
+
+	return node.BoundsMin.w * std::cos(emitterAngle) * std::cos(receiverAngle) / std::max(distanceSquared, radius * radius);
+}
+
+uint32_t LightSampler::SampleTree(const std::vector<LightTreeNode>& tree, const glm::vec3& position, const glm::vec3& normal, float u, float& pdf)
+{
+	pdf = 0;
+	if (tree.empty())
+	{
+		return 0;
+	}
+
+	pdf = 1;
+	uint32_t index = 0;
+	while (!tree[index].IsLeaf)
+	{
+		const uint32_t child = tree[index].Child;
+		const float left = Importance(tree[child], position, normal);
+		const float right = Importance(tree[child + 1], position, normal);
+		if (left + right <= 0)
+		{
+			pdf = 0;
+			return 0;
+		}
+
+		const float probability = left / (left + right);
+		if (u < probability)
+		{
+			u = std::min(u / probability, 0.99999f);
+			pdf *= probability;
+			index = child;
+		}
+		else
+		{
+			u = std::min((u - probability) / (1 - probability), 0.99999f);
+			pdf *= 1 - probability;
+			index = child + 1;
+		}
+	}
+	return tree[index].Child;
+}
+
+float LightSampler::TreePdf(const std::vector<LightTreeNode>& tree, const glm::vec3& position, const glm::vec3& normal, uint32_t light)
+{
+	const auto leaf = std::find_if(tree.begin(), tree.end(), [light](const LightTreeNode& node) { return node.IsLeaf && node.Child == light; });
+	if (leaf == tree.end())
+	{
+		return 0;
+	}
+
+	float pdf = 1;
+	for (uint32_t index = static_cast<uint32_t>(leaf - tree.begin()); index != 0; index = tree[index].Parent)
+	{
+		const LightTreeNode& parent = tree[tree[index].Parent];
+		const uint32_t sibling = index == parent.Child ? parent.Child + 1 : parent.Child;
+		const float importance = Importance(tree[index], position, normal);
+		const float total = importance + Importance(tree[sibling], position, normal);
+		if (total <= 0)
+		{
+			return 0;
+		}
+		pdf *= importance / total;
+	}
+	return pdf;
+}
+
+std::vector<LightAlias> LightSampler::BuildEnvironmentTable(const float* rgba, int width, int height)
+{
+	constexpr int cellsX = ENVIRONMENT_TABLE_WIDTH;
+	constexpr int cellsY = ENVIRONMENT_TABLE_HEIGHT;
+
+	std::vector<double> luminance(cellsX * cellsY);
+	std::vector<uint32_t> texels(cellsX * cellsY);
+	for (int y = 0; y < height; ++y)
+	{
+		const int cellY = y * cellsY / height;
+		for (int x = 0; x < width; ++x)
+		{
+			// equirectangularSample clamps every channel at 10
+			const float* texel = rgba + (static_cast<size_t>(y) * width + x) * 4;
+			const glm::vec3 color = glm::min(glm::vec3(texel[0], texel[1], texel[2]), glm::vec3(10.0f));
+			const int cell = cellY * cellsX + x * cellsX / width;
+			luminance[cell] += std::max(0.0f, glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f)));
+			texels[cell]++;
+		}
+	}
+
+	std::vector<double> weights(cellsX * cellsY);
+	double total = 0;
+	for (int cell = 0; cell < cellsX * cellsY; ++cell)
+	{
+		const double theta = Pi * ((cell / cellsX) + 0.5) / cellsY;
+		weights[cell] = texels[cell] == 0 ? 0 : luminance[cell] / texels[cell] * std::sin(theta);
+		total += weights[cell];
+	}
+	if (total <= 0)
+	{
+		std::fill(weights.begin(), weights.end(), 1.0);
+	}
+	return Alias(weights);
+}
+
+glm::vec3 LightSampler::SampleEnvironment(const std::vector<LightAlias>& table, float rotation, const glm::vec3& u, float& pdf)
+{
+	float cellPdf;
+	const uint32_t cell = Sample(table, u.x, cellPdf);
+	const float theta = Pi * ((cell / ENVIRONMENT_TABLE_WIDTH) + u.z) / ENVIRONMENT_TABLE_HEIGHT;
+	const float phi = 2.0f * Pi * ((cell % ENVIRONMENT_TABLE_WIDTH) + u.y) / ENVIRONMENT_TABLE_WIDTH - Pi * rotation;
+	const float sinTheta = std::sin(theta);
+
+	// a uniform point of the cell, whose share of the sphere shrinks with sin theta
+	pdf = sinTheta > 0 ? cellPdf * ENVIRONMENT_TABLE_WIDTH * ENVIRONMENT_TABLE_HEIGHT / (2.0f * Pi * Pi * sinTheta) : 0;
+	return glm::vec3(sinTheta * std::sin(phi), std::cos(theta), sinTheta * std::cos(phi));
+}
+
+float LightSampler::EnvironmentPdf(const std::vector<LightAlias>& table, float rotation, const glm::vec3& direction)
+{
+	const glm::vec3 d = glm::normalize(direction);
+	const float sinTheta = std::sqrt(std::max(0.0f, 1.0f - d.y * d.y));
+	if (sinTheta <= 0)
+	{
+		return 0;
+	}
+
+	const float u = (std::atan2(d.x, d.z) + Pi * rotation) / (2.0f * Pi);
+	const float v = std::acos(glm::clamp(d.y, -1.0f, 1.0f)) / Pi;
+	const int x = std::min(static_cast<int>((u - std::floor(u)) * ENVIRONMENT_TABLE_WIDTH), ENVIRONMENT_TABLE_WIDTH - 1);
+	const int y = std::min(static_cast<int>(v * ENVIRONMENT_TABLE_HEIGHT), ENVIRONMENT_TABLE_HEIGHT - 1);
+	return table[y * ENVIRONMENT_TABLE_WIDTH + x].Pdf * ENVIRONMENT_TABLE_WIDTH * ENVIRONMENT_TABLE_HEIGHT / (2.0f * Pi * Pi * sinTheta);
+}
+
+}
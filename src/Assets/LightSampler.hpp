@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Material.hpp"
+#include "UniformBuffer.hpp"
+#include <vector>
+
+namespace Assets
+{
+
+	class LightSampler final
+	{
+	public:
+
+		// luminance of the light's emission times its area, the pi of a lambertian emitter cancels once normalized
+		static float Power(const LightObject& light, const std::vector<Material>& materials);
+
+		// Vose alias table for power proportional selection in O(1) on the gpu. A light without a DiffuseLight
+		// material is weighted by its area alone, a scene without any power falls back to uniform
+		static std::vector<LightAlias> BuildAliasTable(const std::vector<LightObject>& lights, const std::vector<Material>& materials);
+
+		// what the shader does with one uniform number u in [0, 1)
+		static uint32_t Sample(const std::vector<LightAlias>& table, float u, float& pdf);
+
+		// Binary light bvh with spatial and normal cone bounds, split at the centroid median of the longest axis. Node 0
+		// is the root, a scene without lights gets an empty tree
+		static std::vector<LightTreeNode> BuildTree(const std::vector<LightObject>& lights, const std::vector<Material>& materials);
+
+		// how much the lights below a node can contribute to a receiver at position facing normal, as the shader
+		// estimates it to descend the tree
+		static float Importance(const LightTreeNode& node, const glm::vec3& position, const glm::vec3& normal);
+
+		// cpu reference of the shader's traversal, pdf is 0 when no light can reach the receiver
+		static uint32_t SampleTree(const std::vector<LightTreeNode>& tree, const glm::vec3& position, const glm::vec3& normal, float u, float& pdf);
+
+		// the probability SampleTree picks the light, walked up from its leaf. Over all lights it sums to at most 1, what is
+		// missing went to subtrees the bounds prove cannot light the receiver
+		static float TreePdf(const std::vector<LightTreeNode>& tree, const glm::vec3& position, const glm::vec3& normal, uint32_t light);
+
+		// alias table over ENVIRONMENT_TABLE_WIDTH x ENVIRONMENT_TABLE_HEIGHT cells of an equirectangular rgba float image,
+		// weighted by the luminance the sky shader sees times the solid angle of the cell's row
+		static std::vector<LightAlias> BuildEnvironmentTable(const float* rgba, int width, int height);
+
+		// cpu reference of the shader: picks a cell with u.x, a point in it with u.yz and returns the world direction,
+		// pdf is per solid angle. rotation is UniformBufferObject::SkyRotation
+		static glm::vec3 SampleEnvironment(const std::vector<LightAlias>& table, float rotation, const glm::vec3& u, float& pdf);
+		static float EnvironmentPdf(const std::vector<LightAlias>& table, float rotation, const glm::vec3& direction);
+	};
+
+}
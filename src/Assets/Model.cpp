@@ -6,6 +6,7 @@
 #include "Utilities/Console.hpp"
 #include "Utilities/FileHelper.hpp"
 #include "Utilities/Math.hpp"
+#include "Utilities/Profiler.hpp"
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtc/matrix_inverse.hpp>
@@ -72,7 +73,7 @@ namespace std
 namespace Assets
 {
     void ParseGltfNode(std::vector<Assets::Node>& out_nodes, Assets::CameraInitialSate& out_camera, std::vector<Assets::LightObject>& out_lights,
-        glm::mat4 parentTransform, tinygltf::Model& model, int node_idx, int modelIdx)
+        glm::mat4 parentTransform, tinygltf::Model& model, int node_idx, int modelIdx, int materialIdx)
     {
         tinygltf::Node& node = model.nodes[node_idx];
 
@@ -115,13 +116,15 @@ namespace Assets
                 glm::vec4 local_p1 = glm::vec4(-1,0,1, 1);
                 glm::vec4 local_p3 = glm::vec4(1,0,-1, 1);
                 
-                LightObject light;
+                LightObject light{};
                 light.p0 = transform * local_p0;
                 light.p1 = transform * local_p1;
                 light.p3 = transform * local_p3;
                 vec3 dir = vec3(transform * glm::vec4(0,1,0,0));
                 light.normal_area = glm::vec4(glm::normalize(dir),0);
                 light.normal_area.w = glm::length(glm::cross(glm::vec3(light.p1 - light.p0), glm::vec3(light.p3 - light.p0))) / 2.0f;
+                const auto& primitives = model.meshes[node.mesh].primitives;
+                light.MaterialIndex = (primitives.empty() ? 0 : max(0, primitives[0].material)) + materialIdx;
                 
                 out_lights.push_back(light);
             }
@@ -145,7 +148,7 @@ namespace Assets
 
         for ( int child : node.children )
         {
-            ParseGltfNode(out_nodes, out_camera, out_lights, transform, model, child, modelIdx);
+            ParseGltfNode(out_nodes, out_camera, out_lights, transform, model, child, modelIdx, materialIdx);
         }
     }
     
@@ -153,6 +156,7 @@ namespace Assets
                               std::vector<Assets::Model>& models,
                               std::vector<Assets::Material>& materials, std::vector<Assets::LightObject>& lights)
     {
+        PROFILER_SCOPE("load gltf");
         int32_t matieralIdx = static_cast<int32_t>(materials.size());
         int32_t modelIdx = static_cast<int32_t>(models.size());
         
@@ -161,9 +165,12 @@ namespace Assets
         std::string err;
         std::string warn;
 
-        if(!gltfLoader.LoadBinaryFromFile(&model, &err, &warn, filename) )
         {
-            return;
+            PROFILER_SCOPE("gltf parse");
+            if(!gltfLoader.LoadBinaryFromFile(&model, &err, &warn, filename) )
+            {
+                return;
+            }
         }
 
         // load all textures
@@ -434,7 +441,7 @@ namespace Assets
         }
         for (int nodeIdx : model.scenes[0].nodes)
         {
-            ParseGltfNode(nodes, cameraInit, lights, glm::mat4(1), model, nodeIdx, modelIdx);
+            ParseGltfNode(nodes, cameraInit, lights, glm::mat4(1), model, nodeIdx, modelIdx, matieralIdx);
         }
 
         // if we got camera in the scene
@@ -519,6 +526,7 @@ namespace Assets
                             std::vector<Material>& materials,
                             std::vector<LightObject>& lights, bool autoNode)
     {
+        PROFILER_SCOPE("load obj");
         int32_t materialIdxOffset = static_cast<int32_t>(materials.size());
         
         fmt::print("- loading '{}'... \n", filename);
@@ -933,12 +941,13 @@ namespace Assets
         indices.push_back(2);
         indices.push_back(3);
         
-        LightObject light;
+        LightObject light{};
         light.p0 = vec4(p0,1);
         light.p1 = vec4(p1,1);
         light.p3 = vec4(p3,1);
         light.normal_area = vec4(dir, 0);
         light.normal_area.w = glm::length(glm::cross(glm::vec3(light.p1 - light.p0), glm::vec3(light.p3 - light.p0))) / 2.0f;
+        light.MaterialIndex = materialIdx;
         
         lights.push_back(light);
 
@@ -957,6 +966,61 @@ namespace Assets
         return static_cast<int32_t>(models.size()) - 1;
     }
 
+    uint32_t Model::ExtractEmissiveTriangles(const std::vector<Node>& nodes, const std::vector<Model>& models,
+                                     const std::vector<Material>& materials, std::vector<LightObject>& lights)
+    {
+        PROFILER_SCOPE("extract emissive triangles");
+
+        // the quads of tagged gltf nodes, CreateLightQuad and the cornell box are lit meshes as well
+        std::vector<bool> covered(materials.size());
+        for( const auto& light : lights )
+        {
+            if( light.MaterialIndex < covered.size() ) covered[light.MaterialIndex] = true;
+        }
+
+        const size_t before = lights.size();
+        for( const auto& node : nodes )
+        {
+            if( node.GetModel() < 0 || node.GetModel() >= static_cast<int>(models.size()) ) continue;
+            const Model& model = models[node.GetModel()];
+            if( model.Procedural() != nullptr ) continue;
+
+            const mat4& transform = node.WorldTransform();
+            const mat3 normalTransform = inverseTranspose(mat3(transform));
+            const auto& vertices = model.Vertices();
+            const auto& indices = model.Indices();
+            for( size_t i = 0; i + 2 < indices.size(); i += 3 )
+            {
+                const Vertex& v0 = vertices[indices[i]];
+                const uint32_t materialIdx = v0.MaterialIndex;
+                if( materialIdx >= materials.size() || covered[materialIdx] || materials[materialIdx].MaterialModel != Material::Enum::DiffuseLight ) continue;
+
+                const Vertex& v1 = vertices[indices[i + 1]];
+                const Vertex& v2 = vertices[indices[i + 2]];
+
+                LightObject light{};
+                light.p0 = transform * vec4(v0.Position, 1);
+                light.p1 = transform * vec4(v1.Position, 1);
+                light.p3 = transform * vec4(v2.Position, 1);
+
+                const vec3 perpendicular = cross(vec3(light.p1 - light.p0), vec3(light.p3 - light.p0));
+                const float doubleArea = glm::length(perpendicular);
+                if( doubleArea <= 0 ) continue;
+
+                // the shaders emit on the side the interpolated normal faces, whatever the winding
+                const vec3 shadingNormal = normalTransform * (v0.Normal + v1.Normal + v2.Normal);
+                const vec3 normal = perpendicular / doubleArea;
+                light.normal_area = vec4(dot(normal, shadingNormal) < 0 ? -normal : normal, doubleArea / 2.0f);
+                light.MaterialIndex = materialIdx;
+                light.Triangle = 1;
+
+                lights.push_back(light);
+            }
+        }
+
+        return static_cast<uint32_t>(lights.size() - before);
+    }
+
     Model::Model(std::vector<Vertex>&& vertices, std::vector<uint32_t>&& indices, std::vector<uint32_t>&& materials,
                  const class Procedural* procedural) :
         vertices_(std::move(vertices)),
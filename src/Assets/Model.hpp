@@ -92,6 +92,10 @@ namespace Assets
                                      std::vector<Model>& models,
                                      std::vector<Material>& materials,
                                      std::vector<LightObject>& lights);
+        // every triangle with a DiffuseLight material becomes a world space triangle light, unless an area light quad
+        // already emits with that material. Returns the number of lights added
+        static uint32_t ExtractEmissiveTriangles(const std::vector<Node>& nodes, const std::vector<Model>& models,
+                                     const std::vector<Material>& materials, std::vector<LightObject>& lights);
         static void LoadGLTFScene(const std::string& filename, Assets::CameraInitialSate& cameraInit, std::vector<class Node>& nodes,
                                   std::vector<Assets::Model>& models, std::vector<Assets::Material>& materials, std::vector<Assets::LightObject>& lights);
 
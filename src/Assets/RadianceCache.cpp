@@ -0,0 +1,111 @@
+#include "RadianceCache.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Assets {
+
+glm::uvec2 RadianceCache::Key(const glm::vec3& position, const glm::vec3& normal, const glm::vec3& camera)
+{
+	const float distanceToCamera = glm::length(position - camera);
+	const float levelDistance = static_cast<float>(RADIANCE_CACHE_LEVEL_DISTANCE);
+	const uint32_t level = static_cast<uint32_t>(std::clamp(std::floor(std::log2(std::max(distanceToCamera, 1e-6f) / levelDistance)) + 1.0f, 0.0f, 15.0f));
+	const glm::ivec3 cell = glm::ivec3(glm::floor(position / (static_cast<float>(RADIANCE_CACHE_CELL_SIZE) * std::exp2(static_cast<float>(level)))));
+
+	const glm::vec3 axis = glm::abs(normal);
+	const uint32_t dominant = axis.x >= axis.y && axis.x >= axis.z ? 0 : (axis.y >= axis.z ? 1 : 2);
+	const uint32_t facing = dominant * 2 + (normal[dominant] < 0.0f ? 1 : 0);
+	const uint32_t lod = level << 3 | facing;
+
+	const auto x = static_cast<uint32_t>(cell.x);
+	const auto y = static_cast<uint32_t>(cell.y);
+	const auto z = static_cast<uint32_t>(cell.z);
+	const uint32_t bucket = Hash(x ^ Hash(y ^ Hash(z ^ Hash(lod))));
+	const uint32_t checksum = Hash(z * 0x9e3779b9u ^ Hash(x ^ Hash(y + lod * 0x85ebca6bu)));
+	return glm::uvec2(bucket, std::max(checksum, 1u));
+}
+
+uint32_t RadianceCache::Find(const std::vector<RadianceCacheEntry>& entries, glm::uvec2 key)
+{
+	const uint32_t bucket = (key.x % RADIANCE_CACHE_SIZE) & ~(RADIANCE_CACHE_PROBES - 1u);
+	for (uint32_t i = 0; i < RADIANCE_CACHE_PROBES; ++i)
+	{
+		if (entries[bucket + i].Key == key.y)
+		{
+			return bucket + i;
+		}
+	}
+	return RADIANCE_CACHE_SIZE;
+}
+
+uint32_t RadianceCache::Insert(std::vector<RadianceCacheEntry>& entries, glm::uvec2 key)
+{
+	const uint32_t found = Find(entries, key);
+	if (found < RADIANCE_CACHE_SIZE)
+	{
+		return found;
+	}
+
+	const uint32_t bucket = (key.x % RADIANCE_CACHE_SIZE) & ~(RADIANCE_CACHE_PROBES - 1u);
+	for (uint32_t i = 0; i < RADIANCE_CACHE_PROBES; ++i)
+	{
+		if (entries[bucket + i].Key == 0)
+		{
+			entries[bucket + i].Key = key.y;
+			return bucket + i;
+		}
+	}
+	return RADIANCE_CACHE_SIZE;
+}
+
+void RadianceCache::Accumulate(std::vector<RadianceCacheEntry>& entries, uint32_t slot, const glm::vec3& radiance)
+{
+	const glm::vec3 clamped = glm::clamp(radiance, glm::vec3(0.0f), glm::vec3(RADIANCE_CACHE_MAX_RADIANCE));
+	const glm::uvec3 value = glm::uvec3(clamped * static_cast<float>(RADIANCE_CACHE_FIXED_POINT) + 0.5f);
+	entries[slot].Accumulated += glm::uvec4(value, 1u);
+}
+
+void RadianceCache::Resolve(std::vector<RadianceCacheEntry>& entries)
+{
+	for (RadianceCacheEntry& entry : entries)
+	{
+		if (entry.Key == 0)
+		{
+			continue;
+		}
+
+		if (entry.Accumulated.w == 0)
+		{
+			if (entry.Age + 1 > RADIANCE_CACHE_MAX_AGE)
+			{
+				entry = RadianceCacheEntry{};
+			}
+			else
+			{
+				entry.Age++;
+			}
+			continue;
+		}
+
+		const float samples = static_cast<float>(entry.Accumulated.w);
+		const glm::vec3 mean = glm::vec3(entry.Accumulated) / (static_cast<float>(RADIANCE_CACHE_FIXED_POINT) * samples);
+		const uint32_t count = std::min<uint32_t>(entry.SampleCount + entry.Accumulated.w, RADIANCE_CACHE_MAX_SAMPLES);
+		entry.Radiance = glm::vec4(glm::mix(glm::vec3(entry.Radiance), mean, std::min(samples / static_cast<float>(count), 1.0f)), 0.0f);
+		entry.SampleCount = count;
+		entry.Age = 0;
+		entry.Accumulated = glm::uvec4(0);
+	}
+}
+
+uint32_t RadianceCache::Hash(uint32_t x)
+{
+	// Wellons' lowbias32
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+}
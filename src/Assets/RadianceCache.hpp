@@ -0,0 +1,52 @@
+#pragma once
+
+#include "UniformBuffer.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Assets
+{
+
+	// one slot of the world space radiance cache, as RadianceCache.glsl lays it out
+	struct alignas(16) RadianceCacheEntry final
+	{
+		// checksum of the cell, 0 for a free slot
+		uint32_t Key;
+		// resolves since the last update
+		uint32_t Age;
+		// samples blended into Radiance, saturates at RADIANCE_CACHE_MAX_SAMPLES
+		uint32_t SampleCount;
+		uint32_t Reserved;
+		glm::vec4 Radiance;
+		// this frame's radiance in fixed point and its sample count in w
+		glm::uvec4 Accumulated;
+	};
+
+	static_assert(sizeof(RadianceCacheEntry) == 48, "RadianceCacheEntry must match its std430 layout");
+
+	// cpu reference of the spatial hash radiance cache the ray query renderer ends its diffuse paths in, after Binder et
+	// al.'s "Spatial Hash Radiance Caching". A cell is keyed by its position, its level and the dominant axis of the
+	// normal, lives in one slot of the bucket its hash lands on and is told apart by a second hash. Paths add the
+	// radiance they found leaving a hit, once a frame the resolve blends the frame's mean in and evicts the stale cells
+	class RadianceCache final
+	{
+	public:
+
+		// bucket hash in x and never 0 checksum in y of the cell holding position
+		static glm::uvec2 Key(const glm::vec3& position, const glm::vec3& normal, const glm::vec3& camera);
+
+		// the slot of the cell, RADIANCE_CACHE_SIZE when it is not cached
+		static uint32_t Find(const std::vector<RadianceCacheEntry>& entries, glm::uvec2 key);
+
+		// the slot of the cell, taking the first free one of its bucket when missing, RADIANCE_CACHE_SIZE when full
+		static uint32_t Insert(std::vector<RadianceCacheEntry>& entries, glm::uvec2 key);
+
+		static void Accumulate(std::vector<RadianceCacheEntry>& entries, uint32_t slot, const glm::vec3& radiance);
+
+		// the resolve pass over every slot
+		static void Resolve(std::vector<RadianceCacheEntry>& entries);
+
+		static uint32_t Hash(uint32_t x);
+	};
+
+}
@@ -1,4 +1,5 @@
 #include "Scene.hpp"
+#include "LightSampler.hpp"
 #include "Model.hpp"
 #include "Sphere.hpp"
 #include "Vulkan/BufferUtil.hpp"
@@ -12,10 +13,14 @@ Scene::Scene(Vulkan::CommandPool& commandPool,
 	std::vector<Material>& materials,
 	std::vector<LightObject>& lights,
 	bool supportRayTracing) :
+	commandPool_(commandPool),
 	materials_(std::move(materials)),
 	models_(std::move(models)),
 	nodes_(std::move(nodes))
 {
+	Model::ExtractEmissiveTriangles(nodes_, models_, materials_, lights);
+	lights_ = lights;
+
 	// Concatenate all the models
 	std::vector<Vertex> vertices;
 	std::vector<uint32_t> indices;
@@ -52,18 +57,50 @@ Scene::Scene(Vulkan::CommandPool& commandPool,
 
 	// node should sort by models, for instancing rendering
 	std::vector<NodeProxy> nodeProxys;
-	std::vector<VkDrawIndexedIndirectCommand> indirectDrawBuffer;
 	std::vector<VkDrawIndexedIndirectCommand> indirectDrawBufferInstanced;
+	BuildDrawBatches(models_, nodes_, nodeProxys, indirectDrawBufferInstanced, model_instance_count_);
+	
+	Vulkan::MemoryScope memoryScope(Vulkan::EMemoryCategory::Geometry, "scene");
+	int flags = supportRayTracing ? (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) : VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	int rtxFlags = supportRayTracing ? VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR : 0;
+	
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Vertices", VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | rtxFlags | flags, vertices, vertexBuffer_, vertexBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Indices", VK_BUFFER_USAGE_INDEX_BUFFER_BIT | rtxFlags | flags, indices, indexBuffer_, indexBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Materials", flags, materials_, materialBuffer_, materialBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Offsets", flags, offsets_, offsetBuffer_, offsetBufferMemory_);
+
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "AABBs", rtxFlags | flags, aabbs, aabbBuffer_, aabbBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Procedurals", flags, procedurals, proceduralBuffer_, proceduralBufferMemory_);
+
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Lights", flags, lights, lightBuffer_, lightBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "LightAliases", flags, LightSampler::BuildAliasTable(lights, materials_), lightAliasBuffer_, lightAliasBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "LightTree", flags, LightSampler::BuildTree(lights, materials_), lightTreeBuffer_, lightTreeBufferMemory_);
+
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Nodes", flags, nodeProxys, nodeMatrixBuffer_, nodeMatrixBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "IndirectDraws", flags | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, indirectDrawBufferInstanced, indirectDrawBuffer_, indirectDrawBufferMemory_);
+	
+	lightCount_ = static_cast<uint32_t>(lights.size());
+	indicesCount_ = static_cast<uint32_t>(indices.size());
+	verticeCount_ = static_cast<uint32_t>(vertices.size());
+	indirectDrawBatchCount_ = static_cast<uint32_t>(indirectDrawBufferInstanced.size());
+}
+
+void Scene::BuildDrawBatches(const std::vector<Model>& models, const std::vector<Node>& nodes,
+	std::vector<NodeProxy>& nodeProxys,
+	std::vector<VkDrawIndexedIndirectCommand>& indirectDrawBufferInstanced,
+	std::vector<uint32_t>& instanceCounts)
+{
+	std::vector<VkDrawIndexedIndirectCommand> indirectDrawBuffer;
 	
 	uint32_t indexOffset = 0;
 	uint32_t vertexOffset = 0;
 	uint32_t nodeOffset = 0;
 	uint32_t nodeOffsetBatched = 0;
-	int modelCount = static_cast<int>(models_.size());
+	int modelCount = static_cast<int>(models.size());
 	for (int i = 0; i < modelCount; i++)
 	{	
 		uint32_t instanceCountOfThisModel = 0;
-		for (const auto& node : nodes_)
+		for (const auto& node : nodes)
 		{
 			if(node.GetModel() == i)
 			{
@@ -72,7 +109,7 @@ Scene::Scene(Vulkan::CommandPool& commandPool,
 				// draw indirect buffer, one by one
 				VkDrawIndexedIndirectCommand cmd{};
 				cmd.firstIndex    = indexOffset;
-				cmd.indexCount    = static_cast<uint32_t>(models_[i].Indices().size());
+				cmd.indexCount    = static_cast<uint32_t>(models[i].Indices().size());
 				cmd.vertexOffset  = static_cast<int32_t>(vertexOffset);
 				cmd.firstInstance = nodeOffset;
 				cmd.instanceCount = 1;
@@ -85,39 +122,18 @@ Scene::Scene(Vulkan::CommandPool& commandPool,
 		// draw indirect buffer, instanced
 		VkDrawIndexedIndirectCommand cmd{};
 		cmd.firstIndex    = indexOffset;
-		cmd.indexCount    = static_cast<uint32_t>(models_[i].Indices().size());
+		cmd.indexCount    = static_cast<uint32_t>(models[i].Indices().size());
 		cmd.vertexOffset  = static_cast<int32_t>(vertexOffset);
 		cmd.firstInstance = nodeOffsetBatched;
 		cmd.instanceCount = instanceCountOfThisModel;
 
 		indirectDrawBufferInstanced.push_back(cmd);
 		
-		indexOffset += static_cast<uint32_t>(models_[i].Indices().size());
-		vertexOffset += static_cast<uint32_t>(models_[i].Vertices().size());
+		indexOffset += static_cast<uint32_t>(models[i].Indices().size());
+		vertexOffset += static_cast<uint32_t>(models[i].Vertices().size());
 		nodeOffsetBatched += instanceCountOfThisModel;
-		model_instance_count_.push_back(instanceCountOfThisModel);
+		instanceCounts.push_back(instanceCountOfThisModel);
 	}
-	
-	int flags = supportRayTracing ? (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) : VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-	int rtxFlags = supportRayTracing ? VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR : 0;
-	
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Vertices", VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | rtxFlags | flags, vertices, vertexBuffer_, vertexBufferMemory_);
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Indices", VK_BUFFER_USAGE_INDEX_BUFFER_BIT | rtxFlags | flags, indices, indexBuffer_, indexBufferMemory_);
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Materials", flags, materials_, materialBuffer_, materialBufferMemory_);
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Offsets", flags, offsets_, offsetBuffer_, offsetBufferMemory_);
-
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "AABBs", rtxFlags | flags, aabbs, aabbBuffer_, aabbBufferMemory_);
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Procedurals", flags, procedurals, proceduralBuffer_, proceduralBufferMemory_);
-
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Lights", flags, lights, lightBuffer_, lightBufferMemory_);
-
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Nodes", flags, nodeProxys, nodeMatrixBuffer_, nodeMatrixBufferMemory_);
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "IndirectDraws", flags | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, indirectDrawBufferInstanced, indirectDrawBuffer_, indirectDrawBufferMemory_);
-	
-	lightCount_ = static_cast<uint32_t>(lights.size());
-	indicesCount_ = static_cast<uint32_t>(indices.size());
-	verticeCount_ = static_cast<uint32_t>(vertices.size());
-	indirectDrawBatchCount_ = static_cast<uint32_t>(indirectDrawBufferInstanced.size());
 }
 
 Scene::~Scene()
@@ -136,12 +152,28 @@ Scene::~Scene()
 	vertexBufferMemory_.reset(); // release memory after bound buffer has been destroyed
 	lightBuffer_.reset();
 	lightBufferMemory_.reset();
+	lightAliasBuffer_.reset();
+	lightAliasBufferMemory_.reset();
+	lightTreeBuffer_.reset();
+	lightTreeBufferMemory_.reset();
 	indirectDrawBuffer_.reset();
 	indirectDrawBufferMemory_.reset();
 }
 
 void Scene::UpdateMaterial()
 {
-	// update value after binding, like the bindless textures, try
+	if (materials_.empty())
+	{
+		return;
+	}
+
+	// the buffers keep their size, the light count and so the tree's node count do not change with an edit
+	commandPool_.Device().WaitIdle();
+	Vulkan::BufferUtil::CopyFromStagingBuffer(commandPool_, *materialBuffer_, materials_);
+	if (!lights_.empty())
+	{
+		Vulkan::BufferUtil::CopyFromStagingBuffer(commandPool_, *lightAliasBuffer_, LightSampler::BuildAliasTable(lights_, materials_));
+		Vulkan::BufferUtil::CopyFromStagingBuffer(commandPool_, *lightTreeBuffer_, LightSampler::BuildTree(lights_, materials_));
+	}
 }
 }
@@ -18,6 +18,7 @@ namespace Assets
 	class Node;
 	class Model;
 	class Texture;
+	struct NodeProxy;
 	class TextureImage;
 	struct Material;
 	struct LightObject;
@@ -39,6 +40,12 @@ namespace Assets
 			bool supportRayTracing);
 		~Scene();
 
+		// sorts the node instances by model: one proxy per node in model order and one instanced draw per model
+		static void BuildDrawBatches(const std::vector<Model>& models, const std::vector<Node>& nodes,
+			std::vector<NodeProxy>& nodeProxys,
+			std::vector<VkDrawIndexedIndirectCommand>& indirectDrawBufferInstanced,
+			std::vector<uint32_t>& instanceCounts);
+
 		const std::vector<Node>& Nodes() const { return nodes_; }
 		const std::vector<Model>& Models() const { return models_; }
 		std::vector<Material>& Materials() { return materials_; }
@@ -54,6 +61,8 @@ namespace Assets
 		const Vulkan::Buffer& AabbBuffer() const { return *aabbBuffer_; }
 		const Vulkan::Buffer& ProceduralBuffer() const { return *proceduralBuffer_; }
 		const Vulkan::Buffer& LightBuffer() const { return *lightBuffer_; }
+		const Vulkan::Buffer& LightAliasBuffer() const { return *lightAliasBuffer_; }
+		const Vulkan::Buffer& LightTreeBuffer() const { return *lightTreeBuffer_; }
 		const Vulkan::Buffer& NodeMatrixBuffer() const { return *nodeMatrixBuffer_; }
 		const Vulkan::Buffer& IndirectDrawBuffer() const { return *indirectDrawBuffer_; }
 
@@ -67,10 +76,13 @@ namespace Assets
 		uint32_t GetSelectedId() const { return selectedId_; }
 		void SetSelectedId( uint32_t id ) const { selectedId_ = id; }
 
+		// uploads materials_ after an edit, along with the light alias table and tree since emission sets the lights' power
 		void UpdateMaterial();
 		
 	private:
+		Vulkan::CommandPool& commandPool_;
 		std::vector<Material> materials_;
+		std::vector<LightObject> lights_;
 		const std::vector<Model> models_;
 		const std::vector<Node> nodes_;
 		std::vector<glm::uvec2> offsets_;
@@ -97,6 +109,12 @@ namespace Assets
 		std::unique_ptr<Vulkan::Buffer> lightBuffer_;
 		std::unique_ptr<Vulkan::DeviceMemory> lightBufferMemory_;
 
+		std::unique_ptr<Vulkan::Buffer> lightAliasBuffer_;
+		std::unique_ptr<Vulkan::DeviceMemory> lightAliasBufferMemory_;
+
+		std::unique_ptr<Vulkan::Buffer> lightTreeBuffer_;
+		std::unique_ptr<Vulkan::DeviceMemory> lightTreeBufferMemory_;
+
 		std::unique_ptr<Vulkan::Buffer> nodeMatrixBuffer_;
 		std::unique_ptr<Vulkan::DeviceMemory> nodeMatrixBufferMemory_;
 		
@@ -0,0 +1,163 @@
+#include "SobolSampler.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace Assets {
+
+namespace
+{
+	// Joe and Kuo's new-joe-kuo-6.21201 primitive polynomials past the first dimension, which is van der Corput. Only
+	// the first pair is a (0,2)-sequence, the later ones stratify their 2d projections far worse than a fresh shuffle
+	// of the first pair does, so SAMPLER_DIMENSIONS pads in pairs
+	struct Polynomial
+	{
+		uint32_t Degree;
+		uint32_t Coefficients;
+		std::array<uint32_t, 3> Initial;
+	};
+
+	constexpr std::array<Polynomial, 3> Polynomials = {{
+		{1, 0, {1, 0, 0}},
+		{2, 1, {1, 3, 0}},
+		{3, 1, {1, 3, 1}},
+	}};
+	static_assert(SAMPLER_DIMENSIONS <= Polynomials.size() + 1, "no polynomial for a sampler dimension");
+
+	constexpr uint32_t RankOffset = SAMPLER_DIMENSIONS * 32;
+
+	uint32_t RankLevels()
+	{
+		uint32_t levels = 0;
+		while ((1u << levels) < SAMPLER_RANK_TILE) levels++;
+		return levels;
+	}
+}
+
+std::vector<uint32_t> SobolSampler::BuildTables()
+{
+	std::vector<uint32_t> tables = BuildMatrices();
+	const std::vector<uint32_t> ranks = BuildRankingTile(0x2c7d1e43u);
+	tables.insert(tables.end(), ranks.begin(), ranks.end());
+	return tables;
+}
+
+std::vector<uint32_t> SobolSampler::BuildMatrices()
+{
+	std::vector<uint32_t> matrices(RankOffset);
+	for (uint32_t i = 0; i < 32; ++i)
+	{
+		matrices[i] = 1u << (31 - i);
+	}
+
+	for (uint32_t dimension = 1; dimension < SAMPLER_DIMENSIONS; ++dimension)
+	{
+		const Polynomial& polynomial = Polynomials[dimension - 1];
+		uint32_t* columns = matrices.data() + dimension * 32;
+		for (uint32_t i = 0; i < 32; ++i)
+		{
+			if (i < polynomial.Degree)
+			{
+				columns[i] = polynomial.Initial[i] << (31 - i);
+				continue;
+			}
+
+			columns[i] = columns[i - polynomial.Degree] ^ (columns[i - polynomial.Degree] >> polynomial.Degree);
+			for (uint32_t k = 1; k < polynomial.Degree; ++k)
+			{
+				if ((polynomial.Coefficients >> (polynomial.Degree - 1 - k)) & 1u)
+				{
+					columns[i] ^= columns[i - k];
+				}
+			}
+		}
+	}
+	return matrices;
+}
+
+std::vector<uint32_t> SobolSampler::BuildRankingTile(uint32_t seed)
+{
+	const uint32_t levels = RankLevels();
+	std::vector<uint32_t> ranks(SAMPLER_RANK_TILE * SAMPLER_RANK_TILE);
+	for (uint32_t y = 0; y < SAMPLER_RANK_TILE; ++y)
+	{
+		for (uint32_t x = 0; x < SAMPLER_RANK_TILE; ++x)
+		{
+			// the coarsest level gives the highest digit, so pixels next to each other differ in the lowest bits
+			uint32_t rank = 0;
+			for (uint32_t level = levels; level-- > 0;)
+			{
+				const uint32_t node = Hash(seed ^ Hash(level ^ Hash((x >> (level + 1)) ^ Hash(y >> (level + 1)))));
+
+				std::array<uint32_t, 4> digits = {0, 1, 2, 3};
+				for (uint32_t i = 3; i > 0; --i)
+				{
+					std::swap(digits[i], digits[(node >> (i * 8)) % (i + 1)]);
+				}
+
+				const uint32_t quadrant = ((y >> level) & 1u) << 1 | ((x >> level) & 1u);
+				rank = rank << 2 | digits[quadrant];
+			}
+			ranks[y * SAMPLER_RANK_TILE + x] = rank;
+		}
+	}
+	return ranks;
+}
+
+uint32_t SobolSampler::Sobol(const std::vector<uint32_t>& matrices, uint32_t index, uint32_t dimension)
+{
+	uint32_t result = 0;
+	for (uint32_t bit = 0; index != 0; ++bit, index >>= 1)
+	{
+		if (index & 1u) result ^= matrices[dimension * 32 + bit];
+	}
+	return result;
+}
+
+uint32_t SobolSampler::NestedUniformScramble(uint32_t x, uint32_t seed)
+{
+	// reverse, permute so that every bit depends on the ones below it, reverse back
+	const auto reverse = [](uint32_t v)
+	{
+		v = (v >> 1 & 0x55555555u) | (v & 0x55555555u) << 1;
+		v = (v >> 2 & 0x33333333u) | (v & 0x33333333u) << 2;
+		v = (v >> 4 & 0x0f0f0f0fu) | (v & 0x0f0f0f0fu) << 4;
+		v = (v >> 8 & 0x00ff00ffu) | (v & 0x00ff00ffu) << 8;
+		return v >> 16 | v << 16;
+	};
+
+	x = reverse(x);
+	x += seed;
+	x ^= x * 0x6c50b47cu;
+	x ^= x * 0xb82f1e52u;
+	x ^= x * 0xc7afe638u;
+	x ^= x * 0x8d22f6e6u;
+	return reverse(x);
+}
+
+uint32_t SobolSampler::Hash(uint32_t x)
+{
+	// Wellons' lowbias32
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+float SobolSampler::Sample(const std::vector<uint32_t>& tables, uint32_t x, uint32_t y, uint32_t sampleIndex, uint32_t dimension)
+{
+	const uint32_t rank = tables[RankOffset + (y % SAMPLER_RANK_TILE) * SAMPLER_RANK_TILE + x % SAMPLER_RANK_TILE];
+	const uint32_t tile = Hash(x / SAMPLER_RANK_TILE ^ Hash(y / SAMPLER_RANK_TILE));
+
+	const uint32_t group = Hash(tile ^ Hash(dimension / SAMPLER_DIMENSIONS));
+	const uint32_t index = NestedUniformScramble(sampleIndex ^ rank, group);
+	const uint32_t component = dimension % SAMPLER_DIMENSIONS;
+	const uint32_t value = NestedUniformScramble(Sobol(tables, index, component), Hash(group + component + 1));
+
+	// the same 23 bits the shader turns into a float
+	return static_cast<float>(value >> 9) * (1.0f / 8388608.0f);
+}
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "UniformBuffer.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Assets
+{
+
+	// Owen scrambled Sobol points padded over SAMPLER_DIMENSIONS dimensions, after Burley, "Practical Hash-based Owen
+	// Scrambling". Every group of dimensions shuffles the point index with its own seed, so a path can draw as many
+	// numbers as it likes. Pixels of a SAMPLER_RANK_TILE square xor their rank into the index: neighbours get points of
+	// the same small aligned block of the sequence, which spreads their error as blue noise over the screen.
+	class SobolSampler final
+	{
+	public:
+
+		// generator matrices of the first SAMPLER_DIMENSIONS dimensions, 32 columns each, then the ranking tile
+		static std::vector<uint32_t> BuildTables();
+
+		static std::vector<uint32_t> BuildMatrices();
+
+		// a morton order of the tile with the four quadrants of every node shuffled, so the pixels of any aligned 2^k
+		// square hold a contiguous block of ranks
+		static std::vector<uint32_t> BuildRankingTile(uint32_t seed);
+
+		static uint32_t Sobol(const std::vector<uint32_t>& matrices, uint32_t index, uint32_t dimension);
+
+		// Laine and Karras' hash permutation on reversed bits, every bit only flips with the ones above it
+		static uint32_t NestedUniformScramble(uint32_t x, uint32_t seed);
+
+		static uint32_t Hash(uint32_t x);
+
+		// cpu reference of the shader, the number in [0, 1) the pixel draws as its dimension'th of sampleIndex
+		static float Sample(const std::vector<uint32_t>& tables, uint32_t x, uint32_t y, uint32_t sampleIndex, uint32_t dimension);
+	};
+
+}
@@ -1,13 +1,17 @@
 #include "Texture.hpp"
+#include "LightSampler.hpp"
 #include "Utilities/StbImage.hpp"
 #include "Utilities/Exception.hpp"
+#include "Utilities/Profiler.hpp"
 #include <chrono>
+#include <cstring>
 #include <imgui_impl_vulkan.h>
 #include <fmt/format.h>
 
 #include "Options.hpp"
 #include "Runtime/TaskCoordinator.hpp"
 #include "TextureImage.hpp"
+#include "Vulkan/Buffer.hpp"
 #include "Vulkan/Device.hpp"
 #include "Vulkan/ImageView.hpp"
 
@@ -17,22 +21,35 @@ namespace Assets
     {
         int32_t textureId;
         TextureImage* transferPtr;
+        std::vector<LightAlias>* environmentTable;
         float elapsed;
         std::array<char, 256> outputInfo;
     };
     
     uint32_t GlobalTexturePool::LoadTexture(const std::string& filename, const Vulkan::SamplerConfig& samplerConfig)
     {
+        if (instance_ == nullptr && offlineLoader_)
+        {
+            return offlineLoader_(filename, nullptr, 0, false);
+        }
         return GetInstance()->RequestNewTextureFileAsync(filename, false);
     }
 
     uint32_t GlobalTexturePool::LoadTexture(const std::string& texname, const unsigned char* data, size_t bytelength, const Vulkan::SamplerConfig& samplerConfig)
     {
+        if (instance_ == nullptr && offlineLoader_)
+        {
+            return offlineLoader_(texname, data, bytelength, false);
+        }
         return GetInstance()->RequestNewTextureMemAsync(texname, false, data, bytelength);
     }
 
     uint32_t GlobalTexturePool::LoadHDRTexture(const std::string& filename, const Vulkan::SamplerConfig& samplerConfig)
     {
+        if (instance_ == nullptr && offlineLoader_)
+        {
+            return offlineLoader_(filename, nullptr, 0, true);
+        }
         return GetInstance()->RequestNewTextureFileAsync(filename, true);
     }
 
@@ -118,11 +135,21 @@ namespace Assets
         Vulkan::Check(vkAllocateDescriptorSets(device_.Handle(), &alloc_info, descriptorSets_.data()),
                       "alloc global descriptor set");
 
+        // written from the main thread once an hdri is decoded, small enough to stay host visible
+        Vulkan::MemoryScope memoryScope(Vulkan::EMemoryCategory::Texture, "environment tables");
+        const size_t tableSize = sizeof(LightAlias) * ENVIRONMENT_TABLE_WIDTH * ENVIRONMENT_TABLE_HEIGHT * ENVIRONMENT_TABLE_SLOTS;
+        environmentTableBuffer_.reset(new Vulkan::Buffer(device, tableSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
+        environmentTableBufferMemory_.reset(new Vulkan::DeviceMemory(environmentTableBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)));
+        environmentTables_.resize(ENVIRONMENT_TABLE_SLOTS);
+
         GlobalTexturePool::instance_ = this;
     }
 
     GlobalTexturePool::~GlobalTexturePool()
     {
+        environmentTableBuffer_.reset();
+        environmentTableBufferMemory_.reset();
+
         if (descriptorPool_ != nullptr)
         {
             vkDestroyDescriptorPool(device_.Handle(), descriptorPool_, nullptr);
@@ -159,6 +186,25 @@ namespace Assets
             &descriptorWrite, 0, nullptr);
     }
 
+    const Vulkan::Buffer& GlobalTexturePool::EnvironmentTableBuffer() const
+    {
+        return *environmentTableBuffer_;
+    }
+
+    bool GlobalTexturePool::HasEnvironmentTable(uint32_t textureIdx) const
+    {
+        return textureIdx < environmentTables_.size() && environmentTables_[textureIdx];
+    }
+
+    void GlobalTexturePool::UploadEnvironmentTable(uint32_t textureIdx, const std::vector<LightAlias>& table)
+    {
+        const size_t tableSize = sizeof(LightAlias) * table.size();
+        const auto data = environmentTableBufferMemory_->Map(tableSize * textureIdx, tableSize);
+        std::memcpy(data, table.data(), tableSize);
+        environmentTableBufferMemory_->Unmap();
+        environmentTables_[textureIdx] = true;
+    }
+
     uint32_t GlobalTexturePool::TryGetTexureIndex(const std::string& textureName) const
     {
         if (textureNameMap_.find(textureName) != textureNameMap_.end())
@@ -186,13 +232,16 @@ namespace Assets
             // Load the texture in normal host memory.
             int width, height, channels;
             void* pixels = nullptr;
-            if(hdr)
-            {
-                pixels = stbi_loadf(filename.c_str(), &width, &height, &channels, STBI_rgb_alpha);
-            }
-            else
             {
-                pixels = stbi_load(filename.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+                PROFILER_SCOPE("texture decode");
+                if(hdr)
+                {
+                    pixels = stbi_loadf(filename.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+                }
+                else
+                {
+                    pixels = stbi_load(filename.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+                }
             }
 
             if (!pixels)
@@ -200,18 +249,32 @@ namespace Assets
                 Throw(std::runtime_error("failed to load texture image '" + filename + "'"));
             }
 
+            if(hdr && newTextureIdx < ENVIRONMENT_TABLE_SLOTS)
+            {
+                PROFILER_SCOPE("environment table");
+                taskContext.environmentTable = new std::vector<LightAlias>(LightSampler::BuildEnvironmentTable(static_cast<float*>(pixels), width, height));
+            }
+
+            PROFILER_SCOPE("texture upload");
             textureImages_[newTextureIdx] = std::make_unique<TextureImage>(commandPool_, width, height, hdr, static_cast<unsigned char*>((void*)pixels));
             BindTexture(newTextureIdx, *(textureImages_[newTextureIdx]));
             stbi_image_free(pixels);
 
+            taskContext.textureId = newTextureIdx;
+
             taskContext.elapsed = std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - timer).count();
             std::string info = fmt::format("loaded {} ({} x {} x {}) in {:.2f}ms", filename, width, height, channels, taskContext.elapsed * 1000.f);
             std::copy(info.begin(), info.end(), taskContext.outputInfo.data());
             task.SetContext( taskContext );
-        }, [](ResTask& task)
+        }, [this](ResTask& task)
         {
             TextureTaskContext taskContext {};
             task.GetContext( taskContext );
+            if(taskContext.environmentTable)
+            {
+                UploadEnvironmentTable(taskContext.textureId, *taskContext.environmentTable);
+                delete taskContext.environmentTable;
+            }
             if(!GOption->Benchmark) fmt::print("{}\n", taskContext.outputInfo.data());
         }, 0);
 
@@ -230,13 +293,16 @@ namespace Assets
             // Load the texture in normal host memory.
             int width, height, channels;
             void* pixels = nullptr;
-            if(hdr)
             {
-                pixels = stbi_loadf(filename.c_str(), &width, &height, &channels, STBI_rgb_alpha);
-            }
-            else
-            {
-                pixels = stbi_load(filename.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+                PROFILER_SCOPE("texture decode");
+                if(hdr)
+                {
+                    pixels = stbi_loadf(filename.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+                }
+                else
+                {
+                    pixels = stbi_load(filename.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+                }
             }
 
             if (!pixels)
@@ -244,7 +310,14 @@ namespace Assets
                 Throw(std::runtime_error("failed to load texture image '" + filename + "'"));
             }
 
+            if(hdr && textureIdx < ENVIRONMENT_TABLE_SLOTS)
+            {
+                PROFILER_SCOPE("environment table");
+                taskContext.environmentTable = new std::vector<LightAlias>(LightSampler::BuildEnvironmentTable(static_cast<float*>(pixels), width, height));
+            }
+
             // thread reset may cause crash, created the new texture here, but reset in later main thread phase
+            PROFILER_SCOPE("texture upload");
             taskContext.transferPtr = new TextureImage(commandPool_, width, height, hdr, static_cast<unsigned char*>((void*)pixels));
             stbi_image_free(pixels);
             taskContext.textureId = textureIdx;
@@ -259,6 +332,11 @@ namespace Assets
 
             textureImages_[taskContext.textureId].reset(taskContext.transferPtr);
             BindTexture(taskContext.textureId, *(textureImages_[taskContext.textureId]));
+            if(taskContext.environmentTable)
+            {
+                UploadEnvironmentTable(taskContext.textureId, *taskContext.environmentTable);
+                delete taskContext.environmentTable;
+            }
             
             fmt::print("{}\n", taskContext.outputInfo.data());
         }, 0);
@@ -283,13 +361,18 @@ namespace Assets
             
             // Load the texture in normal host memory.
             int width, height, channels;
-            const auto pixels = stbi_load_from_memory(copyedData, static_cast<uint32_t>(bytelength), &width, &height, &channels, STBI_rgb_alpha);
+            unsigned char* pixels = nullptr;
+            {
+                PROFILER_SCOPE("texture decode");
+                pixels = stbi_load_from_memory(copyedData, static_cast<uint32_t>(bytelength), &width, &height, &channels, STBI_rgb_alpha);
+            }
 
             if (!pixels)
             {
                 Throw(std::runtime_error("failed to load texture image "));
             }
 
+            PROFILER_SCOPE("texture upload");
             // create texture image
             textureImages_[newTextureIdx] = std::make_unique<TextureImage>(commandPool_, width, height, false, static_cast<unsigned char*>((void*)pixels));
             BindTexture(newTextureIdx, *(textureImages_[newTextureIdx]));
@@ -315,4 +398,5 @@ namespace Assets
     }
 
     GlobalTexturePool* GlobalTexturePool::instance_ = nullptr;
+    GlobalTexturePool::OfflineLoader GlobalTexturePool::offlineLoader_;
 }
@@ -2,18 +2,22 @@
 
 #include "Vulkan/Vulkan.hpp"
 #include "Vulkan/Sampler.hpp"
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 namespace Vulkan {
+	class Buffer;
 	class CommandPool;
+	class DeviceMemory;
 }
 
 namespace Assets
 {
 	class TextureImage;
+	struct LightAlias;
 	
 	class GlobalTexturePool final
 	{
@@ -31,6 +35,10 @@ namespace Assets
 		uint32_t RequestNewTextureMemAsync(const std::string& texname, bool hdr, const unsigned char* data, size_t bytelength);
 
 		uint32_t TotalTextures() const {return static_cast<uint32_t>(textureImages_.size());}
+
+		// ENVIRONMENT_TABLE_SLOTS importance sampling tables, one per hdri loaded from file under those texture indices
+		const Vulkan::Buffer& EnvironmentTableBuffer() const;
+		bool HasEnvironmentTable(uint32_t textureIdx) const;
 		
 		static GlobalTexturePool* GetInstance() {return instance_;}
 		static uint32_t LoadTexture(const std::string& texname, const unsigned char* data, size_t bytelength, const Vulkan::SamplerConfig& samplerConfig);
@@ -40,8 +48,15 @@ namespace Assets
 		static void UpdateHDRTexture(uint32_t idx, const std::string& filename, const Vulkan::SamplerConfig& samplerConfig);
 
 		static TextureImage* GetTextureImage(uint32_t idx);
+
+		// without a pool (no device) the static loaders hand the textures to this instead, data is null for files
+		using OfflineLoader = std::function<uint32_t(const std::string& name, const unsigned char* data, size_t bytelength, bool hdr)>;
+		static void SetOfflineLoader(OfflineLoader loader) { offlineLoader_ = std::move(loader); }
 	private:
+		void UploadEnvironmentTable(uint32_t textureIdx, const std::vector<LightAlias>& table);
+
 		static GlobalTexturePool* instance_;
+		static OfflineLoader offlineLoader_;
 
 		const class Vulkan::Device& device_;
 		Vulkan::CommandPool& commandPool_;
@@ -53,6 +68,10 @@ namespace Assets
 
 		std::vector<std::unique_ptr<TextureImage>> textureImages_;
 		std::unordered_map<std::string, uint32_t> textureNameMap_;
+
+		std::unique_ptr<Vulkan::Buffer> environmentTableBuffer_;
+		std::unique_ptr<Vulkan::DeviceMemory> environmentTableBufferMemory_;
+		std::vector<bool> environmentTables_;
 	};
 
 }
@@ -15,6 +15,7 @@ TextureImage::TextureImage(Vulkan::CommandPool& commandPool, size_t width, size_
 	const VkDeviceSize imageSize = width * height * (hdr ? 16 : 4);
 	const auto& device = commandPool.Device();
 
+	Vulkan::MemoryScope memoryScope(Vulkan::EMemoryCategory::Staging, "texture upload");
 	auto stagingBuffer = std::make_unique<Vulkan::Buffer>(device, imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
 	auto stagingBufferMemory = stagingBuffer->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
@@ -23,6 +24,7 @@ TextureImage::TextureImage(Vulkan::CommandPool& commandPool, size_t width, size_
 	stagingBufferMemory.Unmap();
 	
 	// Create the device side image, memory, view and sampler.
+	Vulkan::MemoryScope imageMemoryScope(Vulkan::EMemoryCategory::Texture, "textures");
 	image_.reset(new Vulkan::Image(device, VkExtent2D{ static_cast<uint32_t>(width), static_cast<uint32_t>(height) }, hdr ? VK_FORMAT_R32G32B32A32_SFLOAT : VK_FORMAT_R8G8B8A8_UNORM));
 	imageMemory_.reset(new Vulkan::DeviceMemory(image_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
 	imageView_.reset(new Vulkan::ImageView(device, image_->Handle(), image_->Format(), VK_IMAGE_ASPECT_COLOR_BIT));
@@ -8,6 +8,7 @@ UniformBuffer::UniformBuffer(const Vulkan::Device& device)
 {
 	const auto bufferSize = sizeof(UniformBufferObject);
 
+	Vulkan::MemoryScope memoryScope(Vulkan::EMemoryCategory::Uniform, "uniform buffer");
 	buffer_.reset(new Vulkan::Buffer(device, bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT));
 	memory_.reset(new Vulkan::DeviceMemory(buffer_->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)));
 }
@@ -35,6 +36,7 @@ RayCastBuffer::RayCastBuffer(const Vulkan::Device& device)
 {
 	const auto bufferSize = sizeof(RayCastIO);
 
+	Vulkan::MemoryScope memoryScope(Vulkan::EMemoryCategory::Uniform, "ray cast");
 	buffer_.reset(new Vulkan::Buffer(device, bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
 	memory_.reset(new Vulkan::DeviceMemory(buffer_->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)));
 }
@@ -61,4 +63,38 @@ void RayCastBuffer::SyncWithGPU()
 	std::memcpy(data, &rayCastIO, sizeof(rayCastIO));
 	memory_->Unmap();
 }
+
+RayStatisticsBuffer::RayStatisticsBuffer(const Vulkan::Device& device)
+{
+	const auto bufferSize = sizeof(RayStatistics);
+
+	Vulkan::MemoryScope memoryScope(Vulkan::EMemoryCategory::Uniform, "ray statistics");
+	buffer_.reset(new Vulkan::Buffer(device, bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT));
+	memory_.reset(new Vulkan::DeviceMemory(buffer_->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)));
+
+	const auto data = memory_->Map(0, bufferSize);
+	std::memset(data, 0, bufferSize);
+	memory_->Unmap();
+}
+
+RayStatisticsBuffer::RayStatisticsBuffer(RayStatisticsBuffer&& other) noexcept :
+	buffer_(other.buffer_.release()),
+	memory_(other.memory_.release())
+{
+}
+
+RayStatisticsBuffer::~RayStatisticsBuffer()
+{
+	buffer_.reset();
+	memory_.reset(); // release memory after bound buffer has been destroyed
+}
+
+RayStatistics RayStatisticsBuffer::Read() const
+{
+	RayStatistics statistics;
+	const auto data = memory_->Map(0, sizeof(RayStatistics));
+	std::memcpy(&statistics, data, sizeof(RayStatistics));
+	memory_->Unmap();
+	return statistics;
+}
 }
@@ -18,6 +18,8 @@ namespace Assets
 
 	#include "../assets/shaders/common/UniformBufferObject.glsl"
 	// struct UniformBufferObject
+	#include "../assets/shaders/common/RayStatistics.glsl"
+	// struct RayStatistics
 		
 	struct alignas(16) LightObject final
 	{
@@ -25,6 +27,32 @@ namespace Assets
 		glm::vec4 p1;
 		glm::vec4 p3;
 		glm::vec4 normal_area;
+		// the DiffuseLight material it emits with
+		uint32_t MaterialIndex;
+		// 1: the triangle p0 p1 p3 of an emissive mesh, 0: the parallelogram spanned from p0 to p1 and p3
+		uint32_t Triangle;
+		uint32_t Reserved1;
+		uint32_t Reserved2;
+	};
+
+	struct alignas(16) LightAlias final
+	{
+		float Probability;
+		uint32_t Alias;
+		float Pdf;
+		float Reserved0;
+	};
+
+	struct alignas(16) LightTreeNode final
+	{
+		glm::vec4 BoundsMin;
+		glm::vec4 BoundsMax;
+		glm::vec3 Axis;
+		uint32_t Child;
+		uint32_t IsLeaf;
+		uint32_t Parent;
+		uint32_t Reserved0;
+		uint32_t Reserved1;
 	};
 
 	class UniformBuffer
@@ -100,4 +128,27 @@ namespace Assets
 		std::unique_ptr<Vulkan::DeviceMemory> memory_;
 	};
 
+	// one per swapchain image like the uniform buffers, cleared on the gpu at the start of the frame
+	class RayStatisticsBuffer
+	{
+	public:
+
+		RayStatisticsBuffer(const RayStatisticsBuffer&) = delete;
+		RayStatisticsBuffer& operator = (const RayStatisticsBuffer&) = delete;
+		RayStatisticsBuffer& operator = (RayStatisticsBuffer&&) = delete;
+
+		explicit RayStatisticsBuffer(const Vulkan::Device& device);
+		RayStatisticsBuffer(RayStatisticsBuffer&& other) noexcept;
+		~RayStatisticsBuffer();
+
+		const Vulkan::Buffer& Buffer() const { return *buffer_; }
+
+		// only valid once the frame that wrote it has retired
+		RayStatistics Read() const;
+
+	private:
+		std::unique_ptr<Vulkan::Buffer> buffer_;
+		std::unique_ptr<Vulkan::DeviceMemory> memory_;
+	};
+
 }
\ No newline at end of file
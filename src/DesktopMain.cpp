@@ -2,6 +2,8 @@
 #include "Utilities/Exception.hpp"
 #include "Options.hpp"
 #include "Runtime/Application.hpp"
+#include "Runtime/AssetAnalyzer.hpp"
+#include "Runtime/DistributedRender.hpp"
 
 #include <fmt/format.h>
 #include <iostream>
@@ -40,6 +42,21 @@ int main(int argc, const char* argv[]) noexcept
 #endif
         }
 
+        // Asset analyzer, cpu side of the loaders only
+        if(!options.AnalyzeFile.empty())
+        {
+            AssetAnalyzer analyzer(options);
+            return analyzer.Run() ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        // Distributed coordinator, spawns the workers and merges their passes, no device of its own
+        if(options.DistributedWorkers > 0)
+        {
+            DistributedCoordinator coordinator(options);
+            coordinator.Run();
+            return EXIT_SUCCESS;
+        }
+
         NextRenderer::PlatformInit();
         
         // Start the application.
@@ -0,0 +1,1019 @@
+#include "Options.hpp"
+#include "Assets/LightSampler.hpp"
+#include "Assets/Model.hpp"
+#include "Assets/RadianceCache.hpp"
+#include "Assets/Scene.hpp"
+#include "Assets/SobolSampler.hpp"
+#include "Assets/Texture.hpp"
+#include "Runtime/Application.hpp"
+#include "Runtime/ScreenCapture.hpp"
+#include "Runtime/TaskCoordinator.hpp"
+#include "Utilities/Console.hpp"
+#include "Utilities/Exception.hpp"
+#include "Utilities/FileHelper.hpp"
+#include "Utilities/Profiler.hpp"
+#include "Utilities/StbImage.hpp"
+#include "ThirdParty/json11/json11.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+#include <boost/program_options.hpp>
+#include <fmt/format.h>
+
+// the loaders read nothing from it, kept for the shared sources that declare it
+const Options* GOption = nullptr;
+
+// CPU micro benchmarks of the loader and runtime hot paths on the bundled assets, no vulkan device involved. Every
+// case runs its warm-up iterations, then the measured ones, and reports min / median / mean / stddev / p95 and the
+// relative 95% confidence interval of the mean, so two runs can be compared before trusting a difference.
+namespace
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	double Milliseconds(Clock::time_point begin, Clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end - begin).count();
+	}
+
+	struct Settings
+	{
+		uint32_t Warmup;
+		uint32_t Iterations;
+		std::string Filter;
+		std::string Output;
+	};
+
+	class Harness final
+	{
+	public:
+		explicit Harness(const Settings& settings) : settings_(settings) {}
+
+		bool Enabled(const std::string& name) const
+		{
+			return settings_.Filter.empty() || name.find(settings_.Filter) != std::string::npos;
+		}
+
+		// calls the iteration warm-up + measured times, it is told which ones count
+		void Repeat(const std::function<void(bool measured)>& iteration) const
+		{
+			for (uint32_t i = 0; i < settings_.Warmup + settings_.Iterations; ++i)
+			{
+				iteration(i >= settings_.Warmup);
+			}
+		}
+
+		// the body returns the milliseconds of one iteration, so it can keep its own setup out of the measurement
+		void Run(const std::string& name, double items, const char* unit, const std::function<double()>& body)
+		{
+			if (!Enabled(name)) return;
+			Repeat([&](bool measured)
+			{
+				const double time = body();
+				if (measured) Record(name, items, unit, time);
+			});
+			Print(name);
+		}
+
+		void Record(const std::string& name, double items, const char* unit, double milliseconds)
+		{
+			if (!Enabled(name)) return;
+			auto it = std::find_if(cases_.begin(), cases_.end(), [&name](const Case& c) { return c.Name == name; });
+			if (it == cases_.end())
+			{
+				cases_.push_back({name, unit, items, {}});
+				it = std::prev(cases_.end());
+			}
+			it->Samples.push_back(milliseconds);
+		}
+
+		void Print(const std::string& name) const
+		{
+			for (const Case& c : cases_)
+			{
+				if (c.Name != name) continue;
+				const Statistics stats = Summarize(c);
+				fmt::print("{:<40} median {:9.3f}ms  min {:9.3f}ms  p95 {:9.3f}ms  ci95 {:5.2f}%  {:10.2f} M{}/s\n",
+					c.Name, stats.Median, stats.Min, stats.P95, stats.Ci95 * 100.0, stats.Rate * 1e-6, c.Unit);
+			}
+		}
+
+		json11::Json Report() const
+		{
+			json11::Json::array cases;
+			for (const Case& c : cases_)
+			{
+				const Statistics stats = Summarize(c);
+				cases.push_back(json11::Json::object{
+					{"name", c.Name},
+					{"unit", c.Unit},
+					{"items", c.Items},
+					{"samples", static_cast<int>(c.Samples.size())},
+					{"min_ms", stats.Min},
+					{"median_ms", stats.Median},
+					{"mean_ms", stats.Mean},
+					{"stddev_ms", stats.Stddev},
+					{"p95_ms", stats.P95},
+					{"ci95", stats.Ci95},
+					{"items_per_second", stats.Rate},
+				});
+			}
+			return json11::Json::object{
+				{"version", NextRenderer::GetBuildVersion()},
+				{"warmup", static_cast<int>(settings_.Warmup)},
+				{"iterations", static_cast<int>(settings_.Iterations)},
+				{"filter", settings_.Filter},
+				{"cases", cases},
+			};
+		}
+
+	private:
+		struct Case
+		{
+			std::string Name;
+			std::string Unit;
+			// work items of one iteration, the rate is taken at the median
+			double Items;
+			std::vector<double> Samples;
+		};
+
+		struct Statistics
+		{
+			double Min;
+			double Median;
+			double Mean;
+			double Stddev;
+			double P95;
+			double Ci95;
+			double Rate;
+		};
+
+		static Statistics Summarize(const Case& c)
+		{
+			Statistics stats{};
+			std::vector<double> sorted = c.Samples;
+			std::sort(sorted.begin(), sorted.end());
+			const size_t n = sorted.size();
+			if (n == 0) return stats;
+
+			stats.Min = sorted.front();
+			stats.Median = n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) * 0.5;
+			stats.Mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / n;
+			stats.P95 = sorted[std::min(n - 1, static_cast<size_t>(std::ceil(0.95 * n)) - 1)];
+			if (n > 1)
+			{
+				double variance = 0;
+				for (double sample : sorted) variance += (sample - stats.Mean) * (sample - stats.Mean);
+				stats.Stddev = std::sqrt(variance / (n - 1));
+				stats.Ci95 = stats.Mean > 0 ? 1.96 * stats.Stddev / std::sqrt(static_cast<double>(n)) / stats.Mean : 0;
+			}
+			stats.Rate = stats.Median > 0 ? c.Items / (stats.Median * 1e-3) : 0;
+			return stats;
+		}
+
+		const Settings settings_;
+		std::vector<Case> cases_;
+	};
+
+	struct EncodedTexture
+	{
+		std::vector<uint8_t> Data;
+		bool Hdr;
+	};
+
+	struct LoadedScene
+	{
+		std::string Name;
+		std::vector<Assets::Node> Nodes;
+		std::vector<Assets::Model> Models;
+		std::vector<EncodedTexture> Textures;
+	};
+
+	std::vector<uint8_t> ReadFile(const std::string& filename)
+	{
+		std::ifstream file(filename, std::ios::binary);
+		return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	uint64_t TriangleCount(const std::vector<Assets::Model>& models)
+	{
+		uint64_t indices = 0;
+		for (const auto& model : models) indices += model.NumberOfIndices();
+		return indices / 3;
+	}
+
+	// LoadGLTFScene split at its "gltf parse" scope: tinygltf parsing versus the vertex conversion around it.
+	// Textures are only copied out through the offline loader, their decode is a case of its own
+	void BenchGltf(Harness& harness, const std::string& path, LoadedScene& scene)
+	{
+		const std::string parseName = "gltf parse/" + scene.Name;
+		const std::string convertName = "gltf convert/" + scene.Name;
+		if (!harness.Enabled(parseName) && !harness.Enabled(convertName) && !harness.Enabled("stb decode/" + scene.Name)
+			&& !harness.Enabled("scene batching/" + scene.Name) && !harness.Enabled("flatten vertices/" + scene.Name))
+		{
+			return;
+		}
+
+		bool keep = true;
+		Assets::GlobalTexturePool::SetOfflineLoader([&scene, &keep](const std::string&, const unsigned char* data, size_t bytelength, bool hdr)
+		{
+			if (keep) scene.Textures.push_back({std::vector<uint8_t>(data, data + bytelength), hdr});
+			return static_cast<uint32_t>(scene.Textures.size());
+		});
+
+		const uint32_t parseId = Utilities::Profiler::Intern("gltf parse");
+		std::vector<Utilities::Profiler::Event> events;
+		harness.Repeat([&](bool measured)
+		{
+			Assets::CameraInitialSate camera{};
+			std::vector<Assets::Node> nodes;
+			std::vector<Assets::Model> models;
+			std::vector<Assets::Material> materials;
+			std::vector<Assets::LightObject> lights;
+
+			const int64_t profileBegin = Utilities::Profiler::Now();
+			const auto begin = Clock::now();
+			Assets::Model::LoadGLTFScene(path, camera, nodes, models, materials, lights);
+			const double total = Milliseconds(begin, Clock::now());
+
+			events.clear();
+			Utilities::Profiler::ThreadTrack().Collect(profileBegin, Utilities::Profiler::Now(), events);
+			double parse = 0;
+			for (const auto& event : events)
+			{
+				if (event.Id == parseId) parse += (event.End - event.Begin) * 1e-6;
+			}
+
+			const double triangles = static_cast<double>(TriangleCount(models));
+			if (measured)
+			{
+				harness.Record(parseName, triangles, "tri", parse);
+				harness.Record(convertName, triangles, "tri", total - parse);
+			}
+			if (keep)
+			{
+				scene.Nodes = std::move(nodes);
+				scene.Models = std::move(models);
+				keep = false;
+			}
+		});
+		Assets::GlobalTexturePool::SetOfflineLoader(nullptr);
+
+		harness.Print(parseName);
+		harness.Print(convertName);
+	}
+
+	struct VertexHash
+	{
+		size_t operator()(const Assets::Vertex& vertex) const
+		{
+			// the fields operator== compares, tangents are derived
+			uint64_t hash = 14695981039346656037ull;
+			const auto mix = [&hash](const void* data, size_t size)
+			{
+				const auto* bytes = static_cast<const uint8_t*>(data);
+				for (size_t i = 0; i < size; ++i) hash = (hash ^ bytes[i]) * 1099511628211ull;
+			};
+			mix(&vertex.Position, sizeof(vertex.Position));
+			mix(&vertex.Normal, sizeof(vertex.Normal));
+			mix(&vertex.TexCoord, sizeof(vertex.TexCoord));
+			mix(&vertex.MaterialIndex, sizeof(vertex.MaterialIndex));
+			return static_cast<size_t>(hash);
+		}
+	};
+
+	// the loaded models come flattened already, so they are welded back into an indexed mesh to flatten again
+	void BenchFlatten(Harness& harness, const LoadedScene& scene)
+	{
+		const std::string name = "flatten vertices/" + scene.Name;
+		if (!harness.Enabled(name) || scene.Models.empty()) return;
+
+		std::vector<Assets::Vertex> vertices;
+		std::vector<uint32_t> indices;
+		std::unordered_map<Assets::Vertex, uint32_t, VertexHash> unique;
+		for (const auto& model : scene.Models)
+		{
+			for (uint32_t index : model.Indices())
+			{
+				const Assets::Vertex& vertex = model.Vertices()[index];
+				const auto inserted = unique.emplace(vertex, static_cast<uint32_t>(vertices.size()));
+				if (inserted.second) vertices.push_back(vertex);
+				indices.push_back(inserted.first->second);
+			}
+		}
+
+		harness.Run(name, static_cast<double>(indices.size()), "idx", [&]()
+		{
+			std::vector<Assets::Vertex> flatVertices = vertices;
+			std::vector<uint32_t> flatIndices = indices;
+			const auto begin = Clock::now();
+			Assets::Model::FlattenVertices(flatVertices, flatIndices);
+			return Milliseconds(begin, Clock::now());
+		});
+	}
+
+	void BenchSceneBatching(Harness& harness, const LoadedScene& scene)
+	{
+		const std::string name = "scene batching/" + scene.Name;
+		harness.Run(name, static_cast<double>(scene.Nodes.size()), "node", [&]()
+		{
+			std::vector<Assets::NodeProxy> nodeProxys;
+			std::vector<VkDrawIndexedIndirectCommand> indirectDraws;
+			std::vector<uint32_t> instanceCounts;
+			const auto begin = Clock::now();
+			Assets::Scene::BuildDrawBatches(scene.Models, scene.Nodes, nodeProxys, indirectDraws, instanceCounts);
+			return Milliseconds(begin, Clock::now());
+		});
+	}
+
+	void BenchTextureDecode(Harness& harness, const std::string& name, const std::vector<EncodedTexture>& textures)
+	{
+		if (!harness.Enabled(name) || textures.empty()) return;
+
+		// pixels of one pass, probed without decoding
+		double pixels = 0;
+		for (const auto& texture : textures)
+		{
+			int width = 0, height = 0, channels = 0;
+			stbi_info_from_memory(texture.Data.data(), static_cast<int>(texture.Data.size()), &width, &height, &channels);
+			pixels += static_cast<double>(width) * height;
+		}
+
+		// the same calls and forced rgba the texture pool makes
+		harness.Run(name, pixels, "px", [&]()
+		{
+			const auto begin = Clock::now();
+			for (const auto& texture : textures)
+			{
+				int width = 0, height = 0, channels = 0;
+				void* decoded = texture.Hdr
+					? static_cast<void*>(stbi_loadf_from_memory(texture.Data.data(), static_cast<int>(texture.Data.size()), &width, &height, &channels, STBI_rgb_alpha))
+					: static_cast<void*>(stbi_load_from_memory(texture.Data.data(), static_cast<int>(texture.Data.size()), &width, &height, &channels, STBI_rgb_alpha));
+				stbi_image_free(decoded);
+			}
+			return Milliseconds(begin, Clock::now());
+		});
+	}
+
+	// the importance table the texture pool builds per hdri, then sampling it with the pdf of every sampled direction
+	// looked up again and the table's pdfs integrated over the sphere as the check
+	void BenchEnvironmentTable(Harness& harness, const EncodedTexture& hdri)
+	{
+		int width = 0, height = 0, channels = 0;
+		float* pixels = stbi_loadf_from_memory(hdri.Data.data(), static_cast<int>(hdri.Data.size()), &width, &height, &channels, STBI_rgb_alpha);
+		if (pixels == nullptr)
+		{
+			Throw(std::runtime_error("failed to decode hdri"));
+		}
+
+		std::vector<Assets::LightAlias> table;
+		harness.Run("environment table/build", static_cast<double>(width) * height, "px", [&]()
+		{
+			const auto begin = Clock::now();
+			table = Assets::LightSampler::BuildEnvironmentTable(pixels, width, height);
+			return Milliseconds(begin, Clock::now());
+		});
+		stbi_image_free(pixels);
+		if (table.empty())
+		{
+			return;
+		}
+
+		constexpr uint32_t samples = 65536;
+		constexpr float rotation = 0.3f;
+		std::mt19937 random(20241016);
+		std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+		uint32_t mismatches = 0;
+		harness.Run("environment table/sample", samples, "sample", [&]()
+		{
+			mismatches = 0;
+			const auto begin = Clock::now();
+			for (uint32_t i = 0; i < samples; ++i)
+			{
+				float pdf;
+				const glm::vec3 direction = Assets::LightSampler::SampleEnvironment(table, rotation, glm::vec3(uniform(random), uniform(random), uniform(random)), pdf);
+				if (pdf > 0 && std::abs(pdf - Assets::LightSampler::EnvironmentPdf(table, rotation, direction)) > 1e-3f * pdf) mismatches++;
+			}
+			return Milliseconds(begin, Clock::now());
+		});
+
+		// uniform directions over the sphere estimate the integral of the pdf, which has to come out at 1
+		constexpr uint32_t directions = 1 << 20;
+		constexpr double pi = 3.14159265358979;
+		double integral = 0;
+		for (uint32_t i = 0; i < directions; ++i)
+		{
+			const float z = 1.0f - 2.0f * uniform(random);
+			const float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+			const float phi = static_cast<float>(2.0 * pi) * uniform(random);
+			integral += Assets::LightSampler::EnvironmentPdf(table, rotation, glm::vec3(r * std::cos(phi), z, r * std::sin(phi)));
+		}
+		integral *= 4.0 * pi / directions;
+
+		// a sample on a cell edge may round into the neighbour, a handful per run is expected
+		fmt::print("{} environment table: pdf mismatches {} of {}, pdf integral {:.4f}{}\n", CONSOLE_GREEN_COLOR, mismatches, samples, integral, CONSOLE_DEFAULT_COLOR);
+		if (mismatches > samples / 1000 || std::abs(integral - 1.0) > 0.01)
+		{
+			Throw(std::runtime_error("environment table sampling disagrees with its pdf"));
+		}
+	}
+
+	// no obj is bundled, so a grid with shared positions, normals and uvs stands in; every interior vertex is
+	// referenced by six triangles, which is what the dedup map has to fold
+	std::string WriteGridObj(uint32_t quads)
+	{
+		const std::string filename = (std::filesystem::temp_directory_path() / fmt::format("microbench_grid_{}.obj", quads)).string();
+		std::ofstream file(filename, std::ios::out | std::ios::trunc);
+		for (uint32_t y = 0; y <= quads; ++y)
+		{
+			for (uint32_t x = 0; x <= quads; ++x)
+			{
+				const float u = static_cast<float>(x) / quads;
+				const float v = static_cast<float>(y) / quads;
+				file << fmt::format("v {} {} {}\nvt {} {}\nvn 0 1 0\n", u * 10.f - 5.f, std::sin(u * 12.f) * std::cos(v * 12.f) * 0.2f, v * 10.f - 5.f, u, v);
+			}
+		}
+		for (uint32_t y = 0; y < quads; ++y)
+		{
+			for (uint32_t x = 0; x < quads; ++x)
+			{
+				const uint32_t i0 = y * (quads + 1) + x + 1;
+				const uint32_t i1 = i0 + 1;
+				const uint32_t i2 = i0 + quads + 1;
+				const uint32_t i3 = i2 + 1;
+				file << fmt::format("f {0}/{0}/{0} {2}/{2}/{2} {1}/{1}/{1}\nf {1}/{1}/{1} {2}/{2}/{2} {3}/{3}/{3}\n", i0, i1, i2, i3);
+			}
+		}
+		return filename;
+	}
+
+	void BenchObj(Harness& harness)
+	{
+		constexpr uint32_t quads = 256;
+		const std::string name = "obj load/grid";
+		if (!harness.Enabled(name)) return;
+
+		const std::string filename = WriteGridObj(quads);
+		harness.Run(name, quads * quads * 2.0, "tri", [&]()
+		{
+			std::vector<Assets::Node> nodes;
+			std::vector<Assets::Model> models;
+			std::vector<Assets::Material> materials;
+			std::vector<Assets::LightObject> lights;
+			const auto begin = Clock::now();
+			Assets::Model::LoadObjModel(filename, nodes, models, materials, lights);
+			return Milliseconds(begin, Clock::now());
+		});
+		std::filesystem::remove(filename);
+	}
+
+	// the task threads poll their queues with a 1ms sleep when idle, which is what the latency case sees
+	void BenchTaskCoordinator(Harness& harness)
+	{
+		TaskCoordinator* coordinator = TaskCoordinator::GetInstance();
+
+		constexpr uint32_t taskCount = 4096;
+		harness.Run("task coordinator/throughput", taskCount, "task", [&]()
+		{
+			std::atomic<uint32_t> executed{};
+			const auto begin = Clock::now();
+			for (uint32_t i = 0; i < taskCount; ++i)
+			{
+				coordinator->AddTask([&executed](ResTask&) { executed++; }, [](ResTask&) {}, static_cast<uint8_t>(i % 4));
+			}
+			while (!coordinator->IsIdle())
+			{
+				coordinator->Tick();
+			}
+			return Milliseconds(begin, Clock::now());
+		});
+
+		// one task at a time from AddTask to its completion on the calling thread, averaged over a batch
+		constexpr uint32_t roundTrips = 32;
+		harness.Run("task coordinator/latency", roundTrips, "task", [&]()
+		{
+			const auto begin = Clock::now();
+			for (uint32_t i = 0; i < roundTrips; ++i)
+			{
+				coordinator->AddTask([](ResTask&) {}, [](ResTask&) {}, static_cast<uint8_t>(i % 4));
+				while (!coordinator->IsIdle())
+				{
+					coordinator->Tick();
+				}
+			}
+			return Milliseconds(begin, Clock::now());
+		});
+	}
+
+	// alias table selection over 1024 lamps of random power, every eighth one switched off: the picked frequencies have
+	// to match the table's pdfs, lamps without power are never picked, and a single lamp or a scene without any power
+	// still gets a valid table
+	void BenchLightAlias(Harness& harness)
+	{
+		constexpr uint32_t count = 1024;
+		std::mt19937 random(20241021);
+		std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+		std::vector<Assets::Material> materials;
+		std::vector<Assets::LightObject> lights;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const float power = i % 8 == 0 ? 0.0f : 1.0f + 99.0f * uniform(random);
+			materials.push_back(Assets::Material::DiffuseLight(glm::vec3(power)));
+
+			Assets::LightObject light{};
+			light.normal_area = glm::vec4(0, -1, 0, 0.25f + uniform(random));
+			light.MaterialIndex = i;
+			lights.push_back(light);
+		}
+
+		std::vector<Assets::LightAlias> table;
+		harness.Run("light alias/build", count, "light", [&]()
+		{
+			const auto begin = Clock::now();
+			table = Assets::LightSampler::BuildAliasTable(lights, materials);
+			return Milliseconds(begin, Clock::now());
+		});
+		if (table.size() != count)
+		{
+			return;
+		}
+
+		constexpr uint32_t samples = 1 << 20;
+		std::vector<uint64_t> picks(count);
+		uint64_t draws = 0;
+		uint32_t pdfMismatches = 0;
+		harness.Run("light alias/sample", samples, "sample", [&]()
+		{
+			const auto begin = Clock::now();
+			for (uint32_t i = 0; i < samples; ++i)
+			{
+				float pdf;
+				const uint32_t light = Assets::LightSampler::Sample(table, uniform(random), pdf);
+				picks[light]++;
+				if (pdf <= 0 || pdf != table[light].Pdf) pdfMismatches++;
+			}
+			draws += samples;
+			return Milliseconds(begin, Clock::now());
+		});
+
+		// every lamp's count against its binomial spread, 6 sigma keeps 1024 of them from failing by chance
+		uint32_t outliers = 0;
+		uint32_t darkPicked = 0;
+		double total = 0;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const double pdf = table[i].Pdf;
+			total += pdf;
+			if (i % 8 == 0)
+			{
+				darkPicked += picks[i] != 0 || pdf != 0 ? 1 : 0;
+				continue;
+			}
+			const double expected = pdf * static_cast<double>(draws);
+			if (std::abs(static_cast<double>(picks[i]) - expected) > 6.0 * std::sqrt(expected * (1.0 - pdf)) + 1.0) outliers++;
+		}
+
+		// a single lamp and four lamps without power, the latter fall back to a uniform pick
+		uint32_t degenerate = 0;
+		const std::vector<Assets::LightAlias> single = Assets::LightSampler::BuildAliasTable({lights[1]}, materials);
+		const std::vector<Assets::LightAlias> dark = Assets::LightSampler::BuildAliasTable({lights[0], lights[8], lights[16], lights[24]}, materials);
+		for (float u : {0.0f, 0.3f, 0.5f, std::nextafter(1.0f, 0.0f)})
+		{
+			float pdf;
+			if (single.size() != 1 || Assets::LightSampler::Sample(single, u, pdf) != 0 || pdf != 1.0f) degenerate++;
+			if (dark.size() != 4 || Assets::LightSampler::Sample(dark, u, pdf) != static_cast<uint32_t>(u * 4.0f) || pdf != 0.25f) degenerate++;
+		}
+
+		fmt::print("{} light alias: {} of {} lamps off their pdf, {} dark lamps picked, pdf mismatches {}, pdf sum {:.6f}, {} degenerate failures{}\n",
+			CONSOLE_GREEN_COLOR, outliers, count, darkPicked, pdfMismatches, total, degenerate, CONSOLE_DEFAULT_COLOR);
+		if (outliers > 0 || darkPicked > 0 || pdfMismatches > 0 || std::abs(total - 1.0) > 1e-4 || degenerate > 0)
+		{
+			Throw(std::runtime_error("light alias table sampling disagrees with its pdf"));
+		}
+	}
+
+	// a 64x64 grid of ceiling lamps of varying power, the sampling case also checks the traversal against the pdf walked
+	// up from each picked leaf and that the pdfs of one receiver sum to at most 1
+	void BenchLightTree(Harness& harness)
+	{
+		constexpr uint32_t side = 64;
+		std::mt19937 random(20241015);
+		std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+		std::vector<Assets::Material> materials;
+		std::vector<Assets::LightObject> lights;
+		for (uint32_t i = 0; i < side * side; ++i)
+		{
+			const float power = 1.0f + 99.0f * uniform(random);
+			materials.push_back(Assets::Material::DiffuseLight(glm::vec3(power)));
+
+			const glm::vec3 origin(static_cast<float>(i % side) * 2.0f, 10.0f, static_cast<float>(i / side) * 2.0f);
+			Assets::LightObject light{};
+			light.p0 = glm::vec4(origin, 1);
+			light.p1 = glm::vec4(origin + glm::vec3(0.5f, 0, 0), 1);
+			light.p3 = glm::vec4(origin + glm::vec3(0, 0, 0.5f), 1);
+			light.normal_area = glm::vec4(0, -1, 0, 0.25f);
+			light.MaterialIndex = i;
+			lights.push_back(light);
+		}
+
+		std::vector<Assets::LightTreeNode> tree;
+		harness.Run("light tree/build", static_cast<double>(lights.size()), "light", [&]()
+		{
+			const auto begin = Clock::now();
+			tree = Assets::LightSampler::BuildTree(lights, materials);
+			return Milliseconds(begin, Clock::now());
+		});
+		if (tree.empty())
+		{
+			return;
+		}
+
+		constexpr uint32_t samples = 16384;
+		float mismatch = 0;
+		harness.Run("light tree/sample", samples, "sample", [&]()
+		{
+			const auto begin = Clock::now();
+			for (uint32_t i = 0; i < samples; ++i)
+			{
+				const glm::vec3 position(uniform(random) * side * 2.0f, 0.0f, uniform(random) * side * 2.0f);
+				float pdf;
+				const uint32_t light = Assets::LightSampler::SampleTree(tree, position, glm::vec3(0, 1, 0), uniform(random), pdf);
+				if (i % 256 == 0 && pdf > 0)
+				{
+					mismatch = std::max(mismatch, std::abs(pdf - Assets::LightSampler::TreePdf(tree, position, glm::vec3(0, 1, 0), light)) / pdf);
+				}
+			}
+			return Milliseconds(begin, Clock::now());
+		});
+
+		double total = 0;
+		for (uint32_t i = 0; i < lights.size(); ++i)
+		{
+			total += Assets::LightSampler::TreePdf(tree, glm::vec3(side, 0, side), glm::vec3(0, 1, 0), i);
+		}
+		fmt::print("{} light tree: {} nodes, pdf mismatch {:.2e}, pdf sum {:.6f}{}\n", CONSOLE_GREEN_COLOR, tree.size(), mismatch, total, CONSOLE_DEFAULT_COLOR);
+		if (mismatch > 1e-3f || total > 1.0 + 1e-3)
+		{
+			Throw(std::runtime_error("light tree sampling disagrees with its pdf"));
+		}
+	}
+
+	// every 2^a x 2^(m - a) box of the unit square holds exactly one of the 2^m points
+	bool IsNet(const std::vector<glm::vec2>& points, uint32_t m)
+	{
+		for (uint32_t a = 0; a <= m; ++a)
+		{
+			std::vector<uint32_t> boxes(size_t(1) << m);
+			for (const glm::vec2& point : points)
+			{
+				const uint32_t x = static_cast<uint32_t>(point.x * static_cast<float>(1u << a));
+				const uint32_t y = static_cast<uint32_t>(point.y * static_cast<float>(1u << (m - a)));
+				if (++boxes[x << (m - a) | y] > 1) return false;
+			}
+		}
+		return true;
+	}
+
+	// the sobol sampler's tables and draws, then the stratification the shader relies on: in every padded pair of
+	// dimensions the frames of one pixel and the pixels of one ranking tile at one frame each form a (0,m,2)-net
+	void BenchSobolSampler(Harness& harness)
+	{
+		std::vector<uint32_t> tables;
+		harness.Run("sobol sampler/build", SAMPLER_RANK_TILE * SAMPLER_RANK_TILE, "px", [&]()
+		{
+			const auto begin = Clock::now();
+			tables = Assets::SobolSampler::BuildTables();
+			return Milliseconds(begin, Clock::now());
+		});
+		if (tables.empty())
+		{
+			return;
+		}
+
+		constexpr uint32_t frameBits = 6;
+		constexpr uint32_t pairs = 3;
+		constexpr uint32_t tilePixels = SAMPLER_RANK_TILE * SAMPLER_RANK_TILE;
+		std::vector<std::vector<glm::vec2>> points(pairs, std::vector<glm::vec2>(tilePixels << frameBits));
+		harness.Run("sobol sampler/sample", static_cast<double>(points.size() * points[0].size() * 2), "sample", [&]()
+		{
+			const auto begin = Clock::now();
+			for (uint32_t pair = 0; pair < pairs; ++pair)
+			{
+				for (uint32_t i = 0; i < points[pair].size(); ++i)
+				{
+					// pixel major over a tile away from the origin
+					const uint32_t x = SAMPLER_RANK_TILE + (i >> frameBits) % SAMPLER_RANK_TILE;
+					const uint32_t y = 2 * SAMPLER_RANK_TILE + (i >> frameBits) / SAMPLER_RANK_TILE;
+					const uint32_t frame = i & ((1u << frameBits) - 1);
+					points[pair][i] = glm::vec2(Assets::SobolSampler::Sample(tables, x, y, frame, pair * 2), Assets::SobolSampler::Sample(tables, x, y, frame, pair * 2 + 1));
+				}
+			}
+			return Milliseconds(begin, Clock::now());
+		});
+
+		uint32_t tileBits = 0;
+		while ((1u << tileBits) < tilePixels) tileBits++;
+
+		uint32_t checks = 0;
+		uint32_t failures = 0;
+		for (const auto& pairPoints : points)
+		{
+			for (uint32_t pixel = 0; pixel < tilePixels; pixel += 97, ++checks)
+			{
+				const auto first = pairPoints.begin() + (pixel << frameBits);
+				if (!IsNet(std::vector<glm::vec2>(first, first + (1u << frameBits)), frameBits)) failures++;
+			}
+			for (uint32_t frame : {0u, 1u, 37u})
+			{
+				std::vector<glm::vec2> tile(tilePixels);
+				for (uint32_t pixel = 0; pixel < tilePixels; ++pixel) tile[pixel] = pairPoints[(pixel << frameBits) + frame];
+				if (!IsNet(tile, tileBits)) failures++;
+				checks++;
+			}
+		}
+
+		fmt::print("{} sobol sampler: {} of {} point sets not stratified{}\n", CONSOLE_GREEN_COLOR, failures, checks, CONSOLE_DEFAULT_COLOR);
+		if (failures > 0)
+		{
+			Throw(std::runtime_error("sobol sampler lost its stratification"));
+		}
+	}
+
+	// the radiance cache's cpu reference inside a 2m box seen from its center, each wall leaving its own radiance. Noisy
+	// samples have to converge to it in every cell, then with only the floor updated the other walls have to outlive
+	// RADIANCE_CACHE_MAX_AGE resolves and be gone after one more
+	void BenchRadianceCache(Harness& harness)
+	{
+		struct Wall
+		{
+			glm::vec3 Origin;
+			glm::vec3 U;
+			glm::vec3 V;
+			glm::vec3 Normal;
+			glm::vec3 Radiance;
+		};
+		const std::vector<Wall> walls = {
+			{{-1, 0, -1}, {2, 0, 0}, {0, 0, 2}, {0, 1, 0}, {1.0f, 0.8f, 0.6f}},
+			{{-1, 2, -1}, {2, 0, 0}, {0, 0, 2}, {0, -1, 0}, {0.2f, 0.2f, 0.3f}},
+			{{-1, 0, -1}, {0, 2, 0}, {0, 0, 2}, {1, 0, 0}, {4.0f, 1.0f, 1.0f}},
+			{{1, 0, -1}, {0, 2, 0}, {0, 0, 2}, {-1, 0, 0}, {1.0f, 4.0f, 1.0f}},
+			{{-1, 0, -1}, {2, 0, 0}, {0, 2, 0}, {0, 0, 1}, {1.0f, 1.0f, 4.0f}},
+			{{-1, 0, 1}, {2, 0, 0}, {0, 2, 0}, {0, 0, -1}, {20.0f, 20.0f, 20.0f}},
+		};
+		const glm::vec3 camera(0, 1, 0);
+		std::mt19937 random(20250108);
+		std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+		std::vector<Assets::RadianceCacheEntry> entries(RADIANCE_CACHE_SIZE);
+
+		// hits spread over the first wallCount walls, each sampling its radiance off by up to half of it
+		const auto update = [&](uint32_t wallCount, uint32_t samples)
+		{
+			for (uint32_t i = 0; i < samples; ++i)
+			{
+				const Wall& wall = walls[i % wallCount];
+				const glm::vec3 position = wall.Origin + wall.U * uniform(random) + wall.V * uniform(random);
+				const uint32_t slot = Assets::RadianceCache::Insert(entries, Assets::RadianceCache::Key(position, wall.Normal, camera));
+				if (slot < RADIANCE_CACHE_SIZE)
+				{
+					Assets::RadianceCache::Accumulate(entries, slot, wall.Radiance * (0.5f + uniform(random)));
+				}
+			}
+		};
+
+		constexpr uint32_t samplesPerFrame = 1 << 17;
+		harness.Run("radiance cache/update", samplesPerFrame, "sample", [&]()
+		{
+			const auto begin = Clock::now();
+			update(static_cast<uint32_t>(walls.size()), samplesPerFrame);
+			return Milliseconds(begin, Clock::now());
+		});
+		harness.Run("radiance cache/resolve", RADIANCE_CACHE_SIZE, "slot", [&]()
+		{
+			const auto begin = Clock::now();
+			Assets::RadianceCache::Resolve(entries);
+			return Milliseconds(begin, Clock::now());
+		});
+
+		// the checks start from an empty cache, the timed runs left it in whatever state their iteration count gives
+		entries.assign(RADIANCE_CACHE_SIZE, Assets::RadianceCacheEntry{});
+		for (uint32_t frame = 0; frame < 32; ++frame)
+		{
+			update(static_cast<uint32_t>(walls.size()), samplesPerFrame);
+			Assets::RadianceCache::Resolve(entries);
+		}
+
+		// the cells answering queries at a 64 x 64 grid of points on the wall, RADIANCE_CACHE_SIZE for the ones that don't
+		constexpr uint32_t probeSide = 64;
+		const auto probe = [&](const Wall& wall, uint32_t i)
+		{
+			const float u = (static_cast<float>(i % probeSide) + 0.5f) / probeSide;
+			const float v = (static_cast<float>(i / probeSide) + 0.5f) / probeSide;
+			const uint32_t slot = Assets::RadianceCache::Find(entries, Assets::RadianceCache::Key(wall.Origin + wall.U * u + wall.V * v, wall.Normal, camera));
+			return slot < RADIANCE_CACHE_SIZE && entries[slot].SampleCount >= RADIANCE_CACHE_MIN_SAMPLES ? slot : RADIANCE_CACHE_SIZE;
+		};
+
+		uint32_t probes = 0;
+		uint32_t missing = 0;
+		double error = 0;
+		double bias = 0;
+		for (const Wall& wall : walls)
+		{
+			for (uint32_t i = 0; i < probeSide * probeSide; ++i, ++probes)
+			{
+				const uint32_t slot = probe(wall, i);
+				if (slot == RADIANCE_CACHE_SIZE)
+				{
+					missing++;
+					continue;
+				}
+				for (int channel = 0; channel < 3; ++channel)
+				{
+					const double relative = (entries[slot].Radiance[channel] - wall.Radiance[channel]) / wall.Radiance[channel];
+					error += std::abs(relative) / 3.0;
+					bias += relative / 3.0;
+				}
+			}
+		}
+		const uint32_t found = probes - missing;
+		error /= std::max(found, 1u);
+		bias /= std::max(found, 1u);
+
+		// only the floor from here on
+		const auto surviving = [&]()
+		{
+			uint32_t count = 0;
+			for (size_t wall = 1; wall < walls.size(); ++wall)
+			{
+				for (uint32_t i = 0; i < probeSide * probeSide; ++i)
+				{
+					if (probe(walls[wall], i) < RADIANCE_CACHE_SIZE) count++;
+				}
+			}
+			return count;
+		};
+		const uint32_t before = surviving();
+		for (uint32_t frame = 0; frame < RADIANCE_CACHE_MAX_AGE; ++frame)
+		{
+			update(1, samplesPerFrame / 4);
+			Assets::RadianceCache::Resolve(entries);
+		}
+		const uint32_t aged = surviving();
+		update(1, samplesPerFrame / 4);
+		Assets::RadianceCache::Resolve(entries);
+		const uint32_t evicted = surviving();
+		uint32_t floorCells = 0;
+		for (uint32_t i = 0; i < probeSide * probeSide; ++i)
+		{
+			if (probe(walls[0], i) < RADIANCE_CACHE_SIZE) floorCells++;
+		}
+
+		fmt::print("{} radiance cache: {} of {} probes missing, mean error {:.2f}%, bias {:+.2f}%, {} of {} stale cells kept for {} frames, {} left after, floor {} of {}{}\n",
+			CONSOLE_GREEN_COLOR, missing, probes, error * 100.0, bias * 100.0, aged, before, RADIANCE_CACHE_MAX_AGE, evicted, floorCells, probeSide * probeSide, CONSOLE_DEFAULT_COLOR);
+		if (missing > probes / 100 || error > 0.05 || std::abs(bias) > 0.01)
+		{
+			Throw(std::runtime_error("radiance cache did not converge to the radiance it was fed"));
+		}
+		if (aged != before || evicted != 0 || floorCells != probeSide * probeSide)
+		{
+			Throw(std::runtime_error("radiance cache evicted the wrong cells"));
+		}
+	}
+
+	void BenchScreenCapture(Harness& harness)
+	{
+		constexpr size_t width = 1920;
+		constexpr size_t height = 1080;
+		constexpr size_t pixelCount = width * height;
+
+		// fixed seed, every run converts the same texels
+		std::vector<uint8_t> texels(pixelCount * 4);
+		std::mt19937 random(20241014);
+		std::generate(texels.begin(), texels.end(), [&random]() { return static_cast<uint8_t>(random()); });
+
+		std::vector<uint8_t> pixels;
+		const auto convert = [&](VkFormat format, bool sdr)
+		{
+			return [&, format, sdr]()
+			{
+				const auto begin = Clock::now();
+				if (sdr)
+				{
+					ScreenCapture::ConvertSwapChainToSdr(format, texels.data(), pixelCount, pixels);
+				}
+				else
+				{
+					ScreenCapture::ConvertSwapChainPixels(format, texels.data(), pixelCount, pixels);
+				}
+				return Milliseconds(begin, Clock::now());
+			};
+		};
+
+		harness.Run("screenshot/bgra8", pixelCount, "px", convert(VK_FORMAT_B8G8R8A8_UNORM, false));
+		harness.Run("screenshot/a2r10g10b10", pixelCount, "px", convert(VK_FORMAT_A2R10G10B10_UNORM_PACK32, false));
+		harness.Run("screenshot sdr/bgra8", pixelCount, "px", convert(VK_FORMAT_B8G8R8A8_UNORM, true));
+		harness.Run("screenshot sdr/a2r10g10b10", pixelCount, "px", convert(VK_FORMAT_A2R10G10B10_UNORM_PACK32, true));
+	}
+}
+
+int main(int argc, const char* argv[]) noexcept
+{
+	try
+	{
+		using namespace boost::program_options;
+
+		Settings settings{};
+		options_description desc("Micro benchmark options", 120);
+		desc.add_options()
+			("help", "Display help message.")
+			("warmup", value<uint32_t>(&settings.Warmup)->default_value(3), "Iterations run before measuring each case.")
+			("iterations", value<uint32_t>(&settings.Iterations)->default_value(20), "Measured iterations of each case.")
+			("filter", value<std::string>(&settings.Filter)->default_value(""), "Only run the cases whose name contains this.")
+			("output", value<std::string>(&settings.Output)->default_value("microbench.json"), "The json report.")
+			;
+
+		variables_map vm;
+		store(command_line_parser(argc, argv).options(desc).run(), vm);
+		notify(vm);
+		if (vm.count("help"))
+		{
+			std::cout << desc << std::endl;
+			return EXIT_SUCCESS;
+		}
+		if (settings.Iterations == 0)
+		{
+			Throw(std::out_of_range("iterations must be at least 1"));
+		}
+
+		Harness harness(settings);
+
+		std::vector<std::string> scenes;
+		for (const auto& entry : std::filesystem::directory_iterator(Utilities::FileHelper::GetPlatformFilePath("assets/models/")))
+		{
+			if (entry.path().extension() == ".glb") scenes.push_back(entry.path().string());
+		}
+		std::sort(scenes.begin(), scenes.end());
+
+		for (const auto& path : scenes)
+		{
+			LoadedScene scene;
+			scene.Name = std::filesystem::path(path).stem().string();
+			BenchGltf(harness, path, scene);
+			BenchFlatten(harness, scene);
+			BenchSceneBatching(harness, scene);
+			BenchTextureDecode(harness, "stb decode/" + scene.Name, scene.Textures);
+		}
+
+		std::vector<EncodedTexture> hdris;
+		for (const char* hdri : {"assets/textures/std_env.hdr", "assets/textures/canary_wharf_1k.hdr"})
+		{
+			hdris.push_back({ReadFile(Utilities::FileHelper::GetPlatformFilePath(hdri)), true});
+		}
+		BenchTextureDecode(harness, "stb decode/hdri", hdris);
+		if (harness.Enabled("environment table")) BenchEnvironmentTable(harness, hdris.back());
+
+		BenchObj(harness);
+		BenchTaskCoordinator(harness);
+		if (harness.Enabled("light alias")) BenchLightAlias(harness);
+		BenchLightTree(harness);
+		if (harness.Enabled("sobol sampler")) BenchSobolSampler(harness);
+		if (harness.Enabled("radiance cache")) BenchRadianceCache(harness);
+		BenchScreenCapture(harness);
+
+		std::ofstream file(settings.Output, std::ios::out | std::ios::trunc);
+		file << harness.Report().dump();
+		if (!file.good())
+		{
+			fmt::print("{} failed to write {}{}\n", CONSOLE_GOLD_COLOR, settings.Output, CONSOLE_DEFAULT_COLOR);
+			return EXIT_FAILURE;
+		}
+		fmt::print("{} report written to {}{}\n", CONSOLE_GREEN_COLOR, settings.Output, CONSOLE_DEFAULT_COLOR);
+		return EXIT_SUCCESS;
+	}
+	catch (const std::exception& exception)
+	{
+		Utilities::Console::Write(Utilities::Severity::Fatal, [&exception]()
+		{
+			std::cerr << "FATAL: " << exception.what() << std::endl;
+		});
+	}
+	catch (...)
+	{
+		Utilities::Console::Write(Utilities::Severity::Fatal, []()
+		{
+			fmt::print(stderr, "FATAL: caught unhandled exception\n");
+		});
+	}
+	return EXIT_FAILURE;
+}
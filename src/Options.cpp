@@ -1,5 +1,6 @@
 #include "Options.hpp"
 #include "Utilities/Exception.hpp"
+#include "Utilities/Profiler.hpp"
 #include <boost/program_options.hpp>
 #include <iostream>
 
@@ -14,6 +15,19 @@ Options::Options(const int argc, const char* argv[])
 		("next-scenes", bool_switch(&BenchmarkNextScenes)->default_value(false), "Load the next scene once the sample or time limit is reached.")
 		("max-time", value<uint32_t>(&BenchmarkMaxTime)->default_value(10), "The benchmark time limit per scene (in seconds).")
 		("max-frame", value<uint32_t>(&BenchmarkMaxFrame)->default_value(0), "The benchmark frame limit per scene.")
+		("warmup", value<float>(&BenchmarkWarmup)->default_value(2.0f, "2"), "Seconds discarded before measuring a scene, renderer or resolution (waits for texture streaming too).")
+		("stable-ci", value<float>(&BenchmarkStableCi)->default_value(0.01f, "0.01"), "Stop measuring once the 95% confidence interval of the mean frame time is within this fraction of it (0 = run to the time or frame limit).")
+		("matrix", bool_switch(&BenchmarkMatrix)->default_value(false), "Benchmark every combination of matrix-renderers, matrix-scenes and matrix-resolutions into one report.")
+		("matrix-renderers", value<std::string>(&MatrixRenderers)->default_value("0,1,2,3"), "Comma separated renderer types of the matrix.")
+		("matrix-scenes", value<std::string>(&MatrixScenes)->default_value(""), "Comma separated scene indices of the matrix (default: all).")
+		("matrix-resolutions", value<std::string>(&MatrixResolutions)->default_value(""), "Comma separated WxH window sizes of the matrix (default: the window size).")
+		("trace", value<std::string>(&TraceFile)->default_value(""), "Write a chrome/perfetto trace json of the first scene load, or of a frame range with trace-frames.")
+		("trace-start", value<uint32_t>(&TraceStart)->default_value(60), "The first traced frame.")
+		("trace-frames", value<uint32_t>(&TraceFrames)->default_value(0), "The number of traced frames (0 = trace the scene load instead).")
+		("ray-stats", bool_switch(&RayStatistics)->default_value(false), "Count primary, bounce and shadow rays on the gpu (ray query and hybrid renderers), shows Mrays/s and adds it to the report.")
+		("record-path", bool_switch(&RecordCameraPath)->default_value(false), "Record the camera into <scene>.campath.json next to the scenes while flying around.")
+		("replay-path", bool_switch(&ReplayCameraPath)->default_value(false), "Replay the scene's recorded camera path at a fixed time step, the benchmark ends with the path.")
+		("path-fps", value<uint32_t>(&CameraPathFps)->default_value(60), "The replayed path frames per second of path time.")
 		;
 
 	options_description renderer("Renderer options", lineLength);
@@ -24,7 +38,15 @@ Options::Options(const int argc, const char* argv[])
 		("max-bounces", value<uint32_t>(&MaxBounces)->default_value(10), "The maximum bounces per ray.")
 		("temporal", value<uint32_t>(&Temporal)->default_value(32), "The number of temporal frames.")
 		("nodenoiser", bool_switch(&NoDenoiser)->default_value(false), "Not Use Denoiser.")
-		("adaptivesample", bool_switch(&AdaptiveSample)->default_value(false), "use adaptive sample to improve render quality.")
+		("adaptivesample", bool_switch(&AdaptiveSample)->default_value(false), "Spend the samples per pixel where the accumulated variance is high, the average stays at samples.")
+		("firefly-clamp", bool_switch(&FireflyClamp)->default_value(false), "Clamp the luminance of a path at 1000, biased but hides fireflies.")
+		("rr-depth", value<uint32_t>(&RussianRouletteDepth)->default_value(3), "The bounces before russian roulette may end a path, above max-bounces turns it off.")
+		("sampler", value<uint32_t>(&Sampler)->default_value(1), "The path tracer's random numbers (0 = random, 1 = owen scrambled sobol with blue noise ranking).")
+		("radiance-cache", value<uint32_t>(&RadianceCache)->default_value(0), "End diffuse paths in the world space radiance cache past this many bounces (0 = off, 1 or 2), biased but far fewer rays.")
+		("denoise-filter", value<uint32_t>(&DenoiseFilter)->default_value(0), "The denoiser's filter (0 = joint bilateral, 1 = spatiotemporal variance guided).")
+		("atrous-passes", value<uint32_t>(&AtrousPasses)->default_value(5), "The a-trous wavelet passes of the variance guided filter (1 to 5).")
+		("multi-view", value<uint32_t>(&MultiViewPasses)->default_value(0), "Render every scene camera with this many passes and write each view to an exr (0 = off).")
+		("multi-view-count", value<uint32_t>(&MultiViewCount)->default_value(0), "The maximum number of cameras rendered in multi-view mode (0 = all).")
 	
     ;
 
@@ -35,6 +57,43 @@ Options::Options(const int argc, const char* argv[])
 		("hdri", value<std::string>(&HDRIfile)->default_value(""), "The HDRI file to load.")
 		;
 
+	options_description distributed("Distributed options", lineLength);
+	distributed.add_options()
+		("workers", value<uint32_t>(&DistributedWorkers)->default_value(0), "Run as coordinator, spawn N local worker processes and merge their passes.")
+		("dist-gpus", value<uint32_t>(&DistributedGpus)->default_value(1), "The number of gpus the workers are spread over (worker i uses gpu i % N).")
+		("dist-passes", value<uint32_t>(&DistributedPasses)->default_value(256), "The total number of progressive passes of the distributed frame.")
+		("dist-job-passes", value<uint32_t>(&DistributedJobPasses)->default_value(16), "The number of passes in one job handed to a worker.")
+		("dist-port", value<uint32_t>(&DistributedPort)->default_value(47800), "The local port the coordinator listens on.")
+		("dist-timeout", value<uint32_t>(&DistributedTimeout)->default_value(120), "Seconds without a result before a worker is dropped and its job reassigned.")
+		("worker-port", value<uint32_t>(&WorkerPort)->default_value(0), "Internal, run as worker of the coordinator on this port.")
+		("worker-id", value<uint32_t>(&WorkerId)->default_value(0), "Internal, the worker slot given by the coordinator.")
+		;
+
+	options_description capture("Capture options", lineLength);
+	capture.add_options()
+		("capture-every", value<uint32_t>(&CaptureEvery)->default_value(0), "Capture every Nth frame into a sequence (0 = off).")
+		("capture-frames", value<uint32_t>(&CaptureFrames)->default_value(0), "Stop and quit after this many captured frames (0 = until closed).")
+		("capture-format", value<std::string>(&CaptureFormat)->default_value("png"), "The sequence format: png, exr (linear output) or y4m (one raw stream).")
+		("capture-prefix", value<std::string>(&CapturePrefix)->default_value("capture"), "The sequence file name prefix.")
+		;
+
+	options_description convergence("Convergence options", lineLength);
+	convergence.add_options()
+		("convergence", bool_switch(&Convergence)->default_value(false), "Log the error against a cached reference of the start scene over time, then quit.")
+		("reference", value<std::string>(&ReferenceFile)->default_value(""), "The cached reference file (default: reference_<scene>_<w>x<h>_<frames>_<settings hash>.bin).")
+		("reference-frames", value<uint32_t>(&ReferenceFrames)->default_value(4096), "The number of passes accumulated into a new reference.")
+		("convergence-interval", value<uint32_t>(&ConvergenceInterval)->default_value(500), "The wall-clock interval between error samples (in milliseconds).")
+		("convergence-time", value<uint32_t>(&ConvergenceTime)->default_value(60), "The measured time (in seconds).")
+		("convergence-threshold", value<float>(&ConvergenceThreshold)->default_value(0.01f, "0.01"), "The relMSE the time-to-threshold is reported for.")
+		;
+
+	options_description analyzer("Asset analyzer options", lineLength);
+	analyzer.add_options()
+		("analyze", value<std::string>(&AnalyzeFile)->default_value(""), "Load only the cpu side of a .glb or .obj, write its memory and load cost as json and quit (no gpu needed).")
+		("analyze-output", value<std::string>(&AnalyzeOutput)->default_value(""), "The analysis json (default: <asset>.analysis.json next to the asset).")
+		("analyze-budget", value<uint32_t>(&AnalyzeBudget)->default_value(0), "Exit with a failure when the estimated gpu memory exceeds this many MB (0 = no limit).")
+		;
+
 	options_description vulkan("Vulkan options", lineLength);
 	vulkan.add_options()
 		("gpu", value<uint32_t>(&GpuIdx)->default_value(0), "Explicitly set the usage gpu idx.")
@@ -53,6 +112,9 @@ Options::Options(const int argc, const char* argv[])
 		("help", "Display help message.")
 		("benchmark", bool_switch(&Benchmark)->default_value(false), "Run the application in benchmark mode.")
 		("savefile", bool_switch(&SaveFile)->default_value(false), "Save screenshot every benchmark finish.")
+		("exr", bool_switch(&SaveExr)->default_value(false), "With savefile, also save the linear hdr output as OpenEXR.")
+		("exr-float", bool_switch(&ExrFloat)->default_value(false), "Write OpenEXR channels as 32 bit float instead of half.")
+		("exr-aov", bool_switch(&ExrAov)->default_value(false), "Add the albedo and normal buffers as layers of the OpenEXR file.")
 		("renderdoc", bool_switch(&RenderDoc)->default_value(false), "Attach renderdoc if avaliable.")
 		("forcesdr", bool_switch(&ForceSDR)->default_value(false), "Force use SDR Display even supported.")
 		("locale", value<std::string>(&locale)->default_value("en"), "Locale: en, zhCN, RU.")
@@ -61,6 +123,10 @@ Options::Options(const int argc, const char* argv[])
 	desc.add(benchmark);
 	desc.add(renderer);
 	desc.add(scene);
+	desc.add(distributed);
+	desc.add(capture);
+	desc.add(convergence);
+	desc.add(analyzer);
 	desc.add(vulkan);
 	desc.add(window);
 
@@ -75,6 +141,43 @@ Options::Options(const int argc, const char* argv[])
 		Throw(Help());
 	}
 	
+	ExecutablePath = argc > 0 ? argv[0] : "";
+
+	if (DistributedWorkers > 0 && (DistributedJobPasses == 0 || DistributedPasses == 0 || DistributedGpus == 0))
+	{
+		Throw(std::out_of_range("invalid distributed pass or gpu count"));
+	}
+
+	// the matrix is a benchmark with everything that implies, present mode and settings included
+	if (BenchmarkMatrix)
+	{
+		Benchmark = true;
+		if (RendererType > 3)
+		{
+			Throw(std::invalid_argument("matrix needs a ray tracing renderer type (0-3) to switch between"));
+		}
+	}
+
+	if (BenchmarkWarmup < 0 || BenchmarkStableCi < 0)
+	{
+		Throw(std::out_of_range("invalid benchmark warmup or stable-ci"));
+	}
+
+	if (TraceFrames >= Utilities::Profiler::FrameHistory)
+	{
+		Throw(std::out_of_range("trace-frames exceeds the profiler frame history"));
+	}
+
+	if (RecordCameraPath && ReplayCameraPath)
+	{
+		Throw(std::invalid_argument("record-path and replay-path are exclusive"));
+	}
+
+	if (CameraPathFps == 0)
+	{
+		Throw(std::out_of_range("invalid camera path fps"));
+	}
+
 	if (PresentMode > 3)
 	{
 		Throw(std::out_of_range("invalid present mode"));
@@ -23,15 +23,32 @@ public:
 	// Application options.
 	bool Benchmark{};
 	bool SaveFile{};
+	bool SaveExr{};
+	bool ExrFloat{};
+	bool ExrAov{};
 	bool RenderDoc{};
 	bool NoDenoiser{};
 	bool ForceSDR{};
 	std::string locale{};
+	std::string ExecutablePath{};
 	
 	// Benchmark options.
 	bool BenchmarkNextScenes{};
 	uint32_t BenchmarkMaxTime{};
 	uint32_t BenchmarkMaxFrame{};
+	float BenchmarkWarmup{};
+	float BenchmarkStableCi{};
+	bool BenchmarkMatrix{};
+	std::string MatrixRenderers{};
+	std::string MatrixScenes{};
+	std::string MatrixResolutions{};
+	std::string TraceFile{};
+	uint32_t TraceStart{};
+	uint32_t TraceFrames{};
+	bool RayStatistics{};
+	bool RecordCameraPath{};
+	bool ReplayCameraPath{};
+	uint32_t CameraPathFps{};
 
 	// Renderer options.
 	uint32_t Samples{};
@@ -41,12 +58,49 @@ public:
 	uint32_t Temporal{};
 
 	bool AdaptiveSample{};
+	bool FireflyClamp{};
+	uint32_t RussianRouletteDepth{};
+	uint32_t Sampler{};
+	uint32_t RadianceCache{};
+	uint32_t DenoiseFilter{};
+	uint32_t AtrousPasses{};
+	uint32_t MultiViewPasses{};
+	uint32_t MultiViewCount{};
+
+	// Capture options.
+	uint32_t CaptureEvery{};
+	uint32_t CaptureFrames{};
+	std::string CaptureFormat{};
+	std::string CapturePrefix{};
+
+	// Convergence options.
+	bool Convergence{};
+	std::string ReferenceFile{};
+	uint32_t ReferenceFrames{};
+	uint32_t ConvergenceInterval{};
+	uint32_t ConvergenceTime{};
+	float ConvergenceThreshold{};
+
+	// Asset analyzer options.
+	std::string AnalyzeFile{};
+	std::string AnalyzeOutput{};
+	uint32_t AnalyzeBudget{};
 	
 	// Scene options.
 	uint32_t SceneIndex{};
 	std::string SceneName{};
 	std::string HDRIfile{};
 
+	// Distributed options.
+	uint32_t DistributedWorkers{};
+	uint32_t DistributedGpus{};
+	uint32_t DistributedPasses{};
+	uint32_t DistributedJobPasses{};
+	uint32_t DistributedPort{};
+	uint32_t DistributedTimeout{};
+	uint32_t WorkerPort{};
+	uint32_t WorkerId{};
+
 	// Vulkan options
 	uint32_t GpuIdx{};
 
@@ -8,14 +8,21 @@
 #include "Utilities/Exception.hpp"
 #include "Utilities/Console.hpp"
 #include "Utilities/Glm.hpp"
+#include "Utilities/Profiler.hpp"
 #include "Vulkan/Window.hpp"
 #include "Vulkan/SwapChain.hpp"
 #include "Vulkan/Device.hpp"
 #include "BenchMark.hpp"
+#include "CameraPath.hpp"
+#include "Convergence.hpp"
+#include "DistributedRender.hpp"
+#include "MultiViewBatch.hpp"
+#include "ScreenCapture.hpp"
 
 #include <fmt/format.h>
 #include <fmt/chrono.h>
 #include <Utilities/FileHelper.hpp>
+#include <algorithm>
 #include <filesystem>
 
 #include "Options.hpp"
@@ -70,6 +77,41 @@ namespace NextRenderer
 
 namespace
 {
+    const char* const RendererNames[] = {"PathTracing", "Hybrid", "ModernDeferred", "LegacyDeferred", "VulkanBase"};
+
+    std::vector<std::string> SplitList(const std::string& list)
+    {
+        std::vector<std::string> items;
+        size_t begin = 0;
+        while (begin <= list.size())
+        {
+            const size_t end = std::min(list.find(',', begin), list.size());
+            if (end > begin)
+            {
+                items.push_back(list.substr(begin, end - begin));
+            }
+            begin = end + 1;
+        }
+        return items;
+    }
+
+    uint32_t ParseListNumber(const std::string& item, const char* listName)
+    {
+        try
+        {
+            size_t parsed = 0;
+            const unsigned long value = std::stoul(item, &parsed);
+            if (parsed == item.size())
+            {
+                return static_cast<uint32_t>(value);
+            }
+        }
+        catch (const std::exception&)
+        {
+        }
+        Throw(std::invalid_argument(fmt::format("invalid {} entry '{}'", listName, item)));
+    }
+
     const bool EnableValidationLayers =
 #if defined(NDEBUG) ||  defined(ANDROID)
         false;
@@ -127,17 +169,21 @@ UserSettings CreateUserSettings(const Options& options)
     userSettings.NumberOfSamples = options.Benchmark ? 1 : options.Samples;
     userSettings.NumberOfBounces = options.Benchmark ? 4 : options.Bounces;
     userSettings.MaxNumberOfBounces = options.MaxBounces;
+    userSettings.RussianRouletteDepth = options.RussianRouletteDepth;
 
     userSettings.AdaptiveSample = options.AdaptiveSample;
-    userSettings.AdaptiveVariance = 6.0f;
-    userSettings.AdaptiveSteps = 8;
     userSettings.TAA = true;
+    userSettings.FireflyClamp = options.FireflyClamp;
+    userSettings.Sampler = static_cast<int>(options.Sampler);
+    userSettings.RadianceCacheBounce = std::min(options.RadianceCache, 2u);
 
     userSettings.ShowSettings = !options.Benchmark;
     userSettings.ShowOverlay = true;
 
     userSettings.ShowVisualDebug = false;
     userSettings.HeatmapScale = 0.5f;
+    userSettings.RayStatistics = options.RayStatistics;
+    userSettings.MemoryStatistics = false;
 
     userSettings.UseCheckerBoardRendering = false;
     userSettings.TemporalFrames = options.Benchmark ? 256 : options.Temporal;
@@ -149,6 +195,7 @@ UserSettings CreateUserSettings(const Options& options)
     userSettings.SunRotation = 0.5f;
     userSettings.SunLuminance = 500.f;
     userSettings.SkyIntensity = 100.f;
+    userSettings.LightTree = true;
     
     userSettings.RequestRayCast = false;
 
@@ -156,6 +203,25 @@ UserSettings CreateUserSettings(const Options& options)
     userSettings.DenoiseSigmaLum = 10.0f;
     userSettings.DenoiseSigmaNormal = 0.005f;
     userSettings.DenoiseSize = 5;
+    userSettings.DenoiseFilter = static_cast<int>(options.DenoiseFilter);
+    userSettings.DenoiseIterations = std::clamp(static_cast<int>(options.AtrousPasses), 1, SVGF_MAX_ITERATIONS);
+
+    // distributed worker and multi-view batch, both keep the raw linear passes
+    if(options.WorkerPort != 0 || options.MultiViewPasses != 0)
+    {
+        userSettings.Denoiser = false;
+        userSettings.AdaptiveSample = false;
+        userSettings.RadianceCacheBounce = 0;
+        userSettings.ShowSettings = false;
+        userSettings.ShowOverlay = false;
+    }
+
+    // sequence capture takes the swapchain, keep the ui out of it
+    if(options.CaptureEvery != 0)
+    {
+        userSettings.ShowSettings = false;
+        userSettings.ShowOverlay = false;
+    }
 
 #if ANDROID
     userSettings.NumberOfSamples = 1;
@@ -167,6 +233,7 @@ UserSettings CreateUserSettings(const Options& options)
 
 NextRendererApplication::NextRendererApplication(const Options& options, void* userdata)
 {
+    Utilities::Profiler::SetThreadName("main");
     status_ = NextRenderer::EApplicationStatus::Starting;
 
     // Create Window
@@ -191,6 +258,111 @@ NextRendererApplication::NextRendererApplication(const Options& options, void* u
     {
         benchMarker_ = std::make_unique<BenchMarker>();
     }
+
+    // Initialize Benchmark Matrix
+    if(options.BenchmarkMatrix)
+    {
+        std::vector<int> renderers;
+        for(const auto& item : SplitList(options.MatrixRenderers))
+        {
+            const uint32_t type = ParseListNumber(item, "matrix-renderers");
+            if(type > 3)
+            {
+                Throw(std::invalid_argument(fmt::format("matrix renderer {} is not switchable at runtime", type)));
+            }
+            renderers.push_back(static_cast<int>(type));
+        }
+
+        std::vector<int> scenes;
+        for(const auto& item : SplitList(options.MatrixScenes))
+        {
+            const uint32_t scene = ParseListNumber(item, "matrix-scenes");
+            if(scene >= SceneList::AllScenes.size())
+            {
+                Throw(std::invalid_argument(fmt::format("matrix scene {} does not exist", scene)));
+            }
+            scenes.push_back(static_cast<int>(scene));
+        }
+        if(options.MatrixScenes.empty())
+        {
+            for(size_t i = 0; i < SceneList::AllScenes.size(); ++i)
+            {
+                scenes.push_back(static_cast<int>(i));
+            }
+        }
+
+        // 0x0 keeps the window as it is
+        std::vector<VkExtent2D> resolutions;
+        for(const auto& item : SplitList(options.MatrixResolutions))
+        {
+            const size_t separator = item.find('x');
+            if(separator == std::string::npos)
+            {
+                Throw(std::invalid_argument(fmt::format("invalid matrix-resolutions entry '{}'", item)));
+            }
+            resolutions.push_back({ParseListNumber(item.substr(0, separator), "matrix-resolutions"), ParseListNumber(item.substr(separator + 1), "matrix-resolutions")});
+        }
+        if(resolutions.empty())
+        {
+            resolutions.push_back({0, 0});
+        }
+
+        // scenes load once per resolution, renderers switch without a reload
+        for(const auto& resolution : resolutions)
+        {
+            for(int scene : scenes)
+            {
+                for(int renderer : renderers)
+                {
+                    matrixCells_.push_back({renderer, scene, resolution.width, resolution.height});
+                }
+            }
+        }
+        if(matrixCells_.empty())
+        {
+            Throw(std::invalid_argument("empty benchmark matrix"));
+        }
+        fmt::print("{} benchmark matrix: {} renderers x {} scenes x {} resolutions{}\n", CONSOLE_GREEN_COLOR, renderers.size(), scenes.size(), resolutions.size(), CONSOLE_DEFAULT_COLOR);
+        ApplyMatrixCell();
+    }
+
+    // Initialize Distributed Worker
+    if(options.WorkerPort != 0)
+    {
+        distributedWorker_ = std::make_unique<DistributedWorker>(options.WorkerPort, options.WorkerId);
+    }
+
+    // Initialize Multi-View Batch
+    if(options.MultiViewPasses != 0)
+    {
+        const std::string sceneName = std::filesystem::path(SceneList::AllScenes[userSettings_.SceneIndex].first).stem().string();
+        multiViewBatch_ = std::make_unique<MultiViewBatch>(options.MultiViewPasses, options.MultiViewCount, sceneName);
+    }
+
+    // Initialize Convergence Benchmark
+    if(options.Convergence)
+    {
+        const std::string sceneName = std::filesystem::path(SceneList::AllScenes[userSettings_.SceneIndex].first).stem().string();
+        convergence_ = std::make_unique<ConvergenceBenchmark>(sceneName, options.RendererType, options.ReferenceFile, options.ReferenceFrames,
+            options.ConvergenceInterval, options.ConvergenceTime, options.ConvergenceThreshold);
+    }
+
+    // Initialize Sequence Capture
+    if(options.CaptureEvery != 0)
+    {
+        ScreenCapture::ESequenceFormat format;
+        if(!ScreenCapture::ParseSequenceFormat(options.CaptureFormat, format))
+        {
+            Throw(std::invalid_argument("invalid capture format '" + options.CaptureFormat + "'"));
+        }
+        sequenceCapture_ = std::make_unique<ScreenCapture::Sequence>(options.CaptureEvery, options.CaptureFrames, format, options.CapturePrefix);
+    }
+    
+    // Initialize Camera Path, loaded or restarted with every scene
+    if(options.RecordCameraPath || options.ReplayCameraPath)
+    {
+        cameraPath_ = std::make_unique<CameraPath>();
+    }
     
     // Initialize Renderer
     renderer_.reset( NextRenderer::CreateRenderer(options.RendererType, window_.get(), static_cast<VkPresentModeKHR>(options.Benchmark ? 0 : options.PresentMode), EnableValidationLayers) );
@@ -242,11 +414,17 @@ NextRendererApplication::NextRendererApplication(const Options& options, void* u
 NextRendererApplication::~NextRendererApplication()
 {
     Utilities::Localization::SaveLocTexts(fmt::format("assets/locale/{}.txt", GOption->locale).c_str());
+    SaveCameraPath();
 
     scene_.reset();
     renderer_.reset();
     window_.reset();
     benchMarker_.reset();
+    distributedWorker_.reset();
+    multiViewBatch_.reset();
+    convergence_.reset();
+    sequenceCapture_.reset();
+    cameraPath_.reset();
 }
 
 void NextRendererApplication::Start()
@@ -270,6 +448,7 @@ bool NextRendererApplication::Tick()
     // Camera Update
     userSettings_.FieldOfView = glm::mix( userSettings_.FieldOfView, userSettings_.RawFieldOfView, 0.1);
     modelViewController_.UpdateCamera(cameraInitialSate_.ControlSpeed, timeDelta);
+    TickCameraPath();
 
     // Handle Scene Switching
     if (status_ == NextRenderer::EApplicationStatus::Running && sceneIndex_ != static_cast<uint32_t>(userSettings_.SceneIndex))
@@ -295,6 +474,19 @@ bool NextRendererApplication::Tick()
     glfwPollEvents();
     renderer_->DrawFrame();
     window_->attemptDragWindow();
+    if(distributedWorker_)
+    {
+        const bool sceneReady = status_ == NextRenderer::EApplicationStatus::Running &&
+            sceneIndex_ == static_cast<uint32_t>(userSettings_.SceneIndex) && TaskCoordinator::GetInstance()->IsIdle();
+        if(!distributedWorker_->Tick(*renderer_, sceneReady))
+        {
+            GetWindow().Close();
+        }
+    }
+    TickMultiView();
+    TickConvergence();
+    TickSequenceCapture();
+    TickTrace();
     totalFrames_ += 1;
     return glfwWindowShouldClose( window_->Handle() ) != 0;
 #endif
@@ -390,8 +582,6 @@ Assets::UniformBufferObject NextRendererApplication::GetUniformBufferObject(cons
     ubo.NumberOfSamples = userSettings_.NumberOfSamples;
     ubo.NumberOfBounces = userSettings_.NumberOfBounces;
     ubo.AdaptiveSample = userSettings_.AdaptiveSample;
-    ubo.AdaptiveVariance = userSettings_.AdaptiveVariance;
-    ubo.AdaptiveSteps = userSettings_.AdaptiveSteps;
     ubo.TAA = userSettings_.TAA;
     ubo.RandomSeed = rand();
     ubo.SunDirection = glm::vec4( glm::normalize(glm::vec3( sinf(float( userSettings_.SunRotation * M_PI )), 0.75f, cosf(float( userSettings_.SunRotation * M_PI )) )), 0.0f );
@@ -400,6 +590,7 @@ Assets::UniformBufferObject NextRendererApplication::GetUniformBufferObject(cons
     ubo.SkyIdx = userSettings_.SkyIdx;
     ubo.BackGroundColor = glm::vec4(0.4, 0.6, 1.0, 0.0) * 4.0f * userSettings_.SkyIntensity;
     ubo.HasSky = userSettings_.HasSky;
+    ubo.HasSkyTable = Assets::GlobalTexturePool::GetInstance()->HasEnvironmentTable(userSettings_.SkyIdx);
     ubo.HasSun =userSettings_.HasSun && userSettings_.SunLuminance > 0;
     ubo.ShowHeatmap = userSettings_.ShowVisualDebug;
     ubo.HeatmapScale = userSettings_.HeatmapScale;
@@ -409,11 +600,17 @@ Assets::UniformBufferObject NextRendererApplication::GetUniformBufferObject(cons
     
     ubo.PaperWhiteNit = userSettings_.PaperWhiteNit;
     ubo.LightCount = scene_->GetLightCount();
+    ubo.UseLightTree = userSettings_.LightTree;
+    ubo.FireflyClamp = userSettings_.FireflyClamp;
+    ubo.RussianRouletteDepth = userSettings_.RussianRouletteDepth;
+    ubo.Sampler = static_cast<uint32_t>(userSettings_.Sampler);
+    ubo.RadianceCacheBounce = userSettings_.RadianceCacheBounce;
 
     ubo.BFSigma = userSettings_.DenoiseSigma;
     ubo.BFSigmaLum = userSettings_.DenoiseSigmaLum;
     ubo.BFSigmaNormal = userSettings_.DenoiseSigmaNormal;
-    ubo.BFSize = userSettings_.Denoiser ? userSettings_.DenoiseSize : 0;
+    ubo.BFSize = userSettings_.Denoiser && userSettings_.DenoiseFilter == DENOISE_FILTER_BILATERAL ? userSettings_.DenoiseSize : 0;
+    ubo.CollectRayStats = userSettings_.RayStatistics;
 
 #if WITH_EDITOR
     ubo.ShowEdge = true;
@@ -421,8 +618,30 @@ Assets::UniformBufferObject NextRendererApplication::GetUniformBufferObject(cons
     
 
     // Other Setup
-    renderer_->supportDenoiser_ = userSettings_.Denoiser;
+    renderer_->supportDenoiser_ = userSettings_.Denoiser && userSettings_.DenoiseFilter == DENOISE_FILTER_BILATERAL;
+    renderer_->svgfIterations_ = userSettings_.Denoiser && userSettings_.DenoiseFilter == DENOISE_FILTER_SVGF ? userSettings_.DenoiseIterations : 0;
+    renderer_->radianceCacheBounce_ = userSettings_.RadianceCacheBounce;
     renderer_->visualDebug_ = userSettings_.ShowVisualDebug;
+    renderer_->collectRayStatistics_ = userSettings_.RayStatistics;
+    
+    // Distributed worker pins frame index and seed to its job's pass range
+    if(distributedWorker_)
+    {
+        distributedWorker_->OverrideUniformBufferObject(ubo);
+    }
+    if(multiViewBatch_)
+    {
+        multiViewBatch_->OverrideUniformBufferObject(ubo);
+    }
+    if(convergence_)
+    {
+        convergence_->OverrideUniformBufferObject(ubo);
+    }
+    // A replayed path pins the seed to its frame so every run traces the same rays
+    if(ReplayingCameraPath())
+    {
+        ubo.RandomSeed = cameraPathFrame_;
+    }
     
     // UBO Backup, for motion vector calc
     prevUBO_ = ubo;
@@ -527,6 +746,25 @@ void NextRendererApplication::OnRendererPostRender(VkCommandBuffer commandBuffer
     stats.ComputePassCount = 0;
     stats.LoadingStatus = status_ == NextRenderer::EApplicationStatus::Loading;
 
+    if(userSettings_.RayStatistics)
+    {
+        const Assets::RayStatistics& rays = renderer_->LastRayStatistics();
+        stats.RayStatistics = true;
+        stats.PrimaryRays = rays.PrimaryRays;
+        stats.BounceRays = rays.BounceRays;
+        stats.ShadowRays = rays.ShadowRays;
+        stats.RayRate = static_cast<float>((static_cast<double>(rays.PrimaryRays) + rays.BounceRays + rays.ShadowRays) * frameRate * 1e-6);
+        stats.TotalSamples = rays.AdaptiveSamples;
+        stats.EarlyTerminations = rays.Paths > 0 ? static_cast<float>(rays.EarlyTerminations) / rays.Paths : 0.0f;
+        stats.RouletteTerminations = rays.Paths > 0 ? static_cast<float>(rays.RouletteTerminations) / rays.Paths : 0.0f;
+        stats.BounceHistogram.assign(std::begin(rays.BounceHistogram), std::end(rays.BounceHistogram));
+    }
+
+    if(userSettings_.MemoryStatistics)
+    {
+        stats.MemoryHeaps = Vulkan::MemoryTracker::Heaps(renderer_->Device());
+    }
+
     //Renderer::visualDebug_ = userSettings_.ShowVisualDebug;
     
     userInterface_->Render(commandBuffer, renderer_->SwapChain(), imageIndex, stats, renderer_->GpuTimer(), scene_.get());
@@ -678,7 +916,9 @@ void NextRendererApplication::OnTouchMove(double xpos, double ypos)
 
 void NextRendererApplication::LoadScene(const uint32_t sceneIndex)
 {
+    SaveCameraPath();
     status_ = NextRenderer::EApplicationStatus::Loading;
+    sceneLoadBegin_ = Utilities::Profiler::Now();
     
     std::shared_ptr< std::vector<Assets::Model> > models = std::make_shared< std::vector<Assets::Model> >();
     std::shared_ptr< std::vector<Assets::Node> > nodes = std::make_shared< std::vector<Assets::Node> >();
@@ -692,6 +932,7 @@ void NextRendererApplication::LoadScene(const uint32_t sceneIndex)
     // dispatch in thread task and reset in main thread
     TaskCoordinator::GetInstance()->AddTask( [cameraState, sceneIndex, models, nodes, materials, lights](ResTask& task)
     {
+        PROFILER_SCOPE("scene parse");
         SceneTaskContext taskContext {};
         const auto timer = std::chrono::high_resolution_clock::now();
         
@@ -709,6 +950,7 @@ void NextRendererApplication::LoadScene(const uint32_t sceneIndex)
         task.GetContext( taskContext );
         fmt::print("{} {}{}\n", CONSOLE_GREEN_COLOR, taskContext.outputInfo.data(), CONSOLE_DEFAULT_COLOR);
         
+        PROFILER_SCOPE("scene upload");
         const auto timer = std::chrono::high_resolution_clock::now();
         
         cameraInitialSate_ = *cameraState;
@@ -747,17 +989,39 @@ void NextRendererApplication::LoadScene(const uint32_t sceneIndex)
         
         totalFrames_ = 0;
 
-        if(benchMarker_)
-        {
-            benchMarker_->OnSceneStart(GetWindow().GetTime());
-        }
-
         renderer_->OnPostLoadScene();
         renderer_->CreateSwapChain();
 
         float elapsed = std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - timer).count();
 
         fmt::print("{} uploaded scene #{} to gpu in {:.2f}ms{}\n", CONSOLE_GREEN_COLOR, sceneIndex, elapsed * 1000.f, CONSOLE_DEFAULT_COLOR);
+
+        // started after the swapchain is back so the first measured frame is a regular one
+        if(benchMarker_)
+        {
+            benchMarker_->OnSceneStart(GetWindow().GetTime(), (Utilities::Profiler::Now() - sceneLoadBegin_) * 1e-9);
+        }
+
+        if(cameraPath_)
+        {
+            cameraPath_->Clear();
+            cameraPathFrame_ = 0;
+            cameraPathStart_ = GetWindow().GetTime();
+            cameraPathActive_ = GOption->RecordCameraPath;
+            if(GOption->ReplayCameraPath)
+            {
+                const std::string filename = CameraPath::FileName(SceneList::AllScenes[sceneIndex].first);
+                cameraPathActive_ = cameraPath_->Load(filename);
+                if(cameraPathActive_)
+                {
+                    fmt::print("{} replaying camera path {} ({:.1f}s, {} keys){}\n", CONSOLE_GREEN_COLOR, filename, cameraPath_->Duration(), cameraPath_->KeyCount(), CONSOLE_DEFAULT_COLOR);
+                }
+                else
+                {
+                    fmt::print("{} no camera path at {}, keeping the scene camera{}\n", CONSOLE_GOLD_COLOR, filename, CONSOLE_DEFAULT_COLOR);
+                }
+            }
+        }
         
         sceneIndex_ = sceneIndex;
         status_ = NextRenderer::EApplicationStatus::Running;
@@ -767,10 +1031,37 @@ void NextRendererApplication::LoadScene(const uint32_t sceneIndex)
 
 void NextRendererApplication::TickBenchMarker()
 {
-    if( benchMarker_ && benchMarker_->OnTick( GetWindow().GetTime(), renderer_.get() ))
+    // with --benchmark the convergence run keeps the benchmark settings but decides when to stop
+    if(!benchMarker_ || convergence_)
+    {
+        return;
+    }
+
+    // a matrix cell measures nothing until its renderer, scene and window size are all in place
+    if(!matrixCells_.empty() && !MatrixCellReady())
+    {
+        benchMarker_->Restart(GetWindow().GetTime());
+        return;
+    }
+
+    // a replayed path sets the scene length by itself, once its last frame is drawn
+    const bool limitReached = benchMarker_->OnTick( GetWindow().GetTime(), renderer_.get() );
+    const bool pathFinished = cameraPathFrame_ > static_cast<uint32_t>(cameraPath_ ? cameraPath_->Duration() * GOption->CameraPathFps : 0) + 1;
+    if( ReplayingCameraPath() ? pathFinished : limitReached )
     {
         // Benchmark is done, report the results.
-        benchMarker_->OnReport(renderer_.get(), SceneList::AllScenes[userSettings_.SceneIndex].first);
+        benchMarker_->OnReport(renderer_.get(), SceneList::AllScenes[userSettings_.SceneIndex].first, RendererNames[std::clamp(rendererType, 0, 4)]);
+
+        if(!matrixCells_.empty())
+        {
+            if(++matrixCell_ == matrixCells_.size())
+            {
+                GetWindow().Close();
+                return;
+            }
+            ApplyMatrixCell();
+            return;
+        }
         
         if (!userSettings_.BenchmarkNextScenes || static_cast<size_t>(userSettings_.SceneIndex) ==
             SceneList::AllScenes.size() - 1)
@@ -781,3 +1072,199 @@ void NextRendererApplication::TickBenchMarker()
         userSettings_.SceneIndex += 1;
     }
 }
+
+void NextRendererApplication::ApplyMatrixCell()
+{
+    const MatrixCell& cell = matrixCells_[matrixCell_];
+    userSettings_.RendererType = cell.Renderer;
+    userSettings_.SceneIndex = cell.Scene;
+    if(cell.Width != 0)
+    {
+        const VkExtent2D size = GetWindow().WindowSize();
+        if(size.width != cell.Width || size.height != cell.Height)
+        {
+            GetWindow().Resize(cell.Width, cell.Height);
+        }
+    }
+
+    matrixCellStart_ = GetWindow().GetTime();
+    if(benchMarker_)
+    {
+        benchMarker_->Restart(matrixCellStart_);
+    }
+    fmt::print("{} matrix cell {}/{}: {} / {}{}{}\n", CONSOLE_GREEN_COLOR, matrixCell_ + 1, matrixCells_.size(), RendererNames[cell.Renderer],
+        SceneList::AllScenes[cell.Scene].first, cell.Width != 0 ? fmt::format(" / {}x{}", cell.Width, cell.Height) : "", CONSOLE_DEFAULT_COLOR);
+}
+
+bool NextRendererApplication::MatrixCellReady()
+{
+    // a window manager may refuse the size, measure at whatever it gave after a while rather than hang
+    constexpr double resizeTimeout = 5.0;
+
+    const MatrixCell& cell = matrixCells_[matrixCell_];
+    if(rendererType != cell.Renderer || sceneIndex_ != static_cast<uint32_t>(cell.Scene) || status_ != NextRenderer::EApplicationStatus::Running)
+    {
+        return false;
+    }
+
+    const VkExtent2D window = GetWindow().WindowSize();
+    const bool sized = cell.Width == 0 || (window.width == cell.Width && window.height == cell.Height) || GetWindow().GetTime() - matrixCellStart_ > resizeTimeout;
+
+    // the swapchain is recreated a frame after the resize
+    const VkExtent2D framebuffer = GetWindow().FramebufferSize();
+    const VkExtent2D swapChain = renderer_->SwapChain().Extent();
+    return sized && framebuffer.width == swapChain.width && framebuffer.height == swapChain.height;
+}
+
+void NextRendererApplication::TickMultiView()
+{
+    if(!multiViewBatch_ || status_ != NextRenderer::EApplicationStatus::Running ||
+        sceneIndex_ != static_cast<uint32_t>(userSettings_.SceneIndex))
+    {
+        return;
+    }
+
+    if(multiViewBatch_->Tick(*renderer_, static_cast<uint32_t>(userSettings_.cameras.size())))
+    {
+        ApplyCamera(multiViewBatch_->CurrentView());
+    }
+
+    if(multiViewBatch_->Finished())
+    {
+        GetWindow().Close();
+    }
+}
+
+void NextRendererApplication::TickConvergence()
+{
+    if(!convergence_ || status_ != NextRenderer::EApplicationStatus::Running ||
+        sceneIndex_ != static_cast<uint32_t>(userSettings_.SceneIndex))
+    {
+        return;
+    }
+
+    convergence_->Tick(*renderer_, GetWindow().GetTime());
+    if(convergence_->Finished())
+    {
+        GetWindow().Close();
+    }
+}
+
+void NextRendererApplication::TickSequenceCapture()
+{
+    if(!sequenceCapture_ || status_ != NextRenderer::EApplicationStatus::Running ||
+        sceneIndex_ != static_cast<uint32_t>(userSettings_.SceneIndex))
+    {
+        return;
+    }
+
+    sequenceCapture_->Tick(*renderer_);
+    if(sequenceCapture_->Finished())
+    {
+        GetWindow().Close();
+    }
+}
+
+void NextRendererApplication::TickTrace()
+{
+    if(GOption->TraceFile.empty() || traceWritten_)
+    {
+        return;
+    }
+
+    int64_t begin = 0;
+    int64_t end = 0;
+    if(GOption->TraceFrames == 0)
+    {
+        // the first scene load, up to the last texture decoded in the background
+        if(status_ != NextRenderer::EApplicationStatus::Running || sceneIndex_ != static_cast<uint32_t>(userSettings_.SceneIndex) ||
+            !TaskCoordinator::GetInstance()->IsIdle())
+        {
+            return;
+        }
+        begin = sceneLoadBegin_;
+        end = Utilities::Profiler::Now();
+    }
+    else
+    {
+        const uint64_t first = GOption->TraceStart;
+        if(!Utilities::Profiler::FrameTime(first + GOption->TraceFrames, end))
+        {
+            return;
+        }
+        if(!Utilities::Profiler::FrameTime(first, begin))
+        {
+            begin = 0;
+        }
+    }
+
+    traceWritten_ = true;
+    if(Utilities::Profiler::ExportChromeTrace(GOption->TraceFile, begin, end))
+    {
+        fmt::print("{} trace of {:.2f}ms written to {}{}\n", CONSOLE_GREEN_COLOR, (end - begin) * 1e-6, GOption->TraceFile, CONSOLE_DEFAULT_COLOR);
+    }
+    else
+    {
+        fmt::print("{} failed to write trace {}{}\n", CONSOLE_GOLD_COLOR, GOption->TraceFile, CONSOLE_DEFAULT_COLOR);
+    }
+}
+
+void NextRendererApplication::TickCameraPath()
+{
+    if(!cameraPath_ || !cameraPathActive_ || status_ != NextRenderer::EApplicationStatus::Running ||
+        sceneIndex_ != static_cast<uint32_t>(userSettings_.SceneIndex))
+    {
+        return;
+    }
+
+    if(GOption->RecordCameraPath)
+    {
+        cameraPath_->Record(time_ - cameraPathStart_, modelViewController_.ModelView(), userSettings_.FieldOfView, userSettings_.Aperture, userSettings_.FocusDistance);
+        return;
+    }
+
+    // fixed time step per frame, independent of how fast this machine draws them
+    const CameraPath::Key key = cameraPath_->Sample(cameraPathFrame_ / static_cast<double>(GOption->CameraPathFps));
+    modelViewController_.Reset(CameraPath::ModelView(key));
+    userSettings_.RawFieldOfView = key.FieldOfView;
+    userSettings_.FieldOfView = key.FieldOfView;
+    userSettings_.Aperture = key.Aperture;
+    userSettings_.FocusDistance = key.FocusDistance;
+    cameraPathFrame_++;
+}
+
+bool NextRendererApplication::ReplayingCameraPath() const
+{
+    return cameraPath_ && cameraPathActive_ && GOption->ReplayCameraPath;
+}
+
+void NextRendererApplication::SaveCameraPath()
+{
+    if(!cameraPath_ || !cameraPathActive_ || !GOption->RecordCameraPath || cameraPath_->Empty())
+    {
+        return;
+    }
+    cameraPathActive_ = false;
+
+    const std::string& sceneName = SceneList::AllScenes[sceneIndex_].first;
+    const std::string filename = CameraPath::FileName(sceneName);
+    if(cameraPath_->Save(filename, sceneName))
+    {
+        fmt::print("{} saved camera path of {:.1f}s ({} keys) to {}{}\n", CONSOLE_GREEN_COLOR, cameraPath_->Duration(), cameraPath_->KeyCount(), filename, CONSOLE_DEFAULT_COLOR);
+    }
+    else
+    {
+        fmt::print("{} failed to save camera path {}{}\n", CONSOLE_GOLD_COLOR, filename, CONSOLE_DEFAULT_COLOR);
+    }
+}
+
+void NextRendererApplication::ApplyCamera(int cameraIdx)
+{
+    const auto& cam = userSettings_.cameras[cameraIdx];
+    userSettings_.CameraIdx = cameraIdx;
+    userSettings_.RawFieldOfView = cam.FieldOfView;
+    userSettings_.FieldOfView = cam.FieldOfView;
+    userSettings_.Aperture = cam.Aperture;
+    userSettings_.FocusDistance = cam.FocalDistance;
+    modelViewController_.Reset(cam.ModelView);
+}
@@ -11,6 +11,15 @@
 #include "Options.hpp"
 
 class BenchMarker;
+class CameraPath;
+class ConvergenceBenchmark;
+class DistributedWorker;
+class MultiViewBatch;
+
+namespace ScreenCapture
+{
+	class Sequence;
+}
 
 namespace NextRenderer
 {
@@ -70,6 +79,16 @@ private:
 
 	void LoadScene(uint32_t sceneIndex);
 	void TickBenchMarker();
+	void ApplyMatrixCell();
+	bool MatrixCellReady();
+	void TickMultiView();
+	void TickConvergence();
+	void TickSequenceCapture();
+	void TickTrace();
+	void TickCameraPath();
+	bool ReplayingCameraPath() const;
+	void SaveCameraPath();
+	void ApplyCamera(int cameraIdx);
 	void CheckFramebufferSize();
 
 	void Report(int fps, const std::string& sceneName, bool upload_screen, bool save_screen);
@@ -77,6 +96,23 @@ private:
 	std::unique_ptr<Vulkan::Window> window_;
 	std::unique_ptr<Vulkan::VulkanBaseRenderer> renderer_;
 	std::unique_ptr<BenchMarker> benchMarker_;
+	std::unique_ptr<DistributedWorker> distributedWorker_;
+	std::unique_ptr<MultiViewBatch> multiViewBatch_;
+	std::unique_ptr<ConvergenceBenchmark> convergence_;
+
+	// benchmark matrix, one cell per resolution, scene and renderer in that nesting
+	struct MatrixCell
+	{
+		int Renderer;
+		int Scene;
+		uint32_t Width;
+		uint32_t Height;
+	};
+	std::vector<MatrixCell> matrixCells_;
+	size_t matrixCell_{};
+	double matrixCellStart_{};
+	std::unique_ptr<ScreenCapture::Sequence> sequenceCapture_;
+	std::unique_ptr<CameraPath> cameraPath_;
 
 	int rendererType = 0;
 	uint32_t sceneIndex_{((uint32_t)~((uint32_t)0))};
@@ -98,6 +134,11 @@ private:
 	NextRenderer::EApplicationStatus status_{};
 
 	uint32_t totalFrames_{};
+	int64_t sceneLoadBegin_{};
+	bool traceWritten_{};
+	bool cameraPathActive_{};
+	uint32_t cameraPathFrame_{};
+	double cameraPathStart_{};
 	double time_{};
 
 	glm::vec2 mousePos_ {};
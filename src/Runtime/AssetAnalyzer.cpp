@@ -0,0 +1,362 @@
+#include "AssetAnalyzer.hpp"
+#include "Application.hpp"
+#include "Options.hpp"
+#include "SceneList.hpp"
+#include "Assets/Model.hpp"
+#include "Assets/Texture.hpp"
+#include "Utilities/Console.hpp"
+#include "Utilities/Profiler.hpp"
+#include "Utilities/StbImage.hpp"
+#include "ThirdParty/json11/json11.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+#include <unordered_set>
+#include <fmt/format.h>
+
+namespace
+{
+	// rough sizes for budgeting, drivers do not report them without a device. An uncompacted triangle BLAS lands
+	// around 64 bytes per triangle on current desktop drivers and its build scratch around half of that; the renderer
+	// allocates the scratch of all BLAS at once and keeps it
+	constexpr double BlasBytesPerTriangle = 64.0;
+	constexpr double BlasScratchBytesPerTriangle = 32.0;
+	constexpr double TlasBytesPerInstance = 128.0;
+
+	uint64_t Fnv1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+	{
+		const auto* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	// the material index lives in the vertex, two meshes sharing geometry under different materials still count as duplicates
+	uint64_t HashVertex(const Assets::Vertex& vertex, uint64_t hash)
+	{
+		hash = Fnv1a(&vertex.Position, sizeof(vertex.Position), hash);
+		hash = Fnv1a(&vertex.Normal, sizeof(vertex.Normal), hash);
+		hash = Fnv1a(&vertex.TexCoord, sizeof(vertex.TexCoord), hash);
+		return Fnv1a(&vertex.Tangent, sizeof(vertex.Tangent), hash);
+	}
+
+	double ToMB(double bytes)
+	{
+		return bytes / (1024.0 * 1024.0);
+	}
+
+	double Milliseconds(std::chrono::high_resolution_clock::time_point begin, std::chrono::high_resolution_clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end - begin).count();
+	}
+}
+
+AssetAnalyzer::AssetAnalyzer(const Options& options) :
+	options_(options)
+{
+}
+
+uint32_t AssetAnalyzer::ProbeTexture(const std::string& name, const unsigned char* data, size_t bytelength, bool hdr)
+{
+	// the pool shares textures by name, so does the analysis
+	for (uint32_t i = 0; i < textures_.size(); ++i)
+	{
+		if (textures_[i].Name == name)
+		{
+			return i;
+		}
+	}
+
+	const auto begin = std::chrono::high_resolution_clock::now();
+
+	std::vector<unsigned char> file;
+	if (data == nullptr)
+	{
+		std::ifstream stream(name, std::ios::binary);
+		file.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+		data = file.data();
+		bytelength = file.size();
+	}
+
+	TextureInfo info{};
+	info.Name = name;
+	info.Hash = Fnv1a(data, bytelength);
+	info.EncodedBytes = bytelength;
+	info.Hdr = hdr;
+	info.DuplicateOf = -1;
+	// header only, nothing is decoded
+	if (bytelength == 0 || !stbi_info_from_memory(data, static_cast<int>(bytelength), &info.Width, &info.Height, &info.Channels))
+	{
+		info.Width = info.Height = info.Channels = 0;
+	}
+
+	for (uint32_t i = 0; i < textures_.size(); ++i)
+	{
+		if (textures_[i].DuplicateOf < 0 && textures_[i].Hash == info.Hash && textures_[i].EncodedBytes == info.EncodedBytes)
+		{
+			info.DuplicateOf = static_cast<int32_t>(i);
+			break;
+		}
+	}
+
+	textures_.push_back(info);
+	textureTime_ += Milliseconds(begin, std::chrono::high_resolution_clock::now());
+	return static_cast<uint32_t>(textures_.size()) - 1;
+}
+
+bool AssetAnalyzer::Run()
+{
+	const std::filesystem::path path = std::filesystem::absolute(options_.AnalyzeFile);
+	const std::string ext = path.extension().string();
+	if (!std::filesystem::exists(path) || (ext != ".glb" && ext != ".obj"))
+	{
+		fmt::print("{} cannot analyze {}, expected an existing .glb or .obj{}\n", CONSOLE_GOLD_COLOR, path.string(), CONSOLE_DEFAULT_COLOR);
+		return false;
+	}
+
+	Assets::GlobalTexturePool::SetOfflineLoader([this](const std::string& name, const unsigned char* data, size_t bytelength, bool hdr)
+	{
+		return ProbeTexture(name, data, bytelength, hdr);
+	});
+
+	// the same loader the scene list uses, so the analysis sees what a render would load
+	Assets::CameraInitialSate camera{};
+	std::vector<Assets::Node> nodes;
+	std::vector<Assets::Model> models;
+	std::vector<Assets::Material> materials;
+	std::vector<Assets::LightObject> lights;
+
+	const int64_t profileBegin = Utilities::Profiler::Now();
+	const auto loadBegin = std::chrono::high_resolution_clock::now();
+	const int32_t sceneIndex = SceneList::AddExternalScene(path.string());
+	SceneList::AllScenes[sceneIndex].second(camera, nodes, models, materials, lights);
+	const auto loadEnd = std::chrono::high_resolution_clock::now();
+
+	Assets::GlobalTexturePool::SetOfflineLoader(nullptr);
+
+	// what Assets::Scene adds to the loader's lights
+	const uint32_t triangleLights = Assets::Model::ExtractEmissiveTriangles(nodes, models, materials, lights);
+
+	std::vector<Utilities::Profiler::Event> events;
+	Utilities::Profiler::ThreadTrack().Collect(profileBegin, Utilities::Profiler::Now(), events);
+	const uint32_t parseId = Utilities::Profiler::Find("gltf parse");
+	double parseTime = 0;
+	for (const auto& event : events)
+	{
+		if (event.Id == parseId)
+		{
+			parseTime += (event.End - event.Begin) * 1e-6;
+		}
+	}
+
+	if (models.empty())
+	{
+		fmt::print("{} {} has no meshes{}\n", CONSOLE_GOLD_COLOR, path.string(), CONSOLE_DEFAULT_COLOR);
+		return false;
+	}
+
+	// the cpu side of Assets::Scene, the sizes of the device buffers it would create
+	const auto sceneBegin = std::chrono::high_resolution_clock::now();
+	std::vector<uint32_t> instances(models.size());
+	for (const auto& node : nodes)
+	{
+		if (node.GetModel() >= 0 && node.GetModel() < static_cast<int>(models.size()))
+		{
+			instances[node.GetModel()]++;
+		}
+	}
+
+	size_t vertexCount = 0;
+	size_t indexCount = 0;
+	for (const auto& model : models)
+	{
+		vertexCount += model.NumberOfVertices();
+		indexCount += model.NumberOfIndices();
+	}
+
+	json11::Json::object buffers{
+		{"vertices", ToMB(static_cast<double>(vertexCount * sizeof(Assets::Vertex)))},
+		{"indices", ToMB(static_cast<double>(indexCount * sizeof(uint32_t)))},
+		{"materials", ToMB(static_cast<double>(materials.size() * sizeof(Assets::Material)))},
+		{"offsets", ToMB(static_cast<double>(models.size() * sizeof(glm::uvec2)))},
+		{"aabbs", ToMB(static_cast<double>(models.size() * (sizeof(VkAabbPositionsKHR) + sizeof(glm::vec4))))},
+		{"lights", ToMB(static_cast<double>(lights.size() * sizeof(Assets::LightObject)))},
+		{"light_aliases", ToMB(static_cast<double>(lights.size() * sizeof(Assets::LightAlias)))},
+		{"light_tree", ToMB(static_cast<double>((lights.empty() ? 0 : lights.size() * 2 - 1) * sizeof(Assets::LightTreeNode)))},
+		{"nodes", ToMB(static_cast<double>(nodes.size() * sizeof(Assets::NodeProxy)))},
+		{"indirect_draws", ToMB(static_cast<double>(models.size() * sizeof(VkDrawIndexedIndirectCommand)))},
+	};
+	double bufferMB = 0;
+	for (const auto& buffer : buffers)
+	{
+		bufferMB += buffer.second.number_value();
+	}
+	const auto sceneEnd = std::chrono::high_resolution_clock::now();
+
+	// per mesh
+	json11::Json::array meshes;
+	std::unordered_map<uint64_t, uint32_t> meshHashes;
+	std::vector<bool> usedMaterials(materials.size());
+	size_t uniqueVertexCount = 0;
+	double blasBytes = 0;
+	double blasScratchBytes = 0;
+	double duplicateBytes = 0;
+	uint32_t duplicateMeshes = 0;
+	for (uint32_t i = 0; i < models.size(); ++i)
+	{
+		const auto& model = models[i];
+
+		// the loaders flatten, welding identical vertices back gives what an indexed layout would store
+		std::unordered_set<uint64_t> unique;
+		uint64_t hash = Fnv1a(model.Indices().data(), model.Indices().size() * sizeof(uint32_t));
+		for (const auto& vertex : model.Vertices())
+		{
+			unique.insert(HashVertex(vertex, Fnv1a(&vertex.MaterialIndex, sizeof(vertex.MaterialIndex))));
+			hash = HashVertex(vertex, hash);
+		}
+		uniqueVertexCount += unique.size();
+
+		if (instances[i] > 0)
+		{
+			for (const uint32_t material : model.Materials())
+			{
+				if (material < usedMaterials.size())
+				{
+					usedMaterials[material] = true;
+				}
+			}
+		}
+
+		const double triangles = model.NumberOfIndices() / 3.0;
+		const double meshBytes = model.NumberOfVertices() * sizeof(Assets::Vertex) + model.NumberOfIndices() * sizeof(uint32_t);
+		blasBytes += triangles * BlasBytesPerTriangle;
+		blasScratchBytes += triangles * BlasScratchBytesPerTriangle;
+
+		int32_t duplicateOf = -1;
+		const auto found = meshHashes.find(hash);
+		if (found == meshHashes.end())
+		{
+			meshHashes.emplace(hash, i);
+		}
+		else
+		{
+			duplicateOf = static_cast<int32_t>(found->second);
+			duplicateBytes += meshBytes + triangles * BlasBytesPerTriangle;
+			duplicateMeshes++;
+		}
+
+		meshes.push_back(json11::Json::object{
+			{"index", static_cast<int>(i)},
+			{"instances", static_cast<int>(instances[i])},
+			{"triangles", triangles},
+			{"vertices_flattened", static_cast<int>(model.NumberOfVertices())},
+			{"vertices_indexed", static_cast<int>(unique.size())},
+			{"memory_mb", ToMB(meshBytes)},
+			{"indexed_memory_mb", ToMB(static_cast<double>(unique.size() * sizeof(Assets::Vertex) + model.NumberOfIndices() * sizeof(uint32_t)))},
+			{"blas_mb", ToMB(triangles * BlasBytesPerTriangle)},
+			{"duplicate_of", duplicateOf},
+		});
+	}
+
+	// per texture, TextureImage keeps a single rgba8 or rgba32f level
+	json11::Json::array textures;
+	double textureBytes = 0;
+	uint32_t duplicateTextures = 0;
+	for (uint32_t i = 0; i < textures_.size(); ++i)
+	{
+		const auto& texture = textures_[i];
+		const double gpuBytes = static_cast<double>(texture.Width) * texture.Height * (texture.Hdr ? 16 : 4);
+		textureBytes += gpuBytes;
+		if (texture.DuplicateOf >= 0)
+		{
+			duplicateBytes += gpuBytes;
+			duplicateTextures++;
+		}
+
+		textures.push_back(json11::Json::object{
+			{"index", static_cast<int>(i)},
+			{"name", texture.Name},
+			{"width", texture.Width},
+			{"height", texture.Height},
+			{"channels", texture.Channels},
+			{"hdr", texture.Hdr},
+			{"encoded_kb", texture.EncodedBytes / 1024.0},
+			{"memory_mb", ToMB(gpuBytes)},
+			{"valid", texture.Width > 0},
+			{"duplicate_of", texture.DuplicateOf},
+		});
+	}
+
+	json11::Json::array unusedMaterials;
+	for (uint32_t i = 0; i < usedMaterials.size(); ++i)
+	{
+		if (!usedMaterials[i])
+		{
+			unusedMaterials.push_back(static_cast<int>(i));
+		}
+	}
+
+	const double tlasBytes = nodes.size() * (sizeof(VkAccelerationStructureInstanceKHR) + TlasBytesPerInstance);
+	const double totalMB = bufferMB + ToMB(textureBytes + blasBytes + blasScratchBytes + tlasBytes);
+	const bool overBudget = options_.AnalyzeBudget > 0 && totalMB > options_.AnalyzeBudget;
+	const auto analysisEnd = std::chrono::high_resolution_clock::now();
+
+	const double loadTime = Milliseconds(loadBegin, loadEnd);
+	const json11::Json report = json11::Json::object{
+		{"version", NextRenderer::GetBuildVersion()},
+		{"asset", path.string()},
+		{"phases_ms", json11::Json::object{
+			{"parse", parseTime},
+			{"textures", textureTime_},
+			{"geometry", loadTime - parseTime - textureTime_},
+			{"scene", Milliseconds(sceneBegin, sceneEnd)},
+			{"analysis", Milliseconds(sceneEnd, analysisEnd)},
+			{"total", Milliseconds(loadBegin, analysisEnd)}}},
+		{"totals", json11::Json::object{
+			{"meshes", static_cast<int>(models.size())},
+			{"instances", static_cast<int>(nodes.size())},
+			{"triangles", indexCount / 3.0},
+			{"vertices_flattened", static_cast<double>(vertexCount)},
+			{"vertices_indexed", static_cast<double>(uniqueVertexCount)},
+			{"textures", static_cast<int>(textures_.size())},
+			{"materials", static_cast<int>(materials.size())},
+			{"lights", static_cast<int>(lights.size())},
+			{"triangle_lights", static_cast<int>(triangleLights)}}},
+		{"memory_mb", json11::Json::object{
+			{"scene_buffers", bufferMB},
+			{"textures", ToMB(textureBytes)},
+			{"blas", ToMB(blasBytes)},
+			{"blas_scratch", ToMB(blasScratchBytes)},
+			{"tlas", ToMB(tlasBytes)},
+			{"duplicates", ToMB(duplicateBytes)},
+			{"total", totalMB}}},
+		{"budget_mb", static_cast<int>(options_.AnalyzeBudget)},
+		{"over_budget", overBudget},
+		{"scene_buffers_mb", buffers},
+		{"duplicate_meshes", static_cast<int>(duplicateMeshes)},
+		{"duplicate_textures", static_cast<int>(duplicateTextures)},
+		{"unused_materials", unusedMaterials},
+		{"meshes", meshes},
+		{"textures", textures},
+	};
+
+	const std::string output = options_.AnalyzeOutput.empty() ? path.string() + ".analysis.json" : options_.AnalyzeOutput;
+	std::ofstream file(output, std::ios::out | std::ios::trunc);
+	file << report.dump();
+	if (!file.good())
+	{
+		fmt::print("{} failed to write {}{}\n", CONSOLE_GOLD_COLOR, output, CONSOLE_DEFAULT_COLOR);
+		return false;
+	}
+
+	fmt::print("{} {}: {} meshes, {:.0f} triangles, {} textures, estimated {:.1f} MB of gpu memory ({:.1f} MB duplicated), loaded in {:.0f}ms{}\n",
+		overBudget ? CONSOLE_GOLD_COLOR : CONSOLE_GREEN_COLOR, path.filename().string(), models.size(), indexCount / 3.0, textures_.size(),
+		totalMB, ToMB(duplicateBytes), loadTime, CONSOLE_DEFAULT_COLOR);
+	fmt::print("{} analysis written to {}{}\n", CONSOLE_GREEN_COLOR, output, CONSOLE_DEFAULT_COLOR);
+	return !overBudget;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Options;
+
+// Runs the cpu side of the scene loaders on one .glb or .obj and writes what it would cost on a gpu as json: memory
+// per mesh and texture, flattened versus indexed vertex counts, estimated BLAS sizes, duplicate meshes and textures,
+// unused materials and per phase load times. Textures are only probed for their size, nothing is decoded or uploaded,
+// so it runs before any vulkan instance exists and works on machines without a gpu.
+class AssetAnalyzer final
+{
+public:
+	explicit AssetAnalyzer(const Options& options);
+
+	// false when the asset failed to load or exceeds the budget
+	bool Run();
+
+private:
+	struct TextureInfo
+	{
+		std::string Name;
+		uint64_t Hash;
+		size_t EncodedBytes;
+		int Width;
+		int Height;
+		int Channels;
+		bool Hdr;
+		int32_t DuplicateOf;
+	};
+
+	uint32_t ProbeTexture(const std::string& name, const unsigned char* data, size_t bytelength, bool hdr);
+
+	const Options& options_;
+	std::vector<TextureInfo> textures_;
+	double textureTime_{};
+};
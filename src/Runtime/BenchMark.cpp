@@ -1,5 +1,7 @@
 #include "BenchMark.hpp"
 #include "Options.hpp"
+#include "ScreenCapture.hpp"
+#include "TaskCoordinator.hpp"
 #include "Utilities/Console.hpp"
 #include "Vulkan/VulkanBaseRenderer.hpp"
 #include <fmt/format.h>
@@ -8,7 +10,6 @@
 #include "curl/curl.h"
 #include "cpp-base64/base64.cpp"
 #include "ThirdParty/json11/json11.hpp"
-#include "stb_image_write.h"
 
 #define _USE_MATH_DEFINES
 #include <filesystem>
@@ -17,13 +18,158 @@
 #include "Application.hpp"
 #include "Utilities/Exception.hpp"
 #include "Utilities/Math.hpp"
+#include "Utilities/Profiler.hpp"
 #include "Vulkan/Device.hpp"
+#include "Vulkan/MemoryTracker.hpp"
 #include "Vulkan/SwapChain.hpp"
 
-#if WITH_AVIF
-#include "avif/avif.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
 #endif
 
+namespace
+{
+    // peak resident set of the process so far, in megabytes
+    double PeakMemoryMB()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        {
+            return 0;
+        }
+        return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+        {
+            return 0;
+        }
+#if __APPLE__
+        return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+        return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+    }
+
+    double ToMB(VkDeviceSize bytes)
+    {
+        return bytes / (1024.0 * 1024.0);
+    }
+
+    // device memory per heap and category at the end of the scene, the largest owners, and the vram high water mark
+    json11::Json MemoryReport(const Vulkan::Device& device, double& vram)
+    {
+        vram = 0;
+        json11::Json::array heaps;
+        for (const auto& heap : Vulkan::MemoryTracker::Heaps(device))
+        {
+            json11::Json::object categories;
+            for (uint32_t i = 0; i != Vulkan::MemoryTracker::CategoryCount; ++i)
+            {
+                categories[Vulkan::MemoryCategoryName(static_cast<Vulkan::EMemoryCategory>(i))] = ToMB(heap.Categories[i]);
+            }
+            heaps.push_back(json11::Json::object{
+                {"index", static_cast<int>(heap.Index)},
+                {"device_local", heap.DeviceLocal},
+                {"size_mb", ToMB(heap.Size)},
+                {"budget_mb", ToMB(heap.Budget)},
+                {"usage_mb", ToMB(heap.Usage)},
+                {"tracked_mb", ToMB(heap.Tracked)},
+                {"peak_mb", ToMB(heap.Peak)},
+                {"allocations", static_cast<int>(heap.Allocations)},
+                {"categories_mb", categories},
+            });
+            if (heap.DeviceLocal)
+            {
+                vram += ToMB(heap.Tracked);
+            }
+        }
+
+        constexpr size_t MaxOwners = 16;
+        json11::Json::array owners;
+        for (const auto& owner : Vulkan::MemoryTracker::Owners())
+        {
+            if (owners.size() == MaxOwners)
+            {
+                break;
+            }
+            owners.push_back(json11::Json::object{
+                {"name", owner.Name},
+                {"category", Vulkan::MemoryCategoryName(owner.Category)},
+                {"mb", ToMB(owner.Bytes)},
+                {"allocations", static_cast<int>(owner.Allocations)},
+            });
+        }
+
+        return json11::Json::object{
+            {"budget_extension", device.MemoryBudgetSupported()},
+            {"vram_mb", vram},
+            {"vram_peak_mb", ToMB(Vulkan::MemoryTracker::DeviceLocalPeak())},
+            {"heaps", heaps},
+            {"owners", owners},
+        };
+    }
+
+    // nearest rank on an ascending sorted list
+    float Percentile(const std::vector<float>& sorted, double percent)
+    {
+        if (sorted.empty())
+        {
+            return 0;
+        }
+        const size_t rank = static_cast<size_t>(ceil(percent / 100.0 * sorted.size()));
+        return sorted[rank > 0 ? rank - 1 : 0];
+    }
+
+    struct FrameTimeStats
+    {
+        float Mean{};
+        float Median{};
+        float P1{};
+        float P5{};
+        float P95{};
+        float P99{};
+        float Min{};
+        float Max{};
+        uint32_t Stutters{};
+    };
+
+    FrameTimeStats ComputeFrameTimeStats(std::vector<float> frameTimes, float stutterFactor)
+    {
+        FrameTimeStats stats{};
+        if (frameTimes.empty())
+        {
+            return stats;
+        }
+
+        std::sort(frameTimes.begin(), frameTimes.end());
+        double sum = 0;
+        for (float frameTime : frameTimes)
+        {
+            sum += frameTime;
+        }
+        stats.Mean = static_cast<float>(sum / frameTimes.size());
+        stats.Median = Percentile(frameTimes, 50);
+        stats.P1 = Percentile(frameTimes, 1);
+        stats.P5 = Percentile(frameTimes, 5);
+        stats.P95 = Percentile(frameTimes, 95);
+        stats.P99 = Percentile(frameTimes, 99);
+        stats.Min = frameTimes.front();
+        stats.Max = frameTimes.back();
+
+        const float stutterTime = stats.Median * stutterFactor;
+        stats.Stutters = static_cast<uint32_t>(frameTimes.end() - std::upper_bound(frameTimes.begin(), frameTimes.end(), stutterTime));
+        return stats;
+    }
+}
+
 
 BenchMarker::BenchMarker()
 {
@@ -31,7 +177,15 @@ BenchMarker::BenchMarker()
     std::string report_filename = fmt::format("report_{:%d-%m-%Y-%H-%M-%S}.csv", fmt::localtime(now));
 
     benchmarkCsvReportFile.open(report_filename);
-    benchmarkCsvReportFile << fmt::format("#,scene,FPS\n");
+    benchmarkCsvReportFile << fmt::format("#,renderer,scene,resolution,FPS,mean ms,median ms,p1 ms,p5 ms,p95 ms,p99 ms,ci95 %,stable,stutters,load s,peak memory MB,vram MB,vram peak MB,Mrays/s,gpu passes ms\n");
+
+    jsonReportFilename_ = fmt::format("report_{:%d-%m-%Y-%H-%M-%S}.json", fmt::localtime(now));
+
+    // a few minutes at a few hundred fps, grows past that
+    frameTimes_.reserve(1 << 16);
+    passTimes_.resize(Utilities::Profiler::MaxScopeIds);
+    passFrames_.resize(Utilities::Profiler::MaxScopeIds);
+    passLastFrame_.resize(Utilities::Profiler::MaxScopeIds);
 }
 
 BenchMarker::~BenchMarker()
@@ -39,17 +193,60 @@ BenchMarker::~BenchMarker()
     benchmarkCsvReportFile.close();
 }
 
-void BenchMarker::OnSceneStart( double nowInSeconds )
+void BenchMarker::OnSceneStart( double nowInSeconds, double loadTimeInSeconds )
+{
+    sceneLoadTime_ = loadTimeInSeconds;
+    Restart(nowInSeconds);
+}
+
+void BenchMarker::Restart( double nowInSeconds )
 {
     periodTotalFrames_ = 0;
     benchmarkTotalFrames_ = 0;
     sceneInitialTime_ = nowInSeconds;
+    warmupEnd_ = nowInSeconds + GOption->BenchmarkWarmup;
+    warmedUp_ = false;
+
+    batchSum_ = 0;
+    batchCount_ = 0;
+    batchMean_ = 0;
+    batchM2_ = 0;
+
+    frameTimes_.clear();
+    std::fill(passTimes_.begin(), passTimes_.end(), 0.0);
+    std::fill(passFrames_.begin(), passFrames_.end(), 0);
+    std::fill(passLastFrame_.begin(), passLastFrame_.end(), UINT64_MAX);
+
+    rayTime_ = 0;
+    primaryRays_ = 0;
+    bounceRays_ = 0;
+    shadowRays_ = 0;
+    paths_ = 0;
+    earlyTerminations_ = 0;
+    rouletteTerminations_ = 0;
+    adaptiveSamples_ = 0;
+    bounceHistogram_.fill(0);
 }
 
 bool BenchMarker::OnTick( double nowInSeconds, Vulkan::VulkanBaseRenderer* renderer )
 {
     double prevTime = time_;
     time_ = nowInSeconds;
+
+    // Discard the warm-up: pipeline creation, textures still streaming in and swapchain recreation after a switch.
+    // It ends once, tasks queued while measuring (capture encodes and the like) do not start it over
+    if (!warmedUp_)
+    {
+        if (time_ < warmupEnd_ || !TaskCoordinator::GetInstance()->IsIdle())
+        {
+            periodTotalFrames_ = 0;
+            benchmarkTotalFrames_ = 0;
+            sceneInitialTime_ = time_;
+            return false;
+        }
+        warmedUp_ = true;
+    }
+
        // Initialise scene benchmark timers
     if (periodTotalFrames_ == 0)
     {
@@ -74,12 +271,61 @@ bool BenchMarker::OnTick( double nowInSeconds, Vulkan::VulkanBaseRenderer* rende
         benchmarkTotalFrames_++;
     }
 
+    // Frame time and gpu pass history, the first tick after the scene load only sets the baseline.
+    {
+        const Vulkan::VulkanGpuTimer& gpuTimer = *renderer->GpuTimer();
+        if (benchmarkTotalFrames_ > 1)
+        {
+            frameTimes_.push_back(static_cast<float>((time_ - prevTime) * 1000.0));
+            batchSum_ += frameTimes_.back();
+            if (frameTimes_.size() % BatchFrames == 0)
+            {
+                AddBatchMean(batchSum_ / BatchFrames);
+                batchSum_ = 0;
+            }
+
+            // the counters trail by a frame, which evens out over the run
+            if (GOption->RayStatistics)
+            {
+                const Assets::RayStatistics& rays = renderer->LastRayStatistics();
+                rayTime_ += time_ - prevTime;
+                primaryRays_ += rays.PrimaryRays;
+                bounceRays_ += rays.BounceRays;
+                shadowRays_ += rays.ShadowRays;
+                paths_ += rays.Paths;
+                earlyTerminations_ += rays.EarlyTerminations;
+                rouletteTerminations_ += rays.RouletteTerminations;
+                adaptiveSamples_ += rays.AdaptiveSamples;
+                for (uint32_t i = 0; i < RAY_STATS_BOUNCE_BINS; ++i)
+                {
+                    bounceHistogram_[i] += rays.BounceHistogram[i];
+                }
+            }
+
+            if (gpuTimer.CollectedFrame() != gpuFrame_)
+            {
+                for (const auto& result : gpuTimer.Results())
+                {
+                    passTimes_[result.Id] += result.Time;
+                    if (passLastFrame_[result.Id] != gpuTimer.CollectedFrame())
+                    {
+                        passLastFrame_[result.Id] = gpuTimer.CollectedFrame();
+                        passFrames_[result.Id]++;
+                    }
+                }
+            }
+        }
+        gpuFrame_ = gpuTimer.CollectedFrame();
+    }
+
     // If in benchmark mode, bail out from the scene if we've reached the time or sample limit.
     {
         const bool timeLimitReached = GOption->BenchmarkMaxFrame == 0 && periodTotalFrames_ != 0 && time_ - sceneInitialTime_ >
             GOption->BenchmarkMaxTime;
         const bool frameLimitReached = GOption->BenchmarkMaxFrame > 0 && benchmarkTotalFrames_ >= GOption->BenchmarkMaxFrame;
-        if (timeLimitReached || frameLimitReached)
+        const double confidence = RelativeConfidence();
+        const bool stable = GOption->BenchmarkStableCi > 0 && confidence > 0 && confidence <= GOption->BenchmarkStableCi;
+        if (timeLimitReached || frameLimitReached || stable)
         {
             return true;
         }
@@ -87,213 +333,146 @@ bool BenchMarker::OnTick( double nowInSeconds, Vulkan::VulkanBaseRenderer* rende
     return false;
 }
 
-void BenchMarker::OnReport(Vulkan::VulkanBaseRenderer* renderer, const std::string& SceneName)
+void BenchMarker::AddBatchMean(double batchMean)
 {
-    const double totalTime = time_ - sceneInitialTime_;
-    
-    double fps = benchmarkTotalFrames_ / totalTime;
-    fmt::print("{} totalTime {:%H:%M:%S} fps {:.3f}{}\n", CONSOLE_GOLD_COLOR, std::chrono::seconds(static_cast<long long>(totalTime)), fps, CONSOLE_DEFAULT_COLOR);
-    Report(renderer, static_cast<int>(floor(fps)), SceneName, false, GOption->SaveFile);
+    batchCount_++;
+    const double delta = batchMean - batchMean_;
+    batchMean_ += delta / batchCount_;
+    batchM2_ += delta * (batchMean - batchMean_);
 }
 
-
-inline const std::string versionToString(const uint32_t version)
+double BenchMarker::RelativeConfidence() const
 {
-    return fmt::format("{}.{}.{}", VK_VERSION_MAJOR(version), VK_VERSION_MINOR(version), VK_VERSION_PATCH(version));
+    if (batchCount_ < MinBatches || batchMean_ <= 0)
+    {
+        return 0;
+    }
+
+    // student t of the batch count, first cornish-fisher term over the normal quantile, close enough past a few dozen
+    const double z = 1.959964;
+    const double degrees = batchCount_ - 1;
+    const double t = z + (z * z * z + z) / (4.0 * degrees);
+    const double standardError = sqrt(batchM2_ / degrees / batchCount_);
+    return t * standardError / batchMean_;
 }
 
-void BenchMarker::Report(Vulkan::VulkanBaseRenderer* renderer_, int fps, const std::string& sceneName, bool upload_screen, bool save_screen)
+void BenchMarker::OnReport(Vulkan::VulkanBaseRenderer* renderer, const std::string& SceneName, const std::string& rendererName)
 {
-    // report file
-    benchmarkCsvReportFile << fmt::format("{},{},{}\n", benchUnit_++, sceneName, fps);
-    benchmarkCsvReportFile.flush();
-    // screenshot
-    VkPhysicalDeviceProperties deviceProp1{};
-    vkGetPhysicalDeviceProperties(renderer_->Device().PhysicalDevice(), &deviceProp1);
+    const double totalTime = time_ - sceneInitialTime_;
+    
+    double fps = benchmarkTotalFrames_ / totalTime;
+    fmt::print("{} totalTime {:%H:%M:%S} fps {:.3f}{}\n", CONSOLE_GOLD_COLOR, std::chrono::seconds(static_cast<long long>(totalTime)), fps, CONSOLE_DEFAULT_COLOR);
 
-    std::string img_encoded {};
-    if (upload_screen || save_screen)
+    const FrameTimeStats stats = ComputeFrameTimeStats(frameTimes_, StutterFactor);
+    const double peakMemory = PeakMemoryMB();
+    double vram = 0;
+    const json11::Json memory = MemoryReport(renderer->Device(), vram);
+    const double vramPeak = ToMB(Vulkan::MemoryTracker::DeviceLocalPeak());
+    const double confidence = RelativeConfidence();
+    const bool stable = GOption->BenchmarkStableCi > 0 && confidence > 0 && confidence <= GOption->BenchmarkStableCi;
+    const VkExtent2D extent = renderer->SwapChain().Extent();
+    const std::string resolution = fmt::format("{}x{}", extent.width, extent.height);
+    fmt::print("{} frame time mean {:.2f}ms (+-{:.2f}%) median {:.2f}ms p1 {:.2f}ms p99 {:.2f}ms, {} stutters, loaded in {:.2f}s, peak memory {:.0f}MB, vram {:.0f}MB (peak {:.0f}MB){}\n", CONSOLE_GOLD_COLOR,
+        stats.Mean, confidence * 100.0, stats.Median, stats.P1, stats.P99, stats.Stutters, sceneLoadTime_, peakMemory, vram, vramPeak, CONSOLE_DEFAULT_COLOR);
+
+    // mean gpu time per frame the pass ran in
+    std::string passesCsv;
+    json11::Json::object passes;
+    for (uint32_t id = 0; id < passTimes_.size(); ++id)
     {
-
-        // screenshot stuffs
-        const Vulkan::SwapChain& swapChain = renderer_->SwapChain();
-        const auto extent = swapChain.Extent();
-
-        // capture and export
-        renderer_->CaptureScreenShot();
-
-        // prepare data
-        void* data = nullptr;
-        uint32_t dataBytes = 0;
-        uint32_t rowBytes = 0;
-
-        constexpr uint32_t kCompCnt = 3;
-        if(swapChain.IsHDR())
-        {
-            dataBytes = extent.width * extent.height * 3 * 2;
-            rowBytes = extent.width * 3 * sizeof(uint16_t);
-            data = malloc(dataBytes);
-            
-            uint16_t* dataview = (uint16_t*)data;
-            {
-                Vulkan::DeviceMemory* vkMemory = renderer_->GetScreenShotMemory();
-                uint8_t* mappedData = (uint8_t*)vkMemory->Map(0, VK_WHOLE_SIZE);
-                uint32_t yDelta = extent.width * kCompCnt;
-                uint32_t xDelta = kCompCnt;
-                uint32_t yy = 0;
-                uint32_t xx = 0, idx = 0;
-                for (uint32_t y = 0; y < extent.height; y++)
-                {
-                    xx = 0;
-                    for (uint32_t x = 0; x < extent.width; x++)
-                    {
-                        uint32_t* pInPixel = (uint32_t*)&mappedData[idx];
-                        uint32_t uInPixel = *pInPixel;
-                        dataview[yy + xx + 2] = (uInPixel & (0b1111111111 << 20)) >> 20;
-                        dataview[yy + xx + 1] = (uInPixel & (0b1111111111 << 10)) >> 10;
-                        dataview[yy + xx + 0] = (uInPixel & (0b1111111111 << 0)) >> 0;
-                        
-                        idx += 4;
-                        xx += xDelta;
-                    }
-                    yy += yDelta;
-                }
-                vkMemory->Unmap();
-            }
-        }
-        else
-        {
-            dataBytes = extent.width * extent.height * kCompCnt;
-            rowBytes = extent.width * 3 * sizeof(uint8_t);
-            data = malloc(dataBytes);
-            
-            uint8_t* dataview = (uint8_t*)data;
-            {
-                Vulkan::DeviceMemory* vkMemory = renderer_->GetScreenShotMemory();
-                uint8_t* mappedData = (uint8_t*)vkMemory->Map(0, VK_WHOLE_SIZE);
-                uint32_t yDelta = extent.width * kCompCnt;
-                uint32_t xDelta = kCompCnt;
-                uint32_t yy = 0;
-                uint32_t xx = 0, idx = 0;
-                for (uint32_t y = 0; y < extent.height; y++)
-                {
-                    xx = 0;
-                    for (uint32_t x = 0; x < extent.width; x++)
-                    {
-                        uint32_t* pInPixel = (uint32_t*)&mappedData[idx];
-                        uint32_t uInPixel = *pInPixel;
-                        dataview[yy + xx] = (uInPixel & (0b11111111 << 16)) >> 16;
-                        dataview[yy + xx + 1] = (uInPixel & (0b11111111 << 8)) >> 8;
-                        dataview[yy + xx + 2] = (uInPixel & (0b11111111 << 0)) >> 0;
-                        idx += 4;
-                        xx += xDelta;
-                    }
-                    yy += yDelta;
-                }
-                vkMemory->Unmap();
-            }
-        }
-        
-#if WITH_AVIF
-        avifImage* image = avifImageCreate(extent.width, extent.height, swapChain.IsHDR() ? 10 : 8, AVIF_PIXEL_FORMAT_YUV444); // these values dictate what goes into the final AVIF
-        if (!image)
-        {
-            Throw(std::runtime_error("avif image creation failed"));
-        }
-        image->yuvRange = AVIF_RANGE_FULL;
-        image->colorPrimaries = swapChain.IsHDR() ? AVIF_COLOR_PRIMARIES_BT2020 : AVIF_COLOR_PRIMARIES_BT709;
-        image->transferCharacteristics = swapChain.IsHDR() ? AVIF_TRANSFER_CHARACTERISTICS_SMPTE2084 : AVIF_TRANSFER_CHARACTERISTICS_BT709;
-        image->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_IDENTITY;
-        image->clli.maxCLL = static_cast<uint16_t>(600); //maxCLLNits;
-        image->clli.maxPALL = 0; //maxFALLNits;
-
-        avifEncoder* encoder = NULL;
-        avifRWData avifOutput = AVIF_DATA_EMPTY;
-
-        avifRGBImage rgbAvifImage{};
-        avifRGBImageSetDefaults(&rgbAvifImage, image);
-        rgbAvifImage.format = AVIF_RGB_FORMAT_RGB;
-        rgbAvifImage.ignoreAlpha = AVIF_TRUE;
-        rgbAvifImage.pixels = (uint8_t*)data;
-        rgbAvifImage.rowBytes = rowBytes;
-
-        avifResult convertResult = avifImageRGBToYUV(image, &rgbAvifImage);
-        if (convertResult != AVIF_RESULT_OK)
-        {
-            Throw(std::runtime_error("Failed to convert RGB to YUV: " + std::string(avifResultToString(convertResult))));
-        }
-        encoder = avifEncoderCreate();
-        if (!encoder)
+        if (passFrames_[id] == 0)
         {
-            Throw(std::runtime_error("Failed to create encoder"));
+            continue;
         }
-        encoder->quality = 80;
-        encoder->qualityAlpha = AVIF_QUALITY_LOSSLESS;
-        encoder->speed = AVIF_SPEED_FASTEST;
+        const double passTime = passTimes_[id] / passFrames_[id];
+        passesCsv += fmt::format("{}{}={:.3f}", passesCsv.empty() ? "" : ";", Utilities::Profiler::Name(id), passTime);
+        passes[Utilities::Profiler::Name(id)] = passTime;
+    }
 
-        avifResult addImageResult = avifEncoderAddImage(encoder, image, 1, AVIF_ADD_IMAGE_FLAG_SINGLE);
-        if (addImageResult != AVIF_RESULT_OK)
-        {
-            Throw(std::runtime_error("Failed to add image: " + std::string(avifResultToString(addImageResult))));
-        }
-        avifResult finishResult = avifEncoderFinish(encoder, &avifOutput);
-        if (finishResult != AVIF_RESULT_OK)
-        {
-            Throw(std::runtime_error("Failed to finish encoding: " + std::string(avifResultToString(finishResult))));
-        }
+    const uint64_t totalRays = primaryRays_ + bounceRays_ + shadowRays_;
+    const double mrays = rayTime_ > 0 ? totalRays / rayTime_ * 1e-6 : 0.0;
+    const std::string mraysCsv = GOption->RayStatistics ? fmt::format("{:.1f}", mrays) : "";
+    if (GOption->RayStatistics)
+    {
+        fmt::print("{} {:.1f} Mrays/s, {:.2f} rays per path, {:.1f}% of the paths ended early, {:.1f}% by roulette{}\n", CONSOLE_GOLD_COLOR, mrays,
+            paths_ > 0 ? double(primaryRays_ + bounceRays_) / paths_ : 0.0, paths_ > 0 ? earlyTerminations_ * 100.0 / paths_ : 0.0,
+            paths_ > 0 ? rouletteTerminations_ * 100.0 / paths_ : 0.0, CONSOLE_DEFAULT_COLOR);
+    }
 
-        // save to file with scenename
-        std::string filename = sceneName + ".avif";
-        std::ofstream file(filename, std::ios::out | std::ios::binary);
-        if(file.is_open())
-        {
-            file.write(reinterpret_cast<const char*>(avifOutput.data), avifOutput.size);
-        }
-        file.close();
+    benchmarkCsvReportFile << fmt::format("{},{},{},{},{},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{:.2f},{},{},{:.3f},{:.1f},{:.1f},{:.1f},{},{}\n", benchUnit_, rendererName, SceneName, resolution,
+        static_cast<int>(floor(fps)), stats.Mean, stats.Median, stats.P1, stats.P5, stats.P95, stats.P99, confidence * 100.0, stable ? 1 : 0, stats.Stutters,
+        sceneLoadTime_, peakMemory, vram, vramPeak, mraysCsv, passesCsv);
+    benchmarkCsvReportFile.flush();
 
-        // send to server
-        img_encoded = base64_encode(avifOutput.data, avifOutput.size, false);
-#else
-        // save to file with scenename
-        std::string filename = sceneName + ".jpg";
-        
-        // if hdr, transcode 16bit to 8bit
-        if(swapChain.IsHDR())
-        {
-            uint16_t* dataview = (uint16_t*)data;
-            uint8_t* sdrData = (uint8_t*)malloc(extent.width * extent.height * kCompCnt);
-            for ( uint32_t i = 0; i < extent.width * extent.height * kCompCnt; i++ )
-            {
-                float scaled = dataview[i] / 1300.f * 2.0f;
-                scaled = scaled * scaled;
-                scaled *= 255.f;
-                sdrData[i] = (uint8_t)(std::min(scaled, 255.f));
-            }
-            stbi_write_jpg(filename.c_str(), extent.width, extent.height, kCompCnt, (const void*)sdrData, 91);
-            free(sdrData);
-        }
-        else
+    json11::Json::object scene = json11::Json::object{
+        {"index", benchUnit_},
+        {"scene", SceneName},
+        {"renderer", rendererName},
+        {"resolution", resolution},
+        {"frames", static_cast<int>(benchmarkTotalFrames_)},
+        {"total_time", totalTime},
+        {"fps", fps},
+        {"frame_time_ms", json11::Json::object{
+            {"mean", stats.Mean}, {"median", stats.Median}, {"min", stats.Min}, {"max", stats.Max},
+            {"p1", stats.P1}, {"p5", stats.P5}, {"p95", stats.P95}, {"p99", stats.P99}}},
+        {"ci95", confidence},
+        {"stable", stable},
+        {"warmup", static_cast<double>(GOption->BenchmarkWarmup)},
+        {"stutters", static_cast<int>(stats.Stutters)},
+        {"stutter_factor", StutterFactor},
+        {"load_time", sceneLoadTime_},
+        {"peak_memory_mb", peakMemory},
+        {"memory", memory},
+        {"gpu_passes_ms", passes},
+    };
+    if (GOption->RayStatistics)
+    {
+        // json numbers are doubles, exact far beyond any run length
+        json11::Json::array histogram;
+        for (const uint64_t count : bounceHistogram_)
         {
-            stbi_write_jpg(filename.c_str(), extent.width, extent.height, kCompCnt, (const void*)data, 91);
+            histogram.push_back(static_cast<double>(count));
         }
-#endif
-        free(data);
+        scene["rays"] = json11::Json::object{
+            {"mrays_per_second", mrays},
+            {"primary", static_cast<double>(primaryRays_)},
+            {"bounce", static_cast<double>(bounceRays_)},
+            {"shadow", static_cast<double>(shadowRays_)},
+            {"paths", static_cast<double>(paths_)},
+            {"early_terminations", static_cast<double>(earlyTerminations_)},
+            {"roulette_terminations", static_cast<double>(rouletteTerminations_)},
+            {"adaptive_samples", static_cast<double>(adaptiveSamples_)},
+            {"bounce_histogram", histogram},
+        };
     }
+    jsonScenes_.push_back(json11::Json(scene).dump());
+    WriteJsonReport();
+
+    Report(renderer, static_cast<int>(floor(fps)), SceneName, false, GOption->SaveFile);
+}
 
-    // perf server upload
-    if( NextRenderer::GetBuildVersion() != "v0.0.0.0" )
+void BenchMarker::WriteJsonReport()
+{
+    // rewritten after every scene so an aborted run still leaves a valid file
+    std::ofstream file(jsonReportFilename_, std::ios::out | std::ios::trunc);
+    file << fmt::format("{{\"version\":\"{}\",\"scenes\":[\n", NextRenderer::GetBuildVersion());
+    for (size_t i = 0; i < jsonScenes_.size(); ++i)
     {
-        json11::Json my_json = json11::Json::object{
-            {"renderer", renderer_->StaticClass()},
-            {"scene", sceneName},
-            {"gpu", std::string(deviceProp1.deviceName)},
-            {"driver", versionToString(deviceProp1.driverVersion)},
-            {"fps", fps},
-            {"version", NextRenderer::GetBuildVersion()},
-            {"screenshot", img_encoded}
-        };
-        std::string json_str = my_json.dump();
+        file << jsonScenes_[i] << (i + 1 < jsonScenes_.size() ? ",\n" : "\n");
+    }
+    file << "]}\n";
+}
 
+
+inline const std::string versionToString(const uint32_t version)
+{
+    return fmt::format("{}.{}.{}", VK_VERSION_MAJOR(version), VK_VERSION_MINOR(version), VK_VERSION_PATCH(version));
+}
+
+namespace
+{
+    void UploadReport(const std::string& json_str)
+    {
         fmt::print("Sending benchmark to perf server...\n");
         // upload from curl
         CURL* curl;
@@ -323,3 +502,50 @@ void BenchMarker::Report(Vulkan::VulkanBaseRenderer* renderer_, int fps, const s
         }
     }
 }
+
+void BenchMarker::Report(Vulkan::VulkanBaseRenderer* renderer_, int fps, const std::string& sceneName, bool upload_screen, bool save_screen)
+{
+    benchUnit_++;
+    // screenshot
+    VkPhysicalDeviceProperties deviceProp1{};
+    vkGetPhysicalDeviceProperties(renderer_->Device().PhysicalDevice(), &deviceProp1);
+
+    // hdr output goes through the async readback and lands a frame or two later, after the ldr screenshot
+    if (save_screen && GOption->SaveExr)
+    {
+        ScreenCapture::RequestExr(*renderer_, sceneName + ".exr", GOption->ExrFloat, GOption->ExrAov);
+    }
+
+    // perf server report, sent from a task thread once the screenshot (if any) is encoded
+    const bool upload = NextRenderer::GetBuildVersion() != "v0.0.0.0";
+    json11::Json::object report{
+        {"renderer", renderer_->StaticClass()},
+        {"scene", sceneName},
+        {"gpu", std::string(deviceProp1.deviceName)},
+        {"driver", versionToString(deviceProp1.driverVersion)},
+        {"fps", fps},
+        {"version", NextRenderer::GetBuildVersion()},
+        {"screenshot", std::string()}
+    };
+
+    if (upload_screen || save_screen)
+    {
+        // the screenshot is the frame after this one, copied inside its own command buffer and encoded off the render thread
+        ScreenCapture::RequestScreenShot(*renderer_, sceneName, [report, upload](const std::vector<uint8_t>& encoded) mutable
+        {
+            if (upload)
+            {
+#if WITH_AVIF
+                // the perf server only displays avif
+                report["screenshot"] = base64_encode(encoded.data(), encoded.size(), false);
+#endif
+                UploadReport(json11::Json(report).dump());
+            }
+        });
+    }
+    else if (upload)
+    {
+        const std::string json_str = json11::Json(report).dump();
+        TaskCoordinator::GetInstance()->AddTask([json_str](ResTask&) { UploadReport(json_str); }, nullptr, 2);
+    }
+}
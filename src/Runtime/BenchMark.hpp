@@ -1,6 +1,9 @@
 #pragma once
 
+#include <array>
 #include <fstream>
+#include <string>
+#include <vector>
 #include "Vulkan/VulkanBaseRenderer.hpp"
 
 class BenchMarker final
@@ -9,10 +12,20 @@ public:
 	BenchMarker();
 	~BenchMarker();
 	
-	void OnSceneStart( double nowInSeconds );
+	// loadTimeInSeconds covers the scene from the load request until it is ready to render
+	void OnSceneStart( double nowInSeconds, double loadTimeInSeconds );
+	// starts the warm-up and measurement over without a scene load, after a renderer or resolution switch
+	void Restart( double nowInSeconds );
 	bool OnTick( double nowInSeconds, Vulkan::VulkanBaseRenderer* renderer );
-	void OnReport(Vulkan::VulkanBaseRenderer* renderer, const std::string& SceneName);
+	void OnReport(Vulkan::VulkanBaseRenderer* renderer, const std::string& SceneName, const std::string& rendererName);
 	void Report(Vulkan::VulkanBaseRenderer* renderer_, int fps, const std::string& sceneName, bool upload_screen, bool save_screen);
+
+	// a frame counts as a stutter when it takes this many times the median frame time
+	static constexpr float StutterFactor = 2.0f;
+	// the stable-ci stop looks at means of this many consecutive frames, which are far less correlated than single
+	// frame times, and waits for enough of them to trust the interval
+	static constexpr uint32_t BatchFrames = 16;
+	static constexpr uint32_t MinBatches = 32;
 	// Benchmark stats
 	int32_t benchUnit_{};
 	double time_{};
@@ -21,4 +34,40 @@ public:
 	uint32_t periodTotalFrames_{};
 	uint32_t benchmarkTotalFrames_{};
 	std::ofstream benchmarkCsvReportFile;
+
+private:
+	void WriteJsonReport();
+	void AddBatchMean(double batchMean);
+	// 95% confidence half-width of the mean frame time relative to it, 0 until there are enough batches
+	double RelativeConfidence() const;
+
+	// per scene, frame times in milliseconds and per-pass gpu totals indexed by profiler scope id
+	std::vector<float> frameTimes_;
+	std::vector<double> passTimes_;
+	std::vector<uint32_t> passFrames_;
+	std::vector<uint64_t> passLastFrame_;
+	uint64_t gpuFrame_{};
+	double sceneLoadTime_{};
+
+	// gpu ray counters summed over the measured frames, only with --ray-stats
+	double rayTime_{};
+	uint64_t primaryRays_{};
+	uint64_t bounceRays_{};
+	uint64_t shadowRays_{};
+	uint64_t paths_{};
+	uint64_t earlyTerminations_{};
+	uint64_t rouletteTerminations_{};
+	uint64_t adaptiveSamples_{};
+	std::array<uint64_t, RAY_STATS_BOUNCE_BINS> bounceHistogram_{};
+	double warmupEnd_{};
+	bool warmedUp_{};
+
+	// running mean and squared deviation of the batch means (Welford)
+	double batchSum_{};
+	uint32_t batchCount_{};
+	double batchMean_{};
+	double batchM2_{};
+
+	std::string jsonReportFilename_;
+	std::vector<std::string> jsonScenes_;
 };
@@ -0,0 +1,144 @@
+#include "CameraPath.hpp"
+#include "Utilities/FileHelper.hpp"
+#include "ThirdParty/json11/json11.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	constexpr int FileVersion = 1;
+	// time, position xyz, orientation wxyz, field of view, aperture, focus distance
+	constexpr size_t KeyFields = 11;
+}
+
+std::string CameraPath::FileName(const std::string& sceneName)
+{
+	return Utilities::FileHelper::GetPlatformFilePath("assets/models/") + sceneName + ".campath.json";
+}
+
+bool CameraPath::Load(const std::string& filename)
+{
+	keys_.clear();
+
+	std::ifstream file(filename);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	std::stringstream content;
+	content << file.rdbuf();
+
+	std::string error;
+	const json11::Json root = json11::Json::parse(content.str(), error);
+	if (!error.empty() || root["version"].int_value() != FileVersion)
+	{
+		return false;
+	}
+
+	for (const auto& item : root["keys"].array_items())
+	{
+		const auto& fields = item.array_items();
+		if (fields.size() != KeyFields)
+		{
+			keys_.clear();
+			return false;
+		}
+
+		Key key{};
+		key.Time = static_cast<float>(fields[0].number_value());
+		key.Position = glm::vec3(fields[1].number_value(), fields[2].number_value(), fields[3].number_value());
+		key.Orientation = glm::normalize(glm::quat(static_cast<float>(fields[4].number_value()), static_cast<float>(fields[5].number_value()),
+			static_cast<float>(fields[6].number_value()), static_cast<float>(fields[7].number_value())));
+		key.FieldOfView = static_cast<float>(fields[8].number_value());
+		key.Aperture = static_cast<float>(fields[9].number_value());
+		key.FocusDistance = static_cast<float>(fields[10].number_value());
+
+		// keys have to move forward in time for the sampling search
+		if (!keys_.empty() && key.Time < keys_.back().Time)
+		{
+			keys_.clear();
+			return false;
+		}
+		keys_.push_back(key);
+	}
+
+	return !keys_.empty();
+}
+
+bool CameraPath::Save(const std::string& filename, const std::string& sceneName) const
+{
+	json11::Json::array keys;
+	keys.reserve(keys_.size());
+	for (const auto& key : keys_)
+	{
+		keys.push_back(json11::Json::array{
+			key.Time,
+			key.Position.x, key.Position.y, key.Position.z,
+			key.Orientation.w, key.Orientation.x, key.Orientation.y, key.Orientation.z,
+			key.FieldOfView, key.Aperture, key.FocusDistance});
+	}
+
+	const json11::Json root = json11::Json::object{
+		{"version", FileVersion},
+		{"scene", sceneName},
+		{"keys", keys},
+	};
+
+	std::ofstream file(filename, std::ios::out | std::ios::trunc);
+	file << root.dump();
+	return file.good();
+}
+
+void CameraPath::Record(double time, const glm::mat4& modelView, float fieldOfView, float aperture, float focusDistance)
+{
+	if (!keys_.empty() && time - keys_.back().Time < RecordInterval)
+	{
+		return;
+	}
+
+	Key key{};
+	key.Time = static_cast<float>(time);
+	key.Position = glm::vec3(glm::inverse(modelView) * glm::vec4(0, 0, 0, 1));
+	key.Orientation = glm::normalize(glm::quat_cast(glm::mat3(modelView)));
+	key.FieldOfView = fieldOfView;
+	key.Aperture = aperture;
+	key.FocusDistance = focusDistance;
+	keys_.push_back(key);
+}
+
+CameraPath::Key CameraPath::Sample(double time) const
+{
+	if (keys_.empty())
+	{
+		return {};
+	}
+	if (time <= keys_.front().Time)
+	{
+		return keys_.front();
+	}
+	if (time >= keys_.back().Time)
+	{
+		return keys_.back();
+	}
+
+	const auto next = std::upper_bound(keys_.begin(), keys_.end(), time, [](double t, const Key& key) { return t < key.Time; });
+	const Key& a = *(next - 1);
+	const Key& b = *next;
+	const float t = b.Time > a.Time ? static_cast<float>((time - a.Time) / (b.Time - a.Time)) : 1.0f;
+
+	Key key{};
+	key.Time = static_cast<float>(time);
+	key.Position = glm::mix(a.Position, b.Position, t);
+	key.Orientation = glm::slerp(a.Orientation, b.Orientation, t);
+	key.FieldOfView = glm::mix(a.FieldOfView, b.FieldOfView, t);
+	key.Aperture = glm::mix(a.Aperture, b.Aperture, t);
+	key.FocusDistance = glm::mix(a.FocusDistance, b.FocusDistance, t);
+	return key;
+}
+
+glm::mat4 CameraPath::ModelView(const Key& key)
+{
+	return glm::mat4(glm::mat3_cast(key.Orientation)) * glm::translate(glm::mat4(1), -key.Position);
+}
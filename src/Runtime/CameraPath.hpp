@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Utilities/Glm.hpp"
+#include <glm/gtc/quaternion.hpp>
+#include <string>
+#include <vector>
+
+// Camera keys over time, recorded from the interactive camera and replayed at a fixed time step per frame, so a
+// benchmark flies the same path with the same frame count on every machine. Paths are stored as json next to the scenes.
+class CameraPath final
+{
+public:
+	struct Key
+	{
+		float Time;
+		glm::vec3 Position;
+		glm::quat Orientation;
+		float FieldOfView;
+		float Aperture;
+		float FocusDistance;
+	};
+
+	// recording keeps at most one key per interval, replay interpolates between them
+	static constexpr double RecordInterval = 1.0 / 30.0;
+
+	static std::string FileName(const std::string& sceneName);
+
+	bool Load(const std::string& filename);
+	bool Save(const std::string& filename, const std::string& sceneName) const;
+	void Clear() { keys_.clear(); }
+
+	void Record(double time, const glm::mat4& modelView, float fieldOfView, float aperture, float focusDistance);
+
+	// clamped to the first and last key
+	Key Sample(double time) const;
+	static glm::mat4 ModelView(const Key& key);
+
+	bool Empty() const { return keys_.empty(); }
+	size_t KeyCount() const { return keys_.size(); }
+	double Duration() const { return keys_.empty() ? 0.0 : keys_.back().Time; }
+
+private:
+	std::vector<Key> keys_;
+};
@@ -0,0 +1,395 @@
+#include "Convergence.hpp"
+#include "TaskCoordinator.hpp"
+#include "Assets/UniformBuffer.hpp"
+#include "Utilities/Console.hpp"
+#include "Vulkan/Device.hpp"
+#include "Vulkan/ReadbackRing.hpp"
+#include "Vulkan/RenderImage.hpp"
+#include "Vulkan/VulkanBaseRenderer.hpp"
+#include "ThirdParty/json11/json11.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <vector>
+#include <fmt/format.h>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace
+{
+	// shares the capture thread, samples are measured in request order
+	constexpr uint8_t ConvergenceTaskPriority = 2;
+
+	constexpr char ReferenceMagic[8] = {'G', 'K', 'R', 'E', 'F', '0', '2', '\0'};
+
+	// keeps relMSE finite in black regions, the usual 1e-2 of the rendering literature
+	constexpr double RelMseEpsilon = 1e-2;
+	// an exact match would be infinitely many dB
+	constexpr double MaxPsnr = 100.0;
+
+	// 32 bit fnv-1a, short enough for a file name
+	uint32_t Fnv1a(const void* data, size_t size)
+	{
+		const auto* bytes = static_cast<const uint8_t*>(data);
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash = (hash ^ bytes[i]) * 16777619u;
+		}
+		return hash;
+	}
+
+	// rgb of an rgba16f image against the rgb float reference; psnr is taken on values clamped to [0, 1]. A pixel with a
+	// nan or inf channel on either side is left out and counted instead, one would otherwise poison the whole curve
+	void MeasureError(const uint16_t* halfs, const std::vector<float>& reference, ConvergenceBenchmark::Sample& sample)
+	{
+		const size_t pixelCount = reference.size() / 3;
+		double squared = 0;
+		double relative = 0;
+		double clamped = 0;
+		size_t valid = 0;
+		uint32_t nonFinite = 0;
+		for (size_t i = 0; i < pixelCount; ++i)
+		{
+			double value[3];
+			double target[3];
+			bool finite = true;
+			for (size_t c = 0; c < 3; ++c)
+			{
+				value[c] = glm::unpackHalf1x16(halfs[i * 4 + c]);
+				target[c] = reference[i * 3 + c];
+				finite = finite && std::isfinite(value[c]) && std::isfinite(target[c]);
+			}
+			if (!finite)
+			{
+				++nonFinite;
+				continue;
+			}
+
+			for (size_t c = 0; c < 3; ++c)
+			{
+				const double error = value[c] - target[c];
+				const double clampedError = std::clamp(value[c], 0.0, 1.0) - std::clamp(target[c], 0.0, 1.0);
+				squared += error * error;
+				relative += error * error / (target[c] * target[c] + RelMseEpsilon);
+				clamped += clampedError * clampedError;
+				++valid;
+			}
+		}
+
+		const double count = static_cast<double>(std::max<size_t>(valid, 1));
+		sample.Rmse = std::sqrt(squared / count);
+		sample.RelMse = relative / count;
+		sample.Psnr = clamped > 0 ? std::min(MaxPsnr, 10.0 * std::log10(count / clamped)) : MaxPsnr;
+		sample.NonFinite = nonFinite;
+	}
+}
+
+struct ConvergenceBenchmark::State
+{
+	std::mutex mutex;
+	std::vector<Sample> samples;
+	std::atomic<uint32_t> outstanding{};
+
+	// rgb, written before the first sample is requested and read only after that
+	std::vector<float> reference;
+	uint32_t width{};
+	uint32_t height{};
+};
+
+ConvergenceBenchmark::ConvergenceBenchmark(std::string sceneName, uint32_t rendererType, std::string referenceFile, uint32_t referenceFrames,
+	uint32_t intervalMs, uint32_t maxSeconds, float threshold) :
+	sceneName_(std::move(sceneName)),
+	rendererType_(rendererType),
+	referenceFile_(std::move(referenceFile)),
+	referenceFrames_(std::max(referenceFrames, 1u)),
+	interval_(std::max(intervalMs, 1u) / 1000.0),
+	maxTime_(maxSeconds),
+	threshold_(threshold),
+	state_(std::make_shared<State>())
+{
+}
+
+void ConvergenceBenchmark::Tick(Vulkan::VulkanBaseRenderer& renderer, double nowInSeconds)
+{
+	const auto startMeasure = [this, nowInSeconds]()
+	{
+		// the accumulation restarts with the next frame
+		frame_ = 0;
+		startTime_ = nowInSeconds;
+		nextSample_ = interval_;
+		phase_ = EPhase::Measure;
+		fmt::print("{} convergence: measuring for {}s, a sample every {:.2f}s{}\n", CONSOLE_GREEN_COLOR, maxTime_, interval_, CONSOLE_DEFAULT_COLOR);
+	};
+
+	switch (phase_)
+	{
+	case EPhase::Start:
+		{
+			// textures still streaming in would end up in the reference, later the sample tasks keep the queue busy
+			if (!TaskCoordinator::GetInstance()->IsIdle())
+			{
+				return;
+			}
+
+			const Vulkan::RenderImage* output = renderer.GetLinearOutputImage();
+			if (output == nullptr || output->GetImage().Format() != VK_FORMAT_R16G16B16A16_SFLOAT)
+			{
+				fmt::print("{} convergence: renderer has no linear output{}\n", CONSOLE_GOLD_COLOR, CONSOLE_DEFAULT_COLOR);
+				phase_ = EPhase::Done;
+				return;
+			}
+
+			const VkExtent2D extent = output->GetImage().Extent();
+			state_->width = extent.width;
+			state_->height = extent.height;
+			if (referenceFile_.empty())
+			{
+				referenceFile_ = fmt::format("reference_{}_{}x{}_{}_{:08x}.bin", sceneName_, extent.width, extent.height, referenceFrames_,
+					Fnv1a(&settings_, sizeof(settings_)));
+			}
+
+			if (LoadReference())
+			{
+				fmt::print("{} convergence: using cached reference {}{}\n", CONSOLE_GREEN_COLOR, referenceFile_, CONSOLE_DEFAULT_COLOR);
+				startMeasure();
+				return;
+			}
+
+			fmt::print("{} convergence: rendering a {} frame reference into {}{}\n", CONSOLE_GREEN_COLOR, referenceFrames_, referenceFile_, CONSOLE_DEFAULT_COLOR);
+			frame_ = 0;
+			phase_ = EPhase::Reference;
+			return;
+		}
+	case EPhase::Reference:
+		if (frame_ < referenceFrames_)
+		{
+			return;
+		}
+		if (!RenderReference(renderer))
+		{
+			phase_ = EPhase::Done;
+			return;
+		}
+		startMeasure();
+		return;
+	case EPhase::Measure:
+		{
+			const double elapsed = nowInSeconds - startTime_;
+			if (elapsed >= nextSample_)
+			{
+				RequestSample(renderer, elapsed);
+				// a slow frame skips the intervals it covered rather than sampling them all at once
+				while (nextSample_ <= elapsed)
+				{
+					nextSample_ += interval_;
+				}
+			}
+			if (elapsed >= maxTime_)
+			{
+				phase_ = EPhase::Drain;
+			}
+			return;
+		}
+	case EPhase::Drain:
+		if (state_->outstanding.load() == 0)
+		{
+			WriteResults();
+			phase_ = EPhase::Done;
+		}
+		return;
+	case EPhase::Done:
+		return;
+	}
+}
+
+void ConvergenceBenchmark::OverrideUniformBufferObject(Assets::UniformBufferObject& ubo)
+{
+	if (phase_ == EPhase::Start)
+	{
+		// the view the reference is taken of, the last frame before it starts wins
+		settings_.Renderer = rendererType_;
+		settings_.Samples = ubo.NumberOfSamples;
+		settings_.Bounces = ubo.NumberOfBounces;
+		settings_.MaxBounces = ubo.MaxNumberOfBounces;
+		settings_.RussianRouletteDepth = ubo.RussianRouletteDepth;
+		settings_.FireflyClamp = ubo.FireflyClamp;
+		settings_.RadianceCacheBounce = ubo.RadianceCacheBounce;
+		settings_.Sampler = ubo.Sampler;
+		settings_.LightTree = ubo.UseLightTree;
+		settings_.AdaptiveSample = ubo.AdaptiveSample;
+		std::memcpy(settings_.ModelView, glm::value_ptr(ubo.ModelView), sizeof(settings_.ModelView));
+		std::memcpy(settings_.Projection, glm::value_ptr(ubo.Projection), sizeof(settings_.Projection));
+		settings_.Aperture = ubo.Aperture;
+		settings_.FocusDistance = ubo.FocusDistance;
+		return;
+	}
+	if (phase_ != EPhase::Reference && phase_ != EPhase::Measure)
+	{
+		return;
+	}
+
+	// one exact running mean from the first frame on, never capped by the temporal window. The measurement's samples
+	// follow the reference's in the sequences, it would otherwise be built from the reference's own first samples
+	ubo.TotalFrames = frame_;
+	ubo.TemporalFrames = frame_ + 1;
+	ubo.SampleOffset = phase_ == EPhase::Measure ? referenceFrames_ : 0;
+	ubo.PrevViewProjection = ubo.ViewProjection;
+	++frame_;
+}
+
+bool ConvergenceBenchmark::LoadReference()
+{
+	std::ifstream file(referenceFile_, std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	char magic[sizeof(ReferenceMagic)]{};
+	uint32_t header[3]{};
+	ReferenceSettings settings{};
+	file.read(magic, sizeof(magic));
+	file.read(reinterpret_cast<char*>(header), sizeof(header));
+	file.read(reinterpret_cast<char*>(&settings), sizeof(settings));
+	if (!file || std::memcmp(magic, ReferenceMagic, sizeof(magic)) != 0 || header[0] != state_->width || header[1] != state_->height ||
+		header[2] != referenceFrames_ || std::memcmp(&settings, &settings_, sizeof(settings)) != 0)
+	{
+		fmt::print("{} convergence: {} does not match this view, rendering it again{}\n", CONSOLE_GOLD_COLOR, referenceFile_, CONSOLE_DEFAULT_COLOR);
+		return false;
+	}
+
+	state_->reference.resize(static_cast<size_t>(state_->width) * state_->height * 3);
+	file.read(reinterpret_cast<char*>(state_->reference.data()), state_->reference.size() * sizeof(float));
+	if (!file)
+	{
+		state_->reference.clear();
+		return false;
+	}
+	return true;
+}
+
+bool ConvergenceBenchmark::RenderReference(Vulkan::VulkanBaseRenderer& renderer)
+{
+	// a one-off, the blocking copy is fine here
+	renderer.Device().WaitIdle();
+	std::vector<float> rgba;
+	VkExtent2D extent{};
+	if (!renderer.CaptureLinearOutput(rgba, extent) || extent.width != state_->width || extent.height != state_->height)
+	{
+		fmt::print("{} convergence: failed to read the reference back{}\n", CONSOLE_GOLD_COLOR, CONSOLE_DEFAULT_COLOR);
+		return false;
+	}
+
+	const size_t pixelCount = static_cast<size_t>(extent.width) * extent.height;
+	state_->reference.resize(pixelCount * 3);
+	for (size_t i = 0; i < pixelCount; ++i)
+	{
+		std::copy_n(&rgba[i * 4], 3, &state_->reference[i * 3]);
+	}
+
+	std::ofstream file(referenceFile_, std::ios::binary | std::ios::trunc);
+	const uint32_t header[3] = {extent.width, extent.height, referenceFrames_};
+	file.write(ReferenceMagic, sizeof(ReferenceMagic));
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(&settings_), sizeof(settings_));
+	file.write(reinterpret_cast<const char*>(state_->reference.data()), state_->reference.size() * sizeof(float));
+	if (!file)
+	{
+		// the run can still go on, the next one renders the reference again
+		fmt::print("{} convergence: failed to cache the reference in {}{}\n", CONSOLE_GOLD_COLOR, referenceFile_, CONSOLE_DEFAULT_COLOR);
+	}
+	return true;
+}
+
+void ConvergenceBenchmark::RequestSample(Vulkan::VulkanBaseRenderer& renderer, double time)
+{
+	// the readback lands at the end of the next frame, which adds one more pass
+	const uint32_t frames = frame_ + 1;
+	Vulkan::VulkanBaseRenderer* rendererPtr = &renderer;
+	std::shared_ptr<State> state = state_;
+	state->outstanding.fetch_add(1);
+
+	renderer.RequestReadback(Vulkan::EReadbackSource::LinearOutput, [rendererPtr, state, time, frames](const Vulkan::ReadbackRing::Slot& slot)
+	{
+		TaskCoordinator::GetInstance()->AddTask([rendererPtr, state, time, frames, slot](ResTask&)
+		{
+			const VkExtent2D extent = slot.Regions[0].Extent;
+			if (extent.width == state->width && extent.height == state->height)
+			{
+				Sample sample{time, frames, 0, 0, 0, 0};
+				MeasureError(reinterpret_cast<const uint16_t*>(slot.Data[0]), state->reference, sample);
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->samples.push_back(sample);
+			}
+			rendererPtr->GetReadbackRing().Release(slot.Index);
+			state->outstanding.fetch_sub(1);
+		},
+		nullptr,
+		ConvergenceTaskPriority);
+	},
+	[state]()
+	{
+		state->outstanding.fetch_sub(1);
+	});
+}
+
+void ConvergenceBenchmark::WriteResults() const
+{
+	std::vector<Sample> samples;
+	{
+		std::lock_guard<std::mutex> lock(state_->mutex);
+		samples = state_->samples;
+	}
+	std::sort(samples.begin(), samples.end(), [](const Sample& a, const Sample& b) { return a.Time < b.Time; });
+
+	const auto reached = std::find_if(samples.begin(), samples.end(), [this](const Sample& sample) { return sample.RelMse <= threshold_; });
+
+	std::ofstream csv(fmt::format("convergence_{}.csv", sceneName_), std::ios::out | std::ios::trunc);
+	csv << "time s,frames,rmse,relmse,psnr db,nonfinite pixels\n";
+	json11::Json::array curve;
+	uint32_t maxNonFinite = 0;
+	for (const auto& sample : samples)
+	{
+		csv << fmt::format("{:.3f},{},{:.6g},{:.6g},{:.3f},{}\n", sample.Time, sample.Frames, sample.Rmse, sample.RelMse, sample.Psnr, sample.NonFinite);
+		curve.push_back(json11::Json::object{
+			{"time", sample.Time}, {"frames", static_cast<int>(sample.Frames)},
+			{"rmse", sample.Rmse}, {"relmse", sample.RelMse}, {"psnr", sample.Psnr},
+			{"nonfinite", static_cast<int>(sample.NonFinite)}});
+		maxNonFinite = std::max(maxNonFinite, sample.NonFinite);
+	}
+
+	const json11::Json report = json11::Json::object{
+		{"scene", sceneName_},
+		{"reference", referenceFile_},
+		{"reference_frames", static_cast<int>(referenceFrames_)},
+		{"relmse_threshold", threshold_},
+		{"time_to_threshold", reached != samples.end() ? json11::Json(reached->Time) : json11::Json()},
+		{"frames_to_threshold", reached != samples.end() ? json11::Json(static_cast<int>(reached->Frames)) : json11::Json()},
+		{"max_nonfinite", static_cast<int>(maxNonFinite)},
+		{"samples", curve},
+	};
+	std::ofstream json(fmt::format("convergence_{}.json", sceneName_), std::ios::out | std::ios::trunc);
+	json << report.dump();
+
+	if (maxNonFinite > 0)
+	{
+		fmt::print("{} convergence: up to {} pixels had nan or inf channels and were left out of the error{}\n", CONSOLE_GOLD_COLOR,
+			maxNonFinite, CONSOLE_DEFAULT_COLOR);
+	}
+
+	if (reached != samples.end())
+	{
+		fmt::print("{} convergence: relMSE {} reached after {:.2f}s and {} frames, final psnr {:.2f}dB{}\n", CONSOLE_GREEN_COLOR,
+			threshold_, reached->Time, reached->Frames, samples.back().Psnr, CONSOLE_DEFAULT_COLOR);
+	}
+	else
+	{
+		fmt::print("{} convergence: relMSE {} not reached in {}s, final relMSE {:.6g}{}\n", CONSOLE_GOLD_COLOR,
+			threshold_, maxTime_, samples.empty() ? 0.0 : samples.back().RelMse, CONSOLE_DEFAULT_COLOR);
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace Vulkan
+{
+	class VulkanBaseRenderer;
+}
+
+namespace Assets
+{
+	struct UniformBufferObject;
+}
+
+// Measures how fast the linear accumulation approaches a high pass count reference of the same view. The reference is
+// rendered once and cached; the run then restarts the accumulation and logs RMSE, relMSE and PSNR against it at fixed
+// wall-clock intervals, ending with a time versus error curve and the time it took to reach the relMSE threshold.
+class ConvergenceBenchmark final
+{
+public:
+	struct Sample
+	{
+		double Time;
+		uint32_t Frames;
+		double Rmse;
+		double RelMse;
+		double Psnr;
+		// pixels left out of the error for a nan or inf channel
+		uint32_t NonFinite;
+	};
+
+	ConvergenceBenchmark(std::string sceneName, uint32_t rendererType, std::string referenceFile, uint32_t referenceFrames, uint32_t intervalMs,
+		uint32_t maxSeconds, float threshold);
+
+	// call after each DrawFrame once the scene is loaded, it waits for the textures by itself
+	void Tick(Vulkan::VulkanBaseRenderer& renderer, double nowInSeconds);
+	void OverrideUniformBufferObject(Assets::UniformBufferObject& ubo);
+
+	bool Finished() const { return phase_ == EPhase::Done; }
+
+private:
+	enum class EPhase
+	{
+		Start,
+		Reference,
+		Measure,
+		Drain,
+		Done,
+	};
+
+	struct State;
+
+	// what the reference depends on besides the scene and the resolution, hashed into its name and checked against its
+	// header. Plain 32 bit fields so it can be written and compared as bytes
+	struct ReferenceSettings
+	{
+		uint32_t Renderer;
+		uint32_t Samples;
+		uint32_t Bounces;
+		uint32_t MaxBounces;
+		uint32_t RussianRouletteDepth;
+		uint32_t FireflyClamp;
+		uint32_t RadianceCacheBounce;
+		uint32_t Sampler;
+		uint32_t LightTree;
+		uint32_t AdaptiveSample;
+		float ModelView[16];
+		float Projection[16];
+		float Aperture;
+		float FocusDistance;
+	};
+	static_assert(sizeof(ReferenceSettings) == 44 * sizeof(uint32_t), "ReferenceSettings must have no padding");
+
+	bool LoadReference();
+	bool RenderReference(Vulkan::VulkanBaseRenderer& renderer);
+	void RequestSample(Vulkan::VulkanBaseRenderer& renderer, double time);
+	void WriteResults() const;
+
+	const std::string sceneName_;
+	const uint32_t rendererType_;
+	std::string referenceFile_;
+	const uint32_t referenceFrames_;
+	const double interval_;
+	const double maxTime_;
+	const float threshold_;
+
+	EPhase phase_{EPhase::Start};
+	uint32_t frame_{};
+	double startTime_{};
+	double nextSample_{};
+	ReferenceSettings settings_{};
+	std::shared_ptr<State> state_;
+};
@@ -0,0 +1,743 @@
+#include "DistributedRender.hpp"
+#include "Options.hpp"
+#include "Assets/UniformBuffer.hpp"
+#include "Utilities/Console.hpp"
+#include "Utilities/Exception.hpp"
+#include "Vulkan/Device.hpp"
+#include "Vulkan/VulkanBaseRenderer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fmt/format.h>
+
+#include "stb_image_write.h"
+
+#if WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <signal.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using Distributed::ProcessHandle;
+using Distributed::SocketHandle;
+
+namespace
+{
+	constexpr SocketHandle InvalidSocket = -1;
+	constexpr ProcessHandle InvalidProcess = -1;
+	constexpr uint32_t ProtocolMagic = 0x444E4B47; // "GKND"
+	// how long workers that were sent a shutdown get to tear down their device before they are killed
+	constexpr auto WorkerExitGrace = std::chrono::seconds(10);
+
+	enum class EMessage : uint32_t
+	{
+		Hello = 1,
+		Job,
+		Result,
+		Shutdown,
+	};
+
+	struct MessageHeader
+	{
+		uint32_t Magic;
+		EMessage Type;
+		uint32_t PayloadBytes;
+	};
+
+	// followed by Width * Height rgb floats
+	struct ResultHeader
+	{
+		uint32_t JobIndex;
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t PassCount;
+	};
+
+	void InitSockets()
+	{
+#if WIN32
+		static const bool initialized = []()
+		{
+			WSADATA data;
+			return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+		}();
+		if (!initialized)
+		{
+			Throw(std::runtime_error("failed to initialize winsock"));
+		}
+#endif
+	}
+
+	void CloseSocket(SocketHandle socket)
+	{
+		if (socket == InvalidSocket)
+		{
+			return;
+		}
+#if WIN32
+		closesocket(static_cast<SOCKET>(socket));
+#else
+		close(static_cast<int>(socket));
+#endif
+	}
+
+	SocketHandle OpenSocket()
+	{
+		const auto handle = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+#if WIN32
+		if (handle == INVALID_SOCKET)
+		{
+			return InvalidSocket;
+		}
+#else
+		if (handle < 0)
+		{
+			return InvalidSocket;
+		}
+#endif
+		SocketHandle socket = static_cast<SocketHandle>(handle);
+#if __APPLE__
+		int noSigPipe = 1;
+		setsockopt(static_cast<int>(socket), SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+		return socket;
+	}
+
+	sockaddr_in LoopbackAddress(uint32_t port)
+	{
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(static_cast<uint16_t>(port));
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		return address;
+	}
+
+	// 0 seconds blocks forever
+	void SetReceiveTimeout(SocketHandle socket, uint32_t seconds)
+	{
+#if WIN32
+		DWORD timeout = seconds * 1000;
+		setsockopt(static_cast<SOCKET>(socket), SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+#else
+		timeval timeout{};
+		timeout.tv_sec = seconds;
+		setsockopt(static_cast<int>(socket), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#endif
+	}
+
+	bool SendAll(SocketHandle socket, const void* data, size_t bytes)
+	{
+		const char* cursor = static_cast<const char*>(data);
+		while (bytes > 0)
+		{
+			const int chunk = static_cast<int>(std::min<size_t>(bytes, 1 << 20));
+#if WIN32
+			const int sent = send(static_cast<SOCKET>(socket), cursor, chunk, 0);
+#elif __APPLE__
+			const int sent = static_cast<int>(send(static_cast<int>(socket), cursor, chunk, 0));
+#else
+			const int sent = static_cast<int>(send(static_cast<int>(socket), cursor, chunk, MSG_NOSIGNAL));
+#endif
+			if (sent <= 0)
+			{
+				return false;
+			}
+			cursor += sent;
+			bytes -= sent;
+		}
+		return true;
+	}
+
+	bool RecvAll(SocketHandle socket, void* data, size_t bytes)
+	{
+		char* cursor = static_cast<char*>(data);
+		while (bytes > 0)
+		{
+			const int chunk = static_cast<int>(std::min<size_t>(bytes, 1 << 20));
+#if WIN32
+			const int received = recv(static_cast<SOCKET>(socket), cursor, chunk, 0);
+#else
+			const int received = static_cast<int>(recv(static_cast<int>(socket), cursor, chunk, 0));
+#endif
+			// 0 is an orderly close, negative is an error or the receive timeout
+			if (received <= 0)
+			{
+				return false;
+			}
+			cursor += received;
+			bytes -= received;
+		}
+		return true;
+	}
+
+	// runs the executable directly with args, no shell in between. argv[0] may be a bare name, so the path is searched
+	ProcessHandle StartProcess(const std::vector<std::string>& args)
+	{
+#if WIN32
+		std::string commandLine;
+		for (const auto& arg : args)
+		{
+			commandLine += (commandLine.empty() ? "\"" : " \"") + arg + "\"";
+		}
+		STARTUPINFOA startupInfo{};
+		startupInfo.cb = sizeof(startupInfo);
+		PROCESS_INFORMATION processInfo{};
+		if (!CreateProcessA(nullptr, commandLine.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startupInfo, &processInfo))
+		{
+			return InvalidProcess;
+		}
+		CloseHandle(processInfo.hThread);
+		return reinterpret_cast<ProcessHandle>(processInfo.hProcess);
+#else
+		// built before the fork, the child only calls exec
+		std::vector<char*> argv;
+		for (const auto& arg : args)
+		{
+			argv.push_back(const_cast<char*>(arg.c_str()));
+		}
+		argv.push_back(nullptr);
+
+		const pid_t pid = fork();
+		if (pid == 0)
+		{
+			execvp(argv[0], argv.data());
+			_exit(127);
+		}
+		return pid > 0 ? static_cast<ProcessHandle>(pid) : InvalidProcess;
+#endif
+	}
+
+	void KillProcess(ProcessHandle process)
+	{
+#if WIN32
+		TerminateProcess(reinterpret_cast<HANDLE>(process), 1);
+#else
+		kill(static_cast<pid_t>(process), SIGKILL);
+#endif
+	}
+
+	// false while the process still runs and block is not set, the handle is released once it returns true
+	bool ReapProcess(ProcessHandle process, bool block, int& exitCode)
+	{
+#if WIN32
+		const HANDLE handle = reinterpret_cast<HANDLE>(process);
+		if (WaitForSingleObject(handle, block ? INFINITE : 0) != WAIT_OBJECT_0)
+		{
+			return false;
+		}
+		DWORD code = 0;
+		GetExitCodeProcess(handle, &code);
+		CloseHandle(handle);
+		exitCode = static_cast<int>(code);
+		return true;
+#else
+		int status = 0;
+		const pid_t result = waitpid(static_cast<pid_t>(process), &status, block ? 0 : WNOHANG);
+		if (result == 0)
+		{
+			return false;
+		}
+		exitCode = result < 0 ? -1 : WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+		return true;
+#endif
+	}
+
+	bool SendHeader(SocketHandle socket, EMessage type, size_t payloadBytes)
+	{
+		const MessageHeader header{ProtocolMagic, type, static_cast<uint32_t>(payloadBytes)};
+		return SendAll(socket, &header, sizeof(header));
+	}
+
+	bool RecvHeader(SocketHandle socket, EMessage& type, uint32_t& payloadBytes)
+	{
+		MessageHeader header{};
+		if (!RecvAll(socket, &header, sizeof(header)) || header.Magic != ProtocolMagic)
+		{
+			return false;
+		}
+		type = header.Type;
+		payloadBytes = header.PayloadBytes;
+		return true;
+	}
+}
+
+DistributedCoordinator::DistributedCoordinator(const Options& options) : options_(options), listenSocket_(InvalidSocket)
+{
+	InitSockets();
+}
+
+DistributedCoordinator::~DistributedCoordinator()
+{
+	// a throw out of Run still leaves no worker behind
+	StopWorkers();
+	CloseSocket(listenSocket_);
+}
+
+void DistributedCoordinator::Run()
+{
+	// split the frame's passes into jobs, popped from the back so low indices are handed out first
+	const uint32_t totalPasses = options_.DistributedPasses;
+	const uint32_t jobPasses = options_.DistributedJobPasses;
+	for (uint32_t firstPass = 0; firstPass < totalPasses; firstPass += jobPasses)
+	{
+		pendingJobs_.push_back({jobCount_++, firstPass, std::min(jobPasses, totalPasses - firstPass)});
+	}
+	std::reverse(pendingJobs_.begin(), pendingJobs_.end());
+
+	listenSocket_ = OpenSocket();
+	const sockaddr_in address = LoopbackAddress(options_.DistributedPort);
+	if (listenSocket_ == InvalidSocket ||
+		bind(listenSocket_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+		listen(listenSocket_, static_cast<int>(options_.DistributedWorkers)) != 0)
+	{
+		Throw(std::runtime_error(fmt::format("distributed: failed to listen on 127.0.0.1:{}", options_.DistributedPort)));
+	}
+
+	fmt::print("{} distributed: {} passes in {} jobs over {} workers{}\n", CONSOLE_GREEN_COLOR, totalPasses, jobCount_, options_.DistributedWorkers, CONSOLE_DEFAULT_COLOR);
+
+	for (uint32_t i = 0; i < options_.DistributedWorkers; ++i)
+	{
+		SpawnWorker(i);
+	}
+
+	// workers connect once their scene is ready, so the connect window shares the result timeout
+	const auto acceptDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(options_.DistributedTimeout);
+	uint32_t acceptedWorkers = 0;
+	bool failed = false;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			if (finished_)
+			{
+				break;
+			}
+
+			const bool accepting = acceptedWorkers < options_.DistributedWorkers && std::chrono::steady_clock::now() < acceptDeadline;
+			if (!accepting)
+			{
+				if (liveWorkers_ == 0)
+				{
+					failed = true;
+					finished_ = true;
+					signal_.notify_all();
+					break;
+				}
+				signal_.wait_for(lock, std::chrono::milliseconds(200));
+				continue;
+			}
+		}
+
+		fd_set readSet;
+		FD_ZERO(&readSet);
+#if WIN32
+		FD_SET(static_cast<SOCKET>(listenSocket_), &readSet);
+#else
+		FD_SET(static_cast<int>(listenSocket_), &readSet);
+#endif
+		timeval wait{0, 200 * 1000};
+		if (select(static_cast<int>(listenSocket_) + 1, &readSet, nullptr, nullptr, &wait) <= 0)
+		{
+			continue;
+		}
+
+		const auto accepted = accept(listenSocket_, nullptr, nullptr);
+		const SocketHandle socket = static_cast<SocketHandle>(accepted);
+		if (socket == InvalidSocket)
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex_);
+		++acceptedWorkers;
+		++liveWorkers_;
+		serviceThreads_.emplace_back(&DistributedCoordinator::ServeWorker, this, socket);
+	}
+
+	for (auto& thread : serviceThreads_)
+	{
+		thread.join();
+	}
+	serviceThreads_.clear();
+	StopWorkers();
+
+	if (failed)
+	{
+		Throw(std::runtime_error(fmt::format("distributed: all workers lost with {} of {} jobs merged", nextMergeJob_, jobCount_)));
+	}
+
+	WriteOutput();
+}
+
+void DistributedCoordinator::SpawnWorker(uint32_t workerId)
+{
+	const uint32_t gpuIdx = options_.DistributedGpus > 1 ? workerId % options_.DistributedGpus : options_.GpuIdx;
+
+	std::vector<std::string> args{
+		options_.ExecutablePath,
+		fmt::format("--worker-port={}", options_.DistributedPort),
+		fmt::format("--worker-id={}", workerId),
+		fmt::format("--gpu={}", gpuIdx),
+		fmt::format("--renderer={}", options_.RendererType),
+		fmt::format("--samples={}", options_.Samples),
+		fmt::format("--bounces={}", options_.Bounces),
+		fmt::format("--max-bounces={}", options_.MaxBounces),
+		fmt::format("--width={}", options_.Width),
+		fmt::format("--height={}", options_.Height),
+		"--present-mode=0",
+		"--nodenoiser"};
+
+	if (options_.SceneName != "")
+	{
+		args.push_back(fmt::format("--load-scene={}", options_.SceneName));
+	}
+	else
+	{
+		args.push_back(fmt::format("--scene={}", options_.SceneIndex));
+	}
+
+	if (options_.HDRIfile != "")
+	{
+		args.push_back(fmt::format("--hdri={}", options_.HDRIfile));
+	}
+
+	// a worker that fails to start never connects, the accept deadline covers it like any other missing worker
+	const ProcessHandle process = StartProcess(args);
+	if (process == InvalidProcess)
+	{
+		fmt::print("{} distributed: failed to start worker #{}{}\n", CONSOLE_GOLD_COLOR, workerId, CONSOLE_DEFAULT_COLOR);
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	workerProcesses_[workerId] = process;
+}
+
+void DistributedCoordinator::KillWorker(uint32_t workerId)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	const auto it = workerProcesses_.find(workerId);
+	if (it != workerProcesses_.end())
+	{
+		KillProcess(it->second);
+	}
+}
+
+void DistributedCoordinator::StopWorkers()
+{
+	std::map<uint32_t, ProcessHandle> processes;
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		processes.swap(workerProcesses_);
+	}
+
+	const auto deadline = std::chrono::steady_clock::now() + WorkerExitGrace;
+	while (!processes.empty())
+	{
+		const bool expired = std::chrono::steady_clock::now() >= deadline;
+		for (auto it = processes.begin(); it != processes.end();)
+		{
+			if (expired)
+			{
+				KillProcess(it->second);
+			}
+
+			int code = 0;
+			if (!ReapProcess(it->second, expired, code))
+			{
+				++it;
+				continue;
+			}
+			if (code != 0)
+			{
+				fmt::print("{} distributed: worker #{} exited with code {}{}\n", CONSOLE_GOLD_COLOR, it->first, code, CONSOLE_DEFAULT_COLOR);
+			}
+			it = processes.erase(it);
+		}
+		if (!processes.empty())
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		}
+	}
+}
+
+void DistributedCoordinator::ServeWorker(SocketHandle socket)
+{
+	uint32_t workerId = ~0u;
+	Distributed::Job job{};
+	bool jobInFlight = false;
+
+	// a dropped worker gets no more jobs, one that hangs on its job would otherwise keep its gpu busy until shutdown
+	const auto drop = [&](const char* reason)
+	{
+		fmt::print("{} distributed: dropping worker #{}, {}{}\n", CONSOLE_GOLD_COLOR, workerId, reason, CONSOLE_DEFAULT_COLOR);
+		CloseSocket(socket);
+		KillWorker(workerId);
+		if (jobInFlight)
+		{
+			RequeueJob(job);
+		}
+		std::unique_lock<std::mutex> lock(mutex_);
+		--liveWorkers_;
+		signal_.notify_all();
+	};
+
+	SetReceiveTimeout(socket, options_.DistributedTimeout);
+
+	EMessage type{};
+	uint32_t payloadBytes = 0;
+	if (!RecvHeader(socket, type, payloadBytes) || type != EMessage::Hello || payloadBytes != sizeof(workerId) ||
+		!RecvAll(socket, &workerId, sizeof(workerId)))
+	{
+		drop("bad hello");
+		return;
+	}
+
+	fmt::print("{} distributed: worker #{} ready{}\n", CONSOLE_GREEN_COLOR, workerId, CONSOLE_DEFAULT_COLOR);
+
+	while (PopJob(job))
+	{
+		jobInFlight = true;
+		if (!SendHeader(socket, EMessage::Job, sizeof(job)) || !SendAll(socket, &job, sizeof(job)))
+		{
+			drop("send failed");
+			return;
+		}
+
+		ResultHeader result{};
+		if (!RecvHeader(socket, type, payloadBytes) || type != EMessage::Result || payloadBytes < sizeof(result) ||
+			!RecvAll(socket, &result, sizeof(result)))
+		{
+			drop("no result before timeout");
+			return;
+		}
+
+		const size_t floatCount = static_cast<size_t>(result.Width) * result.Height * 3;
+		if (result.JobIndex != job.Index || result.PassCount != job.PassCount || payloadBytes != sizeof(result) + floatCount * sizeof(float))
+		{
+			drop("mismatched result");
+			return;
+		}
+
+		std::vector<float> rgb(floatCount);
+		if (!RecvAll(socket, rgb.data(), floatCount * sizeof(float)))
+		{
+			drop("truncated result");
+			return;
+		}
+
+		if (!MergeResult(job, result.Width, result.Height, std::move(rgb)))
+		{
+			drop("extent differs from the other workers");
+			return;
+		}
+		jobInFlight = false;
+	}
+
+	SendHeader(socket, EMessage::Shutdown, 0);
+	CloseSocket(socket);
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	--liveWorkers_;
+	signal_.notify_all();
+}
+
+bool DistributedCoordinator::PopJob(Distributed::Job& job)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	signal_.wait(lock, [this]() { return finished_ || !pendingJobs_.empty(); });
+	if (finished_)
+	{
+		return false;
+	}
+	job = pendingJobs_.back();
+	pendingJobs_.pop_back();
+	return true;
+}
+
+void DistributedCoordinator::RequeueJob(const Distributed::Job& job)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	pendingJobs_.push_back(job);
+	signal_.notify_all();
+}
+
+bool DistributedCoordinator::MergeResult(const Distributed::Job& job, uint32_t width, uint32_t height, std::vector<float>&& rgb)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	if (width_ == 0)
+	{
+		width_ = width;
+		height_ = height;
+		accumulated_.assign(static_cast<size_t>(width) * height * 3, 0.0);
+	}
+	else if (width_ != width || height_ != height)
+	{
+		return false;
+	}
+
+	// fold strictly in job order, a result that arrives early waits here until its predecessors are in
+	parkedResults_.emplace(job.Index, std::make_pair(job, std::move(rgb)));
+	for (auto it = parkedResults_.find(nextMergeJob_); it != parkedResults_.end(); it = parkedResults_.find(nextMergeJob_))
+	{
+		const double weight = it->second.first.PassCount;
+		const std::vector<float>& partial = it->second.second;
+		for (size_t i = 0; i < accumulated_.size(); ++i)
+		{
+			accumulated_[i] += partial[i] * weight;
+		}
+		mergedPasses_ += it->second.first.PassCount;
+		parkedResults_.erase(it);
+		++nextMergeJob_;
+	}
+
+	fmt::print("{} distributed: job {} done, {}/{} passes merged{}\n", CONSOLE_GREEN_COLOR, job.Index, mergedPasses_, options_.DistributedPasses, CONSOLE_DEFAULT_COLOR);
+
+	if (nextMergeJob_ == jobCount_)
+	{
+		finished_ = true;
+	}
+	signal_.notify_all();
+	return true;
+}
+
+void DistributedCoordinator::WriteOutput() const
+{
+	std::vector<float> pixels(accumulated_.size());
+	for (size_t i = 0; i < pixels.size(); ++i)
+	{
+		pixels[i] = static_cast<float>(accumulated_[i] / mergedPasses_);
+	}
+
+	const std::string sceneTag = options_.SceneName != "" ? std::filesystem::path(options_.SceneName).stem().string() : fmt::format("scene{}", options_.SceneIndex);
+	const std::string filename = fmt::format("distributed_{}_{}spp.hdr", sceneTag, mergedPasses_ * options_.Samples);
+	if (stbi_write_hdr(filename.c_str(), static_cast<int>(width_), static_cast<int>(height_), 3, pixels.data()) == 0)
+	{
+		Throw(std::runtime_error(fmt::format("distributed: failed to write {}", filename)));
+	}
+
+	fmt::print("{} distributed: wrote {} ({}x{}){}\n", CONSOLE_GREEN_COLOR, filename, width_, height_, CONSOLE_DEFAULT_COLOR);
+}
+
+DistributedWorker::DistributedWorker(uint32_t port, uint32_t workerId) : port_(port), workerId_(workerId), socket_(InvalidSocket)
+{
+	InitSockets();
+}
+
+DistributedWorker::~DistributedWorker()
+{
+	CloseSocket(socket_);
+}
+
+bool DistributedWorker::Connect()
+{
+	const sockaddr_in address = LoopbackAddress(port_);
+	for (int attempt = 0; attempt < 20; ++attempt)
+	{
+		socket_ = OpenSocket();
+		if (socket_ != InvalidSocket && connect(socket_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0)
+		{
+			SetReceiveTimeout(socket_, 0);
+			return SendHeader(socket_, EMessage::Hello, sizeof(workerId_)) && SendAll(socket_, &workerId_, sizeof(workerId_));
+		}
+		CloseSocket(socket_);
+		socket_ = InvalidSocket;
+		std::this_thread::sleep_for(std::chrono::milliseconds(250));
+	}
+	return false;
+}
+
+bool DistributedWorker::ReceiveJob()
+{
+	EMessage type{};
+	uint32_t payloadBytes = 0;
+	if (!RecvHeader(socket_, type, payloadBytes) || type != EMessage::Job || payloadBytes != sizeof(job_) ||
+		!RecvAll(socket_, &job_, sizeof(job_)))
+	{
+		// shutdown or the coordinator went away, either way this worker is done
+		return false;
+	}
+
+	jobActive_ = true;
+	jobFrame_ = 0;
+	return true;
+}
+
+bool DistributedWorker::Tick(Vulkan::VulkanBaseRenderer& renderer, bool sceneReady)
+{
+	if (!sceneReady)
+	{
+		return true;
+	}
+
+	if (socket_ == InvalidSocket)
+	{
+		if (!Connect())
+		{
+			fmt::print("{} distributed: worker #{} failed to reach the coordinator on port {}{}\n", CONSOLE_GOLD_COLOR, workerId_, port_, CONSOLE_DEFAULT_COLOR);
+			return false;
+		}
+		return ReceiveJob();
+	}
+
+	if (jobActive_ && jobFrame_ < job_.PassCount)
+	{
+		return true;
+	}
+
+	// every pass of the job is submitted, wait for them and ship the running mean
+	renderer.Device().WaitIdle();
+
+	std::vector<float> rgba;
+	VkExtent2D extent{};
+	if (!renderer.CaptureLinearOutput(rgba, extent))
+	{
+		fmt::print("{} distributed: worker #{} renderer has no linear output{}\n", CONSOLE_GOLD_COLOR, workerId_, CONSOLE_DEFAULT_COLOR);
+		return false;
+	}
+
+	const size_t pixelCount = static_cast<size_t>(extent.width) * extent.height;
+	std::vector<float> rgb(pixelCount * 3);
+	for (size_t i = 0; i < pixelCount; ++i)
+	{
+		rgb[i * 3 + 0] = rgba[i * 4 + 0];
+		rgb[i * 3 + 1] = rgba[i * 4 + 1];
+		rgb[i * 3 + 2] = rgba[i * 4 + 2];
+	}
+
+	const ResultHeader result{job_.Index, extent.width, extent.height, job_.PassCount};
+	jobActive_ = false;
+	if (!SendHeader(socket_, EMessage::Result, sizeof(result) + rgb.size() * sizeof(float)) ||
+		!SendAll(socket_, &result, sizeof(result)) ||
+		!SendAll(socket_, rgb.data(), rgb.size() * sizeof(float)))
+	{
+		return false;
+	}
+
+	return ReceiveJob();
+}
+
+void DistributedWorker::OverrideUniformBufferObject(Assets::UniformBufferObject& ubo)
+{
+	if (!jobActive_ || jobFrame_ >= job_.PassCount)
+	{
+		return;
+	}
+
+	// frame 0 drops the history, then weight 1/(n+1) keeps an exact mean; the samplers and the seed walk the global
+	// pass index so every job traces samples of its own
+	ubo.TotalFrames = jobFrame_;
+	ubo.TemporalFrames = jobFrame_ + 1;
+	ubo.SampleOffset = job_.FirstPass;
+	ubo.RandomSeed = job_.FirstPass + jobFrame_;
+	++jobFrame_;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Options;
+
+namespace Vulkan
+{
+	class VulkanBaseRenderer;
+}
+
+namespace Assets
+{
+	struct UniformBufferObject;
+}
+
+namespace Distributed
+{
+	typedef intptr_t SocketHandle;
+	// a pid, or a process HANDLE on windows
+	typedef intptr_t ProcessHandle;
+
+	// a contiguous range of progressive passes over the full frame, the unit of work handed to one worker
+	struct Job
+	{
+		uint32_t Index;
+		uint32_t FirstPass;
+		uint32_t PassCount;
+	};
+}
+
+// Spawns local worker processes, feeds them pass ranges over a loopback socket and merges
+// their linear accumulations in job order, so the result does not depend on which worker finished first.
+// Runs before any vulkan device is created, the coordinator itself renders nothing.
+class DistributedCoordinator final
+{
+public:
+	explicit DistributedCoordinator(const Options& options);
+	~DistributedCoordinator();
+
+	void Run();
+
+private:
+	void SpawnWorker(uint32_t workerId);
+	void KillWorker(uint32_t workerId);
+	// waits for the workers that were told to shut down, kills the rest and reaps them all
+	void StopWorkers();
+	void ServeWorker(Distributed::SocketHandle socket);
+
+	bool PopJob(Distributed::Job& job);
+	void RequeueJob(const Distributed::Job& job);
+	bool MergeResult(const Distributed::Job& job, uint32_t width, uint32_t height, std::vector<float>&& rgb);
+	void WriteOutput() const;
+
+	const Options& options_;
+	Distributed::SocketHandle listenSocket_;
+
+	std::mutex mutex_;
+	std::condition_variable signal_;
+	std::vector<Distributed::Job> pendingJobs_;
+	std::map<uint32_t, std::pair<Distributed::Job, std::vector<float>>> parkedResults_;
+	std::vector<double> accumulated_;
+	uint32_t width_{};
+	uint32_t height_{};
+	uint32_t jobCount_{};
+	uint32_t nextMergeJob_{};
+	uint32_t mergedPasses_{};
+	uint32_t liveWorkers_{};
+	bool finished_{};
+
+	std::vector<std::thread> serviceThreads_;
+	// by worker id, removed once reaped
+	std::map<uint32_t, Distributed::ProcessHandle> workerProcesses_;
+};
+
+// Worker side of the protocol, lives inside a normal application instance started with --worker-port.
+// While a job is active it pins the frame index and seed of every frame so the accumulation
+// becomes an exact running mean of the job's passes.
+class DistributedWorker final
+{
+public:
+	DistributedWorker(uint32_t port, uint32_t workerId);
+	~DistributedWorker();
+
+	// call after each DrawFrame, returns false once the coordinator has nothing more to do
+	bool Tick(Vulkan::VulkanBaseRenderer& renderer, bool sceneReady);
+	void OverrideUniformBufferObject(Assets::UniformBufferObject& ubo);
+
+private:
+	bool Connect();
+	bool ReceiveJob();
+
+	const uint32_t port_;
+	const uint32_t workerId_;
+	Distributed::SocketHandle socket_;
+
+	Distributed::Job job_{};
+	bool jobActive_{};
+	uint32_t jobFrame_{};
+};
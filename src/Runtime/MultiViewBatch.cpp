@@ -0,0 +1,150 @@
+#include "MultiViewBatch.hpp"
+#include "TaskCoordinator.hpp"
+#include "Assets/UniformBuffer.hpp"
+#include "Utilities/Console.hpp"
+#include "Utilities/ExrWriter.hpp"
+#include "Vulkan/ReadbackRing.hpp"
+#include "Vulkan/VulkanBaseRenderer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fmt/format.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// shares the capture thread, views are written in request order
+	constexpr uint8_t MultiViewTaskPriority = 2;
+}
+
+struct MultiViewBatch::State
+{
+	// from the request until the slot is released or the copy is dropped
+	std::atomic<uint32_t> outstanding{};
+	// from the retired copy until the file is written
+	std::atomic<uint32_t> encoding{};
+};
+
+MultiViewBatch::MultiViewBatch(uint32_t passesPerView, uint32_t maxViews, std::string outputPrefix) :
+	passesPerView_(passesPerView), maxViews_(maxViews), outputPrefix_(std::move(outputPrefix)), state_(std::make_shared<State>())
+{
+}
+
+bool MultiViewBatch::Finished() const
+{
+	return finished_ && state_->outstanding.load() == 0;
+}
+
+bool MultiViewBatch::Tick(Vulkan::VulkanBaseRenderer& renderer, uint32_t cameraCount)
+{
+	if (finished_)
+	{
+		return false;
+	}
+
+	bool newView = false;
+	if (currentView_ < 0)
+	{
+		// textures still streaming in would end up in the first views, later the encodes keep the queue busy
+		if (!TaskCoordinator::GetInstance()->IsIdle())
+		{
+			return false;
+		}
+		if (renderer.GetLinearOutputImage() == nullptr)
+		{
+			fmt::print("{} multi-view: renderer has no linear output{}\n", CONSOLE_GOLD_COLOR, CONSOLE_DEFAULT_COLOR);
+			finished_ = true;
+			return false;
+		}
+
+		// a scene without cameras still renders its initial view once
+		viewCount_ = std::max(1u, maxViews_ > 0 ? std::min(maxViews_, cameraCount) : cameraCount);
+		fmt::print("{} multi-view: {} views, {} passes each{}\n", CONSOLE_GREEN_COLOR, viewCount_, passesPerView_, CONSOLE_DEFAULT_COLOR);
+		currentView_ = 0;
+		viewFrame_ = 0;
+		newView = cameraCount > 0;
+	}
+	else if (viewFrame_ >= passesPerView_)
+	{
+		// the last pass was copied out at the end of its own frame, the next view can start right away
+		if (static_cast<uint32_t>(++currentView_) >= viewCount_)
+		{
+			finished_ = true;
+			return false;
+		}
+		viewFrame_ = 0;
+		newView = true;
+	}
+
+	// a readback lands at the end of the next frame, so it is asked for when that frame is the view's last pass
+	if (viewFrame_ + 1 == passesPerView_)
+	{
+		RequestView(renderer);
+	}
+	return newView;
+}
+
+void MultiViewBatch::OverrideUniformBufferObject(Assets::UniformBufferObject& ubo)
+{
+	if (currentView_ < 0 || finished_ || viewFrame_ >= passesPerView_)
+	{
+		return;
+	}
+
+	// restart the accumulation on each view's first frame and keep an exact mean after that
+	ubo.TotalFrames = viewFrame_;
+	ubo.TemporalFrames = viewFrame_ + 1;
+	ubo.PrevViewProjection = ubo.ViewProjection;
+	++viewFrame_;
+}
+
+void MultiViewBatch::RequestView(Vulkan::VulkanBaseRenderer& renderer)
+{
+	// back-pressure: with the ring full the copy would slip into a frame of the next view, so wait for an encode to
+	// hand its slot back. Copies not retired yet are left alone, they need the next DrawFrame to get to the encoder
+	while (state_->outstanding.load() >= Depth && state_->encoding.load() > 0)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	renderer.ReserveReadbackSlots(Depth);
+
+	const int view = currentView_;
+	const std::string filename = fmt::format("{}_view{:02}.exr", outputPrefix_, view);
+	Vulkan::VulkanBaseRenderer* rendererPtr = &renderer;
+	std::shared_ptr<State> state = state_;
+	state->outstanding.fetch_add(1);
+
+	renderer.RequestReadback(Vulkan::EReadbackSource::LinearOutput, [rendererPtr, state, filename](const Vulkan::ReadbackRing::Slot& slot)
+	{
+		state->encoding.fetch_add(1);
+		TaskCoordinator::GetInstance()->AddTask([rendererPtr, state, filename, slot](ResTask&)
+		{
+			using namespace Utilities::Exr;
+			const Vulkan::ReadbackRing::Region& region = slot.Regions[0];
+			const uint16_t* halfs = reinterpret_cast<const uint16_t*>(slot.Data[0]);
+			std::vector<Channel> channels{{"R", halfs + 0, EPixelType::Half, 4}, {"G", halfs + 1, EPixelType::Half, 4}, {"B", halfs + 2, EPixelType::Half, 4}, {"A", halfs + 3, EPixelType::Half, 4}};
+
+			const bool succeeded = Write(filename, region.Extent.width, region.Extent.height, channels, WriteOptions{});
+			rendererPtr->GetReadbackRing().Release(slot.Index);
+			if (succeeded)
+			{
+				fmt::print("{} multi-view: wrote {}{}\n", CONSOLE_GREEN_COLOR, filename, CONSOLE_DEFAULT_COLOR);
+			}
+			else
+			{
+				fmt::print("{} multi-view: failed to write {}{}\n", CONSOLE_GOLD_COLOR, filename, CONSOLE_DEFAULT_COLOR);
+			}
+			state->encoding.fetch_sub(1);
+			state->outstanding.fetch_sub(1);
+		},
+		nullptr,
+		MultiViewTaskPriority);
+	},
+	[state, view]()
+	{
+		fmt::print("{} multi-view: renderer has no linear output, view {} skipped{}\n", CONSOLE_GOLD_COLOR, view, CONSOLE_DEFAULT_COLOR);
+		state->outstanding.fetch_sub(1);
+	});
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace Vulkan
+{
+	class VulkanBaseRenderer;
+}
+
+namespace Assets
+{
+	struct UniformBufferObject;
+}
+
+// Renders the scene's cameras one after another with a fixed pass count each, reusing the loaded scene,
+// acceleration structures and swapchain targets, and writes every view's linear accumulation to its own exr. The last
+// pass of a view is read back through the readback ring and encoded on the task threads while the next view renders.
+class MultiViewBatch final
+{
+public:
+	MultiViewBatch(uint32_t passesPerView, uint32_t maxViews, std::string outputPrefix);
+
+	// call after each DrawFrame once the scene is ready, returns true when a new view starts and its camera must be applied
+	bool Tick(Vulkan::VulkanBaseRenderer& renderer, uint32_t cameraCount);
+	void OverrideUniformBufferObject(Assets::UniformBufferObject& ubo);
+
+	int CurrentView() const { return currentView_; }
+	bool Finished() const;
+
+private:
+	struct State;
+
+	// views whose readback or encode is still in flight, more hold the batch until one is written
+	static constexpr uint32_t Depth = 3;
+
+	void RequestView(Vulkan::VulkanBaseRenderer& renderer);
+
+	const uint32_t passesPerView_;
+	const uint32_t maxViews_;
+	const std::string outputPrefix_;
+
+	uint32_t viewCount_{};
+	int currentView_{-1};
+	uint32_t viewFrame_{};
+	bool finished_{};
+	std::shared_ptr<State> state_;
+};
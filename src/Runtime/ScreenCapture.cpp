@@ -0,0 +1,531 @@
+#include "ScreenCapture.hpp"
+#include "TaskCoordinator.hpp"
+#include "Utilities/Console.hpp"
+#include "Utilities/ExrWriter.hpp"
+#include "Vulkan/VulkanBaseRenderer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <fmt/format.h>
+
+#include "stb_image_write.h"
+
+#if WITH_AVIF
+#include "avif/avif.h"
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCREEN_CAPTURE_SSE2 1
+#include <emmintrin.h>
+#else
+#define SCREEN_CAPTURE_SSE2 0
+#endif
+
+namespace
+{
+	// the encode tasks share one task thread, so captures finish in request order
+	constexpr uint8_t CaptureTaskPriority = 2;
+
+	struct CaptureTaskContext
+	{
+		bool succeeded;
+		float elapsed;
+		std::array<char, 256> filename;
+	};
+
+	void FillContext(ResTask& task, const std::string& filename, bool succeeded, std::chrono::high_resolution_clock::time_point timer)
+	{
+		CaptureTaskContext context{};
+		context.succeeded = succeeded;
+		context.elapsed = std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - timer).count();
+		std::copy_n(filename.begin(), std::min(filename.size(), context.filename.size() - 1), context.filename.data());
+		task.SetContext(context);
+	}
+
+	void PrintContext(ResTask& task)
+	{
+		CaptureTaskContext context{};
+		task.GetContext(context);
+		if (context.succeeded)
+		{
+			fmt::print("{} wrote {} in {:.2f}ms{}\n", CONSOLE_GREEN_COLOR, context.filename.data(), context.elapsed * 1000.f, CONSOLE_DEFAULT_COLOR);
+		}
+		else
+		{
+			fmt::print("{} failed to write {}{}\n", CONSOLE_GOLD_COLOR, context.filename.data(), CONSOLE_DEFAULT_COLOR);
+		}
+	}
+
+	bool IsPacked10Bit(VkFormat format)
+	{
+		return format == VK_FORMAT_A2B10G10R10_UNORM_PACK32 || format == VK_FORMAT_A2R10G10B10_UNORM_PACK32;
+	}
+
+	bool IsBlueFirst(VkFormat format)
+	{
+		return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_A2R10G10B10_UNORM_PACK32;
+	}
+
+	// 8 bit swapchain texels to rgba8, alpha forced opaque
+	void ConvertRgba8(const uint8_t* src, uint8_t* dst, size_t pixels, bool swapRedBlue)
+	{
+		size_t i = 0;
+#if SCREEN_CAPTURE_SSE2
+		const __m128i lowByte = _mm_set1_epi32(0x000000FF);
+		const __m128i keepMask = _mm_set1_epi32(swapRedBlue ? 0x0000FF00 : 0x00FFFFFF);
+		const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+		for (; i + 4 <= pixels; i += 4)
+		{
+			const __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+			__m128i rgba = _mm_or_si128(_mm_and_si128(texels, keepMask), alpha);
+			if (swapRedBlue)
+			{
+				rgba = _mm_or_si128(rgba, _mm_and_si128(_mm_srli_epi32(texels, 16), lowByte));
+				rgba = _mm_or_si128(rgba, _mm_slli_epi32(_mm_and_si128(texels, lowByte), 16));
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), rgba);
+		}
+#endif
+		for (; i < pixels; ++i)
+		{
+			dst[i * 4 + 0] = src[i * 4 + (swapRedBlue ? 2 : 0)];
+			dst[i * 4 + 1] = src[i * 4 + 1];
+			dst[i * 4 + 2] = src[i * 4 + (swapRedBlue ? 0 : 2)];
+			dst[i * 4 + 3] = 0xFF;
+		}
+	}
+
+	// packed 10 bit swapchain texels to rgba16 holding 10 bit values, alpha forced opaque
+	void ConvertRgba10(const uint8_t* src, uint16_t* dst, size_t pixels, bool swapRedBlue)
+	{
+		const int redShift = swapRedBlue ? 20 : 0;
+		const int blueShift = swapRedBlue ? 0 : 20;
+
+		size_t i = 0;
+#if SCREEN_CAPTURE_SSE2
+		const __m128i mask = _mm_set1_epi32(0x3FF);
+		const __m128i alpha = _mm_set1_epi32(0x3FF << 16);
+		for (; i + 4 <= pixels; i += 4)
+		{
+			const __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+			const __m128i r = _mm_and_si128(_mm_srl_epi32(texels, _mm_cvtsi32_si128(redShift)), mask);
+			const __m128i g = _mm_and_si128(_mm_srli_epi32(texels, 10), mask);
+			const __m128i b = _mm_and_si128(_mm_srl_epi32(texels, _mm_cvtsi32_si128(blueShift)), mask);
+
+			// one 32 bit lane per channel pair, interleaved back into two pixels per register
+			const __m128i rg = _mm_or_si128(r, _mm_slli_epi32(g, 16));
+			const __m128i ba = _mm_or_si128(b, alpha);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_unpacklo_epi32(rg, ba));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 8), _mm_unpackhi_epi32(rg, ba));
+		}
+#endif
+		for (; i < pixels; ++i)
+		{
+			uint32_t texel;
+			std::memcpy(&texel, src + i * 4, sizeof(texel));
+			dst[i * 4 + 0] = static_cast<uint16_t>((texel >> redShift) & 0x3FF);
+			dst[i * 4 + 1] = static_cast<uint16_t>((texel >> 10) & 0x3FF);
+			dst[i * 4 + 2] = static_cast<uint16_t>((texel >> blueShift) & 0x3FF);
+			dst[i * 4 + 3] = 0x3FF;
+		}
+	}
+
+	// rough pq to sdr squash for 8 bit outputs, good enough for a thumbnail
+	void ConvertHdrToSdr(const uint16_t* src, uint8_t* dst, size_t pixels)
+	{
+		constexpr float scale = 2.0f / 1300.f;
+
+		size_t i = 0;
+#if SCREEN_CAPTURE_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 vscale = _mm_set1_ps(scale);
+		const __m128 vmax = _mm_set1_ps(255.f);
+		const auto squash = [&](__m128i values)
+		{
+			__m128 scaled = _mm_mul_ps(_mm_cvtepi32_ps(values), vscale);
+			scaled = _mm_min_ps(_mm_mul_ps(_mm_mul_ps(scaled, scaled), vmax), vmax);
+			return _mm_cvttps_epi32(scaled);
+		};
+		for (; i + 4 <= pixels; i += 4)
+		{
+			const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+			const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4 + 8));
+			const __m128i lo16 = _mm_packs_epi32(squash(_mm_unpacklo_epi16(lo, zero)), squash(_mm_unpackhi_epi16(lo, zero)));
+			const __m128i hi16 = _mm_packs_epi32(squash(_mm_unpacklo_epi16(hi, zero)), squash(_mm_unpackhi_epi16(hi, zero)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(lo16, hi16));
+		}
+#endif
+		for (size_t c = i * 4; c < pixels * 4; ++c)
+		{
+			float scaled = src[c] * scale;
+			scaled = scaled * scaled * 255.f;
+			dst[c] = static_cast<uint8_t>(std::min(scaled, 255.f));
+		}
+	}
+
+	// full 4:4:4 planes with bt.709 limited range coefficients, in 8 bit fixed point
+	void AppendYuv444(const std::vector<uint8_t>& rgba, size_t pixelCount, std::vector<uint8_t>& planes)
+	{
+		const size_t base = planes.size();
+		planes.resize(base + pixelCount * 3);
+		uint8_t* y = planes.data() + base;
+		uint8_t* u = y + pixelCount;
+		uint8_t* v = u + pixelCount;
+		for (size_t i = 0; i < pixelCount; ++i)
+		{
+			const int r = rgba[i * 4 + 0];
+			const int g = rgba[i * 4 + 1];
+			const int b = rgba[i * 4 + 2];
+			y[i] = static_cast<uint8_t>(((47 * r + 157 * g + 16 * b + 128) >> 8) + 16);
+			u[i] = static_cast<uint8_t>(((-26 * r - 87 * g + 112 * b + 128) >> 8) + 128);
+			v[i] = static_cast<uint8_t>(((112 * r - 102 * g - 10 * b + 128) >> 8) + 128);
+		}
+	}
+
+	bool EncodeScreenShot(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, bool hdr, std::vector<uint8_t>& encoded)
+	{
+#if WITH_AVIF
+		avifImage* image = avifImageCreate(width, height, hdr ? 10 : 8, AVIF_PIXEL_FORMAT_YUV444);
+		if (!image)
+		{
+			return false;
+		}
+		image->yuvRange = AVIF_RANGE_FULL;
+		image->colorPrimaries = hdr ? AVIF_COLOR_PRIMARIES_BT2020 : AVIF_COLOR_PRIMARIES_BT709;
+		image->transferCharacteristics = hdr ? AVIF_TRANSFER_CHARACTERISTICS_SMPTE2084 : AVIF_TRANSFER_CHARACTERISTICS_BT709;
+		image->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_IDENTITY;
+		image->clli.maxCLL = static_cast<uint16_t>(600); //maxCLLNits;
+		image->clli.maxPALL = 0; //maxFALLNits;
+
+		avifRGBImage rgbAvifImage{};
+		avifRGBImageSetDefaults(&rgbAvifImage, image);
+		rgbAvifImage.format = AVIF_RGB_FORMAT_RGBA;
+		rgbAvifImage.ignoreAlpha = AVIF_TRUE;
+		rgbAvifImage.pixels = const_cast<uint8_t*>(pixels.data());
+		rgbAvifImage.rowBytes = width * 4 * (hdr ? sizeof(uint16_t) : sizeof(uint8_t));
+
+		avifResult result = avifImageRGBToYUV(image, &rgbAvifImage);
+		avifEncoder* encoder = result == AVIF_RESULT_OK ? avifEncoderCreate() : nullptr;
+		avifRWData avifOutput = AVIF_DATA_EMPTY;
+		if (encoder)
+		{
+			encoder->quality = 80;
+			encoder->qualityAlpha = AVIF_QUALITY_LOSSLESS;
+			encoder->speed = AVIF_SPEED_FASTEST;
+
+			result = avifEncoderAddImage(encoder, image, 1, AVIF_ADD_IMAGE_FLAG_SINGLE);
+			if (result == AVIF_RESULT_OK)
+			{
+				result = avifEncoderFinish(encoder, &avifOutput);
+			}
+			avifEncoderDestroy(encoder);
+		}
+		if (result != AVIF_RESULT_OK)
+		{
+			fmt::print("{} screenshot avif encoding failed: {}{}\n", CONSOLE_GOLD_COLOR, avifResultToString(result), CONSOLE_DEFAULT_COLOR);
+		}
+		else
+		{
+			encoded.assign(avifOutput.data, avifOutput.data + avifOutput.size);
+		}
+		avifRWDataFree(&avifOutput);
+		avifImageDestroy(image);
+		return result == AVIF_RESULT_OK;
+#else
+		std::vector<uint8_t> sdr;
+		if (hdr)
+		{
+			sdr.resize(static_cast<size_t>(width) * height * 4);
+			ConvertHdrToSdr(reinterpret_cast<const uint16_t*>(pixels.data()), sdr.data(), static_cast<size_t>(width) * height);
+		}
+		const auto write = [](void* context, void* data, int size)
+		{
+			auto* out = static_cast<std::vector<uint8_t>*>(context);
+			out->insert(out->end(), static_cast<uint8_t*>(data), static_cast<uint8_t*>(data) + size);
+		};
+		return stbi_write_jpg_to_func(write, &encoded, width, height, 4, hdr ? sdr.data() : pixels.data(), 91) != 0;
+#endif
+	}
+}
+
+namespace ScreenCapture
+{
+	bool ConvertSwapChainPixels(VkFormat format, const uint8_t* src, size_t pixelCount, std::vector<uint8_t>& pixels)
+	{
+		const bool hdr = IsPacked10Bit(format);
+		pixels.resize(pixelCount * 4 * (hdr ? sizeof(uint16_t) : sizeof(uint8_t)));
+		if (hdr)
+		{
+			ConvertRgba10(src, reinterpret_cast<uint16_t*>(pixels.data()), pixelCount, IsBlueFirst(format));
+		}
+		else
+		{
+			ConvertRgba8(src, pixels.data(), pixelCount, IsBlueFirst(format));
+		}
+		return hdr;
+	}
+
+	void ConvertSwapChainToSdr(VkFormat format, const uint8_t* src, size_t pixelCount, std::vector<uint8_t>& rgba)
+	{
+		rgba.resize(pixelCount * 4);
+		if (IsPacked10Bit(format))
+		{
+			std::vector<uint16_t> wide(pixelCount * 4);
+			ConvertRgba10(src, wide.data(), pixelCount, IsBlueFirst(format));
+			ConvertHdrToSdr(wide.data(), rgba.data(), pixelCount);
+		}
+		else
+		{
+			ConvertRgba8(src, rgba.data(), pixelCount, IsBlueFirst(format));
+		}
+	}
+
+	void RequestScreenShot(Vulkan::VulkanBaseRenderer& renderer, const std::string& basename, EncodedCallback onEncoded)
+	{
+		Vulkan::VulkanBaseRenderer* rendererPtr = &renderer;
+		renderer.RequestReadback(Vulkan::EReadbackSource::SwapChain, [rendererPtr, basename, onEncoded](const Vulkan::ReadbackRing::Slot& slot)
+		{
+			TaskCoordinator::GetInstance()->AddTask([rendererPtr, basename, onEncoded, slot](ResTask& task)
+			{
+				const auto timer = std::chrono::high_resolution_clock::now();
+				const Vulkan::ReadbackRing::Region& region = slot.Regions[0];
+				const size_t pixelCount = static_cast<size_t>(region.Extent.width) * region.Extent.height;
+
+				// convert straight out of the mapped slot, then hand it back before the slow part
+				std::vector<uint8_t> pixels;
+				const bool hdr = ConvertSwapChainPixels(region.Format, slot.Data[0], pixelCount, pixels);
+				rendererPtr->GetReadbackRing().Release(slot.Index);
+
+				std::vector<uint8_t> encoded;
+#if WITH_AVIF
+				const std::string filename = basename + ".avif";
+#else
+				const std::string filename = basename + ".jpg";
+#endif
+				bool succeeded = EncodeScreenShot(pixels, region.Extent.width, region.Extent.height, hdr, encoded);
+				if (succeeded)
+				{
+					std::ofstream file(filename, std::ios::out | std::ios::binary);
+					file.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+					succeeded = file.good();
+				}
+				FillContext(task, filename, succeeded, timer);
+
+				if (onEncoded)
+				{
+					onEncoded(encoded);
+				}
+			},
+			PrintContext,
+			CaptureTaskPriority);
+		});
+	}
+
+	void RequestExr(Vulkan::VulkanBaseRenderer& renderer, const std::string& filename, bool floatChannels, bool withAov)
+	{
+		Vulkan::VulkanBaseRenderer* rendererPtr = &renderer;
+		renderer.RequestReadback(withAov ? Vulkan::EReadbackSource::LinearOutputWithAov : Vulkan::EReadbackSource::LinearOutput,
+			[rendererPtr, filename, floatChannels](const Vulkan::ReadbackRing::Slot& slot)
+		{
+			TaskCoordinator::GetInstance()->AddTask([rendererPtr, filename, floatChannels, slot](ResTask& task)
+			{
+				using namespace Utilities::Exr;
+
+				const auto timer = std::chrono::high_resolution_clock::now();
+				const VkExtent2D extent = slot.Regions[0].Extent;
+
+				// every region is rgba16f, read in place from the mapped slot
+				std::vector<Channel> channels;
+				const char* layerNames[][4] = {{"R", "G", "B", "A"}, {"albedo.R", "albedo.G", "albedo.B", nullptr}, {"normal.X", "normal.Y", "normal.Z", nullptr}};
+				for (size_t region = 0; region < slot.Regions.size() && region < 3; ++region)
+				{
+					const uint16_t* halfs = reinterpret_cast<const uint16_t*>(slot.Data[region]);
+					for (uint32_t c = 0; c < 4 && layerNames[region][c] != nullptr; ++c)
+					{
+						channels.push_back({layerNames[region][c], halfs + c, EPixelType::Half, 4});
+					}
+				}
+
+				WriteOptions options{};
+				options.PixelType = floatChannels ? EPixelType::Float : EPixelType::Half;
+				options.Compression = ECompression::Zip;
+
+				const bool succeeded = Write(filename, extent.width, extent.height, channels, options);
+				rendererPtr->GetReadbackRing().Release(slot.Index);
+				FillContext(task, filename, succeeded, timer);
+			},
+			PrintContext,
+			CaptureTaskPriority);
+		});
+	}
+
+	bool ParseSequenceFormat(const std::string& name, ESequenceFormat& format)
+	{
+		static const std::pair<const char*, ESequenceFormat> formats[] = {{"png", ESequenceFormat::Png}, {"exr", ESequenceFormat::Exr}, {"y4m", ESequenceFormat::Y4m}};
+		for (const auto& entry : formats)
+		{
+			if (name == entry.first)
+			{
+				format = entry.second;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	struct Sequence::State
+	{
+		std::atomic<uint32_t> outstanding{};
+		std::atomic<uint32_t> failures{};
+
+		// y4m stream, only touched by the stream task thread
+		std::ofstream stream;
+		VkExtent2D streamExtent{};
+	};
+
+	Sequence::Sequence(uint32_t every, uint32_t maxFrames, ESequenceFormat format, const std::string& prefix) :
+		every_(std::max(every, 1u)),
+		maxFrames_(maxFrames),
+		format_(format),
+		prefix_(prefix),
+		state_(std::make_shared<State>())
+	{
+	}
+
+	Sequence::~Sequence()
+	{
+		if (!reported_)
+		{
+			fmt::print("{} sequence capture stopped after {} frames, {} deferred by busy encoders{}\n", CONSOLE_GOLD_COLOR, captured_, deferred_, CONSOLE_DEFAULT_COLOR);
+		}
+	}
+
+	bool Sequence::Finished() const
+	{
+		return disabled_ || (maxFrames_ != 0 && captured_ >= maxFrames_ && state_->outstanding.load() == 0);
+	}
+
+	void Sequence::Tick(Vulkan::VulkanBaseRenderer& renderer)
+	{
+		if (Finished())
+		{
+			if (!reported_)
+			{
+				fmt::print("{} sequence capture wrote {} frames, {} deferred by busy encoders, {} failed{}\n", CONSOLE_GREEN_COLOR, captured_, deferred_, state_->failures.load(), CONSOLE_DEFAULT_COLOR);
+				reported_ = true;
+			}
+			return;
+		}
+		if (maxFrames_ != 0 && captured_ >= maxFrames_)
+		{
+			return;
+		}
+
+		due_ |= frame_++ % every_ == 0;
+		if (!due_)
+		{
+			return;
+		}
+
+		// back-pressure: the capture stays due and is retried on the next frame
+		if (state_->outstanding.load() >= Depth)
+		{
+			deferred_++;
+			return;
+		}
+
+		if (format_ == ESequenceFormat::Exr && renderer.GetLinearOutputImage() == nullptr)
+		{
+			fmt::print("{} sequence capture disabled, the current renderer has no linear output for exr{}\n", CONSOLE_GOLD_COLOR, CONSOLE_DEFAULT_COLOR);
+			disabled_ = true;
+			reported_ = true;
+			return;
+		}
+
+		renderer.ReserveReadbackSlots(Depth);
+
+		const uint32_t index = captured_++;
+		due_ = false;
+		state_->outstanding++;
+
+		// the stream must stay in order and sits on one thread, numbered files alternate between two
+		const uint8_t priority = format_ == ESequenceFormat::Y4m ? 3 : static_cast<uint8_t>(2 + index % 2);
+		const std::string filename = fmt::format("{}_{:05d}.{}", prefix_, index, format_ == ESequenceFormat::Png ? "png" : "exr");
+
+		Vulkan::VulkanBaseRenderer* rendererPtr = &renderer;
+		const std::shared_ptr<State> state = state_;
+		const ESequenceFormat format = format_;
+		const std::string streamName = prefix_ + ".y4m";
+		const uint32_t fps = std::max(60u / every_, 1u);
+
+		renderer.RequestReadback(format == ESequenceFormat::Exr ? Vulkan::EReadbackSource::LinearOutput : Vulkan::EReadbackSource::SwapChain,
+			[rendererPtr, state, format, filename, streamName, fps, priority](const Vulkan::ReadbackRing::Slot& slot)
+		{
+			TaskCoordinator::GetInstance()->AddTask([rendererPtr, state, format, filename, streamName, fps, slot](ResTask&)
+			{
+				const Vulkan::ReadbackRing::Region& region = slot.Regions[0];
+				const size_t pixelCount = static_cast<size_t>(region.Extent.width) * region.Extent.height;
+				bool succeeded = false;
+
+				if (format == ESequenceFormat::Exr)
+				{
+					using namespace Utilities::Exr;
+					const uint16_t* halfs = reinterpret_cast<const uint16_t*>(slot.Data[0]);
+					std::vector<Channel> channels{{"R", halfs + 0, EPixelType::Half, 4}, {"G", halfs + 1, EPixelType::Half, 4}, {"B", halfs + 2, EPixelType::Half, 4}, {"A", halfs + 3, EPixelType::Half, 4}};
+
+					// one encoder thread per sequence task, the other task thread runs the next frame
+					WriteOptions options{};
+					options.Threads = 1;
+					succeeded = Write(filename, region.Extent.width, region.Extent.height, channels, options);
+					rendererPtr->GetReadbackRing().Release(slot.Index);
+				}
+				else
+				{
+					std::vector<uint8_t> rgba;
+					ConvertSwapChainToSdr(region.Format, slot.Data[0], pixelCount, rgba);
+					rendererPtr->GetReadbackRing().Release(slot.Index);
+
+					if (format == ESequenceFormat::Png)
+					{
+						succeeded = stbi_write_png(filename.c_str(), region.Extent.width, region.Extent.height, 4, rgba.data(), region.Extent.width * 4) != 0;
+					}
+					else
+					{
+						if (!state->stream.is_open())
+						{
+							state->stream.open(streamName, std::ios::out | std::ios::binary);
+							state->streamExtent = region.Extent;
+							state->stream << fmt::format("YUV4MPEG2 W{} H{} F{}:1 Ip A1:1 C444\n", region.Extent.width, region.Extent.height, fps);
+						}
+
+						// a resized swapchain cannot go into the same stream
+						if (region.Extent.width == state->streamExtent.width && region.Extent.height == state->streamExtent.height)
+						{
+							std::vector<uint8_t> frame{'F', 'R', 'A', 'M', 'E', '\n'};
+							AppendYuv444(rgba, pixelCount, frame);
+							state->stream.write(reinterpret_cast<const char*>(frame.data()), frame.size());
+							succeeded = state->stream.good();
+						}
+					}
+				}
+
+				if (!succeeded)
+				{
+					state->failures++;
+				}
+				state->outstanding--;
+			},
+			nullptr,
+			priority);
+		},
+		[state]()
+		{
+			// the renderer switched to one without a linear output after the request
+			state->failures++;
+			state->outstanding--;
+		});
+	}
+}
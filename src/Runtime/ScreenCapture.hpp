@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Vulkan/Vulkan.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Vulkan
+{
+	class VulkanBaseRenderer;
+}
+
+namespace ScreenCapture
+{
+	// runs on the task thread with the encoded file contents
+	using EncodedCallback = std::function<void(const std::vector<uint8_t>& encoded)>;
+
+	// swapchain image of the next frame, ui included, converted and encoded on a task thread and saved as
+	// <basename>.avif when built with avif, <basename>.jpg otherwise; the render loop never waits on it
+	void RequestScreenShot(Vulkan::VulkanBaseRenderer& renderer, const std::string& basename, EncodedCallback onEncoded);
+
+	// linear accumulation of the next frame, before tonemapping and denoising, written as OpenEXR on a task thread;
+	// with aovs the albedo and normal targets go into "albedo" and "normal" layers of the same file
+	void RequestExr(Vulkan::VulkanBaseRenderer& renderer, const std::string& filename, bool floatChannels, bool withAov);
+
+	// swapchain texels to what the screenshot encoder takes: rgba8, or rgba16 holding 10 bit values when the format
+	// is packed 10 bit, alpha forced opaque; returns whether it was the 10 bit one
+	bool ConvertSwapChainPixels(VkFormat format, const uint8_t* src, size_t pixelCount, std::vector<uint8_t>& pixels);
+	// any swapchain format to rgba8, hdr squashed, as png and y4m sequences take it
+	void ConvertSwapChainToSdr(VkFormat format, const uint8_t* src, size_t pixelCount, std::vector<uint8_t>& rgba);
+
+	enum class ESequenceFormat
+	{
+		Png,
+		Exr,
+		Y4m,
+	};
+
+	// png and y4m take the swapchain, exr the linear output
+	bool ParseSequenceFormat(const std::string& name, ESequenceFormat& format);
+
+	// Captures every Nth frame into <prefix>_NNNNN.png/.exr or one <prefix>.y4m stream. Up to Depth captures are
+	// in flight between the readback ring and the encoders; when they fall behind, a due capture moves on to the
+	// next frame rather than the renderer waiting.
+	class Sequence final
+	{
+	public:
+		static constexpr uint32_t Depth = 4;
+
+		Sequence(uint32_t every, uint32_t maxFrames, ESequenceFormat format, const std::string& prefix);
+		~Sequence();
+
+		void Tick(Vulkan::VulkanBaseRenderer& renderer);
+		bool Finished() const;
+
+	private:
+		struct State;
+
+		const uint32_t every_;
+		const uint32_t maxFrames_;
+		const ESequenceFormat format_;
+		const std::string prefix_;
+
+		uint32_t frame_{};
+		uint32_t captured_{};
+		uint32_t deferred_{};
+		bool due_{};
+		bool disabled_{};
+		bool reported_{};
+		std::shared_ptr<State> state_;
+	};
+}
@@ -1,10 +1,12 @@
 #include "TaskCoordinator.hpp"
+#include "Utilities/Profiler.hpp"
 
 TaskThread::TaskThread(TaskCoordinator* coordinator)
 {
     complete_.reset(new event_signal());
     terminate_.reset(new event_signal());
     thread_.reset(new std::thread([this] {
+        Utilities::Profiler::SetThreadName("task");
         while (true)
         {
             if(terminate_->is_set())
@@ -15,13 +17,13 @@ TaskThread::TaskThread(TaskCoordinator* coordinator)
             ResTask task;
             if (taskQueue_.dequeue(task, false))
             {
-                task.task_func(task);
-
-                // sync add to mainthread complete queue
-                if(task.complete_func != nullptr)
                 {
-                    TaskCoordinator::GetInstance()->MarkTaskComplete(task);
+                    PROFILER_SCOPE("task");
+                    task.task_func(task);
                 }
+
+                // sync add to mainthread complete queue, tasks without complete_func still pass through to be counted
+                TaskCoordinator::GetInstance()->MarkTaskComplete(task);
             }
             else
             {
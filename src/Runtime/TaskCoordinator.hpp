@@ -269,6 +269,7 @@ public:
         task.priority = priority;
         task.task_func = std::move(task_func);
         task.complete_func = std::move(complete_func);
+        pendingTasks_++;
         threads_[priority]->taskQueue_.enqueue(task);
         return task.task_id;
     }
@@ -284,9 +285,19 @@ public:
         ResTask task;
         if( completeTaskQueue_.dequeue(task, false) )
         {
-            task.complete_func(task);
+            if(task.complete_func != nullptr)
+            {
+                task.complete_func(task);
+            }
+            pendingTasks_--;
         }
     }
+
+    // true when every added task has run and its completion has been delivered on the main thread
+    bool IsIdle() const
+    {
+        return pendingTasks_ == 0;
+    }
     
 
     static TaskCoordinator* GetInstance()
@@ -301,6 +312,7 @@ public:
 private:
     std::vector< std::unique_ptr<TaskThread> > threads_;
     tsqueue<ResTask> completeTaskQueue_;
+    mutable std::atomic<uint32_t> pendingTasks_{};
 
 
 private:
@@ -30,10 +30,12 @@
 #include "Options.hpp"
 #include "Assets/Scene.hpp"
 #include "Assets/TextureImage.hpp"
+#include "Assets/UniformBuffer.hpp"
 #include "Editor/EditorMain.h"
 #include "Utilities/FileHelper.hpp"
 #include "Utilities/Localization.hpp"
 #include "Utilities/Math.hpp"
+#include "Utilities/Profiler.hpp"
 #include "Vulkan/ImageView.hpp"
 #include "Vulkan/RenderImage.hpp"
 #include "Vulkan/VulkanBaseRenderer.hpp"
@@ -350,12 +352,16 @@ void UserInterface::DrawSettings()
 
 		if( ImGui::CollapsingHeader(LOCTEXT("Ray Tracing"), ImGuiTreeNodeFlags_DefaultOpen) )
 		{
-			uint32_t min = 0, max = 7; //max bounce + 1 will off roulette. max bounce now is 6
-			//ImGui::SliderScalar(LOCTEXT("RR Start"), ImGuiDataType_U32, &Settings().RR_MIN_DEPTH, &min, &max);
-			//ImGui::Checkbox(LOCTEXT("AdaptiveSample"), &Settings().AdaptiveSample);
+			uint32_t min = 0, max = static_cast<uint32_t>(Settings().MaxNumberOfBounces) + 1; //max bounce + 1 will off roulette
+			ImGui::SliderScalar(LOCTEXT("RR Start"), ImGuiDataType_U32, &Settings().RussianRouletteDepth, &min, &max);
+			ImGui::Checkbox(LOCTEXT("AdaptiveSample"), &Settings().AdaptiveSample);
 			ImGui::Checkbox(LOCTEXT("AntiAlias"), &Settings().TAA);
+			ImGui::Checkbox(LOCTEXT("Firefly Clamp"), &Settings().FireflyClamp);
+			std::vector<const char*> samplers {"Random", "Sobol"};
+			ImGui::Combo(LOCTEXT("Sampler"), &Settings().Sampler, samplers.data(), static_cast<int>(samplers.size()));
+			uint32_t cacheMin = 0, cacheMax = 2;
+			ImGui::SliderScalar(LOCTEXT("Cache Bounce"), ImGuiDataType_U32, &Settings().RadianceCacheBounce, &cacheMin, &cacheMax);
 			ImGui::SliderInt(LOCTEXT("Samples"), &Settings().NumberOfSamples, 1, 16);
-			ImGui::SliderInt(LOCTEXT("TemporalSteps"), &Settings().AdaptiveSteps, 2, 16);
 			ImGui::NewLine();
 		}
 
@@ -363,13 +369,20 @@ void UserInterface::DrawSettings()
 		{
 #if WITH_OIDN
 			ImGui::Checkbox("Use OIDN", &Settings().Denoiser);
+			std::vector<const char*> filters {"OIDN", "SVGF"};
 #else
 			ImGui::Checkbox(LOCTEXT("Use JBF"), &Settings().Denoiser);
 			// ImGui::SliderFloat(LOCTEXT("DenoiseSigma"), &Settings().DenoiseSigma, 0.01f, 1.0f, "%.2f");
 			// ImGui::SliderFloat(LOCTEXT("DenoiseSigmaLum"), &Settings().DenoiseSigmaLum, 0.01f, 50.0f, "%.2f");
 			// ImGui::SliderFloat(LOCTEXT("DenoiseSigmaNormal"), &Settings().DenoiseSigmaNormal, 0.001f, 0.2f, "%.3f");
 			// ImGui::SliderInt(LOCTEXT("DenoiseSize"), &Settings().DenoiseSize, 1, 10);
+			std::vector<const char*> filters {"JBF", "SVGF"};
 #endif
+			ImGui::Combo(LOCTEXT("Filter"), &Settings().DenoiseFilter, filters.data(), static_cast<int>(filters.size()));
+			if (Settings().DenoiseFilter == DENOISE_FILTER_SVGF)
+			{
+				ImGui::SliderInt(LOCTEXT("Atrous Passes"), &Settings().DenoiseIterations, 1, SVGF_MAX_ITERATIONS);
+			}
 			ImGui::NewLine();
 		}
 		
@@ -399,6 +412,8 @@ void UserInterface::DrawSettings()
 				ImGui::SliderFloat(LOCTEXT("SunLum"), &Settings().SunLuminance, 0.0f, 2000.0f, "%.0f");
 			}
 
+			ImGui::Checkbox(LOCTEXT("Light Tree"), &Settings().LightTree);
+
 			ImGui::SliderFloat(LOCTEXT("PaperWhitNit"), &Settings().PaperWhiteNit, 100.0f, 1600.0f, "%.1f");
 			ImGui::NewLine();
 		}
@@ -409,6 +424,8 @@ void UserInterface::DrawSettings()
 			ImGui::Separator();
 			ImGui::Checkbox(LOCTEXT("DebugDraw"), &Settings().ShowVisualDebug);
 			ImGui::SliderFloat(LOCTEXT("Time Scaling"), &Settings().HeatmapScale, 0.10f, 2.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+			ImGui::Checkbox(LOCTEXT("Ray Statistics"), &Settings().RayStatistics);
+			ImGui::Checkbox(LOCTEXT("Memory Statistics"), &Settings().MemoryStatistics);
 			ImGui::NewLine();
 
 			ImGui::Text("%s", LOCTEXT("Performance"));
@@ -462,11 +479,37 @@ void UserInterface::DrawOverlay(const Statistics& statistics, Vulkan::VulkanGpuT
 		ImGui::Text("Texture: %d", statistics.TextureCount);
 
 		ImGui::Text("frametime: %.2fms", statistics.FrameTime);
+		if (statistics.RayStatistics)
+		{
+			ImGui::Text("Rays: %.1f Mrays/s", statistics.RayRate);
+			ImGui::Text(" primary: %s", Utilities::metricFormatter(static_cast<double>(statistics.PrimaryRays), "").c_str());
+			ImGui::Text(" bounce: %s", Utilities::metricFormatter(static_cast<double>(statistics.BounceRays), "").c_str());
+			ImGui::Text(" shadow: %s", Utilities::metricFormatter(static_cast<double>(statistics.ShadowRays), "").c_str());
+			ImGui::Text(" samples: %s", Utilities::metricFormatter(static_cast<double>(statistics.TotalSamples), "").c_str());
+			ImGui::Text(" early exit: %.1f%%", statistics.EarlyTerminations * 100.0f);
+			ImGui::Text(" roulette: %.1f%%", statistics.RouletteTerminations * 100.0f);
+			ImGui::PlotHistogram("##bounces", statistics.BounceHistogram.data(), static_cast<int>(statistics.BounceHistogram.size()), 0, "bounces", 0.0f, FLT_MAX, ImVec2(0, 40));
+		}
+		for (const auto& heap : statistics.MemoryHeaps)
+		{
+			if (heap.Tracked == 0)
+			{
+				continue;
+			}
+			constexpr float mb = 1.0f / (1024.0f * 1024.0f);
+			ImGui::Text("Heap %d%s: %.0f / %.0f MB, peak %.0f MB", heap.Index, heap.DeviceLocal ? " (vram)" : "", heap.Usage * mb, heap.Budget * mb, heap.Peak * mb);
+			for (uint32_t i = 0; i != Vulkan::MemoryTracker::CategoryCount; ++i)
+			{
+				if (heap.Categories[i] > 0)
+				{
+					ImGui::Text(" %s: %.1f MB", Vulkan::MemoryCategoryName(static_cast<Vulkan::EMemoryCategory>(i)), heap.Categories[i] * mb);
+				}
+			}
+		}
 		// auto fetch timer & display
-		auto times = gpuTimer->FetchAllTimes();
-		for(auto& time : times)
+		for(const auto& time : gpuTimer->Results())
 		{
-			ImGui::Text("%s: %.2fms", std::get<0>(time).c_str(), std::get<1>(time));
+			ImGui::Text("%*s%s: %.2fms", static_cast<int>(time.Depth + 1) * 2, "", Utilities::Profiler::Name(time.Id), time.Time);
 		}
 		
 		
@@ -3,6 +3,7 @@
 #include <imgui_internal.h>
 #include "Vulkan/Vulkan.hpp"
 #include "Vulkan/FrameBuffer.hpp"
+#include "Vulkan/MemoryTracker.hpp"
 #include <vector>
 #include <memory>
 #include <string>
@@ -46,6 +47,18 @@ struct Statistics final
 	uint32_t ComputePassCount;
 	bool LoadingStatus;
 
+	// gpu ray counters of the last frame, RayRate in Mrays/s
+	bool RayStatistics;
+	uint32_t PrimaryRays;
+	uint32_t BounceRays;
+	uint32_t ShadowRays;
+	float EarlyTerminations;
+	float RouletteTerminations;
+	std::vector<float> BounceHistogram;
+
+	// device memory per heap, empty unless the memory statistics are on
+	std::vector<Vulkan::MemoryTracker::HeapUsage> MemoryHeaps;
+
 	mutable std::unordered_map< std::string, std::string> Stats;
 };
 
@@ -22,10 +22,12 @@ struct UserSettings final
 	int32_t NumberOfSamples;
 	int32_t NumberOfBounces;
 	int32_t MaxNumberOfBounces;
+	uint32_t RussianRouletteDepth;
 	bool AdaptiveSample;
-	float AdaptiveVariance;
-	int AdaptiveSteps;
 	bool TAA;
+	bool FireflyClamp;
+	int Sampler;
+	uint32_t RadianceCacheBounce;
 
 	// Camera
 	float FieldOfView;
@@ -41,10 +43,13 @@ struct UserSettings final
 	float SunLuminance;
 	float SkyIntensity;
 	int SkyIdx, CameraIdx;
+	bool LightTree;
 
 	// Profiler
 	bool ShowVisualDebug;
 	float HeatmapScale;
+	bool RayStatistics;
+	bool MemoryStatistics;
 
 	// UI
 	bool ShowSettings;
@@ -60,6 +65,8 @@ struct UserSettings final
 	float DenoiseSigmaLum;
 	float DenoiseSigmaNormal;
 	int DenoiseSize;
+	int DenoiseFilter;
+	int DenoiseIterations;
 
 	float PaperWhiteNit;
 	
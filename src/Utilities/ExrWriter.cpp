@@ -0,0 +1,210 @@
+#include "ExrWriter.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <glm/gtc/packing.hpp>
+
+// deflate of the stb_image_write implementation compiled into Assets/Model.cpp, exported but not declared by its header
+extern "C" unsigned char* stbi_zlib_compress(unsigned char* data, int data_len, int* out_len, int quality);
+
+namespace Utilities
+{
+    namespace Exr
+    {
+        namespace
+        {
+            constexpr int32_t Magic = 20000630;
+            constexpr int32_t Version = 2;
+
+            // all supported targets are little endian, which is the byte order of the format
+            template <typename T>
+            void Put(std::vector<uint8_t>& out, const T& value)
+            {
+                const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+                out.insert(out.end(), bytes, bytes + sizeof(T));
+            }
+
+            void PutString(std::vector<uint8_t>& out, const std::string& value)
+            {
+                out.insert(out.end(), value.begin(), value.end());
+                out.push_back(0);
+            }
+
+            void PutAttribute(std::vector<uint8_t>& out, const char* name, const char* type, const std::vector<uint8_t>& value)
+            {
+                PutString(out, name);
+                PutString(out, type);
+                Put(out, static_cast<int32_t>(value.size()));
+                out.insert(out.end(), value.begin(), value.end());
+            }
+
+            void PutSample(std::vector<uint8_t>& out, const Channel& channel, size_t index, EPixelType pixelType)
+            {
+                const size_t offset = index * channel.Stride;
+                if (pixelType == EPixelType::Half)
+                {
+                    Put(out, channel.SourceType == EPixelType::Half
+                                 ? static_cast<const uint16_t*>(channel.Data)[offset]
+                                 : static_cast<uint16_t>(glm::packHalf1x16(static_cast<const float*>(channel.Data)[offset])));
+                }
+                else
+                {
+                    Put(out, channel.SourceType == EPixelType::Float
+                                 ? static_cast<const float*>(channel.Data)[offset]
+                                 : glm::unpackHalf1x16(static_cast<const uint16_t*>(channel.Data)[offset]));
+                }
+            }
+
+            // channel planar scanlines, then the zip filter of the format: split even and odd bytes, delta encode, deflate
+            std::vector<uint8_t> EncodeBlock(uint32_t width, uint32_t firstLine, uint32_t lastLine, const std::vector<Channel>& channels, const WriteOptions& options)
+            {
+                std::vector<uint8_t> raw;
+                raw.reserve(static_cast<size_t>(lastLine - firstLine) * width * channels.size() * (options.PixelType == EPixelType::Half ? 2 : 4));
+                for (uint32_t y = firstLine; y < lastLine; ++y)
+                {
+                    for (const auto& channel : channels)
+                    {
+                        for (uint32_t x = 0; x < width; ++x)
+                        {
+                            PutSample(raw, channel, static_cast<size_t>(y) * width + x, options.PixelType);
+                        }
+                    }
+                }
+
+                if (options.Compression == ECompression::None || raw.empty())
+                {
+                    return raw;
+                }
+
+                std::vector<uint8_t> filtered(raw.size());
+                const size_t half = (raw.size() + 1) / 2;
+                for (size_t i = 0; i < raw.size(); ++i)
+                {
+                    filtered[(i & 1) ? half + i / 2 : i / 2] = raw[i];
+                }
+                for (size_t i = filtered.size() - 1; i > 0; --i)
+                {
+                    filtered[i] = static_cast<uint8_t>(filtered[i] - filtered[i - 1] + 128);
+                }
+
+                int compressedBytes = 0;
+                unsigned char* compressed = stbi_zlib_compress(filtered.data(), static_cast<int>(filtered.size()), &compressedBytes, 8);
+                if (compressed == nullptr)
+                {
+                    return raw;
+                }
+
+                // a block that does not shrink is stored raw, readers tell by the size
+                std::vector<uint8_t> block = static_cast<size_t>(compressedBytes) < raw.size() ? std::vector<uint8_t>(compressed, compressed + compressedBytes) : raw;
+                free(compressed);
+                return block;
+            }
+        }
+
+        bool Write(const std::string& filename, uint32_t width, uint32_t height, std::vector<Channel> channels, const WriteOptions& options)
+        {
+            if (width == 0 || height == 0 || channels.empty())
+            {
+                return false;
+            }
+
+            std::sort(channels.begin(), channels.end(), [](const Channel& a, const Channel& b) { return a.Name < b.Name; });
+
+            // header
+            std::vector<uint8_t> header;
+            Put(header, Magic);
+            Put(header, Version);
+
+            std::vector<uint8_t> channelList;
+            for (const auto& channel : channels)
+            {
+                PutString(channelList, channel.Name);
+                Put(channelList, static_cast<int32_t>(options.PixelType));
+                Put(channelList, static_cast<uint32_t>(0)); // pLinear + reserved
+                Put(channelList, static_cast<int32_t>(1));
+                Put(channelList, static_cast<int32_t>(1));
+            }
+            channelList.push_back(0);
+            PutAttribute(header, "channels", "chlist", channelList);
+
+            PutAttribute(header, "compression", "compression", {static_cast<uint8_t>(options.Compression)});
+
+            std::vector<uint8_t> window;
+            Put(window, static_cast<int32_t>(0));
+            Put(window, static_cast<int32_t>(0));
+            Put(window, static_cast<int32_t>(width - 1));
+            Put(window, static_cast<int32_t>(height - 1));
+            PutAttribute(header, "dataWindow", "box2i", window);
+            PutAttribute(header, "displayWindow", "box2i", window);
+
+            PutAttribute(header, "lineOrder", "lineOrder", {0});
+
+            std::vector<uint8_t> value;
+            Put(value, 1.0f);
+            PutAttribute(header, "pixelAspectRatio", "float", value);
+            value.clear();
+            Put(value, 0.0f);
+            Put(value, 0.0f);
+            PutAttribute(header, "screenWindowCenter", "v2f", value);
+            value.clear();
+            Put(value, 1.0f);
+            PutAttribute(header, "screenWindowWidth", "float", value);
+            header.push_back(0);
+
+            // blocks, compressed in parallel and written in order
+            const uint32_t linesPerBlock = options.Compression == ECompression::Zip ? 16 : 1;
+            const uint32_t blockCount = (height + linesPerBlock - 1) / linesPerBlock;
+            std::vector<std::vector<uint8_t>> blocks(blockCount);
+
+            std::atomic<uint32_t> nextBlock{0};
+            const auto encode = [&]()
+            {
+                for (uint32_t block = nextBlock++; block < blockCount; block = nextBlock++)
+                {
+                    const uint32_t firstLine = block * linesPerBlock;
+                    blocks[block] = EncodeBlock(width, firstLine, std::min(firstLine + linesPerBlock, height), channels, options);
+                }
+            };
+
+            const uint32_t threadCount = std::clamp(options.Threads != 0 ? options.Threads : std::thread::hardware_concurrency(), 1u, blockCount);
+            std::vector<std::thread> threads;
+            for (uint32_t i = 1; i < threadCount; ++i)
+            {
+                threads.emplace_back(encode);
+            }
+            encode();
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+
+            std::ofstream file(filename, std::ios::out | std::ios::binary);
+            if (!file.is_open())
+            {
+                return false;
+            }
+
+            std::vector<uint8_t> offsets;
+            uint64_t offset = header.size() + static_cast<uint64_t>(blockCount) * sizeof(uint64_t);
+            for (const auto& block : blocks)
+            {
+                Put(offsets, offset);
+                offset += 2 * sizeof(int32_t) + block.size();
+            }
+
+            file.write(reinterpret_cast<const char*>(header.data()), header.size());
+            file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size());
+            for (uint32_t i = 0; i < blockCount; ++i)
+            {
+                const int32_t blockHeader[2] = {static_cast<int32_t>(i * linesPerBlock), static_cast<int32_t>(blocks[i].size())};
+                file.write(reinterpret_cast<const char*>(blockHeader), sizeof(blockHeader));
+                file.write(reinterpret_cast<const char*>(blocks[i].data()), blocks[i].size());
+            }
+
+            return file.good();
+        }
+    }
+}
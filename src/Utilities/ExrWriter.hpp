@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Utilities
+{
+    namespace Exr
+    {
+        enum class EPixelType : int32_t
+        {
+            Half = 1,
+            Float = 2,
+        };
+
+        enum class ECompression : uint8_t
+        {
+            None = 0,
+            Zip = 3,
+        };
+
+        // one named channel, Data points at the first sample and consecutive samples are Stride elements apart,
+        // so an interleaved rgba buffer is passed as four channels over the same memory
+        struct Channel
+        {
+            std::string Name;
+            const void* Data;
+            EPixelType SourceType;
+            uint32_t Stride;
+        };
+
+        struct WriteOptions
+        {
+            EPixelType PixelType = EPixelType::Half;
+            ECompression Compression = ECompression::Zip;
+            // 0 picks the hardware concurrency
+            uint32_t Threads = 0;
+        };
+
+        // scanline OpenEXR, channels are sorted by name as the format requires, layers use "layer.X" names
+        bool Write(const std::string& filename, uint32_t width, uint32_t height, std::vector<Channel> channels, const WriteOptions& options);
+    }
+}
@@ -0,0 +1,204 @@
+#include "Profiler.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <fmt/format.h>
+
+namespace Utilities
+{
+	namespace Profiler
+	{
+		namespace
+		{
+			struct Registry
+			{
+				std::mutex mutex;
+				std::array<std::atomic<const char*>, MaxScopeIds> names{};
+				std::atomic<uint32_t> nameCount{};
+				std::vector<std::unique_ptr<Track>> tracks;
+				std::array<std::atomic<uint64_t>, FrameHistory> frameNumbers{};
+				std::array<std::atomic<int64_t>, FrameHistory> frameTimes{};
+				const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+			};
+
+			Registry& GetRegistry()
+			{
+				static Registry registry;
+				return registry;
+			}
+
+			thread_local Track* threadTrack = nullptr;
+
+			Track& RegisterTrack(std::string name)
+			{
+				Registry& registry = GetRegistry();
+				std::lock_guard<std::mutex> lock(registry.mutex);
+				registry.tracks.emplace_back(new Track(name.empty() ? fmt::format("thread {}", registry.tracks.size()) : std::move(name)));
+				return *registry.tracks.back();
+			}
+
+			std::string Escape(const char* text)
+			{
+				std::string escaped;
+				for (; *text != 0; ++text)
+				{
+					if (*text == '"' || *text == '\\')
+					{
+						escaped.push_back('\\');
+					}
+					escaped.push_back(*text);
+				}
+				return escaped;
+			}
+		}
+
+		void Track::Collect(int64_t begin, int64_t end, std::vector<Event>& out) const
+		{
+			// the slots just ahead of the head may be rewritten while we read, leave them out
+			constexpr uint64_t writeMargin = 256;
+			const uint64_t head = head_.load(std::memory_order_acquire);
+			const uint64_t first = head > Capacity - writeMargin ? head - (Capacity - writeMargin) : 0;
+			for (uint64_t i = first; i < head; ++i)
+			{
+				const Event& event = events_[i % Capacity];
+				if (event.End >= begin && event.End <= end)
+				{
+					out.push_back(event);
+				}
+			}
+		}
+
+		int64_t Now()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - GetRegistry().epoch).count();
+		}
+
+		uint32_t Intern(const char* name)
+		{
+			Registry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+
+			// the same name from different call sites shares the id
+			const uint32_t id = Find(name);
+			if (id != InvalidScopeId)
+			{
+				return id;
+			}
+
+			const uint32_t count = registry.nameCount.load();
+			if (count == MaxScopeIds)
+			{
+				return InvalidScopeId;
+			}
+			registry.names[count].store(name);
+			registry.nameCount.store(count + 1);
+			return count;
+		}
+
+		uint32_t Find(const char* name)
+		{
+			const Registry& registry = GetRegistry();
+			const uint32_t count = registry.nameCount.load();
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				if (std::strcmp(registry.names[i].load(), name) == 0)
+				{
+					return i;
+				}
+			}
+			return InvalidScopeId;
+		}
+
+		const char* Name(uint32_t id)
+		{
+			return id < GetRegistry().nameCount.load() ? GetRegistry().names[id].load() : "unknown";
+		}
+
+		Track& ThreadTrack()
+		{
+			if (threadTrack == nullptr)
+			{
+				threadTrack = &RegisterTrack({});
+			}
+			return *threadTrack;
+		}
+
+		void SetThreadName(const char* name)
+		{
+			// tracks keep the name they were created with, so this only counts before the first scope of the thread
+			if (threadTrack == nullptr)
+			{
+				threadTrack = &RegisterTrack(name);
+			}
+		}
+
+		Track& CreateTrack(const char* name)
+		{
+			return RegisterTrack(name);
+		}
+
+		void MarkFrame(uint64_t frame)
+		{
+			Registry& registry = GetRegistry();
+			registry.frameTimes[frame % FrameHistory].store(Now());
+			registry.frameNumbers[frame % FrameHistory].store(frame);
+		}
+
+		bool FrameTime(uint64_t frame, int64_t& time)
+		{
+			const Registry& registry = GetRegistry();
+			if (registry.frameNumbers[frame % FrameHistory].load() != frame)
+			{
+				return false;
+			}
+			time = registry.frameTimes[frame % FrameHistory].load();
+			return true;
+		}
+
+		bool ExportChromeTrace(const std::string& filename, int64_t begin, int64_t end)
+		{
+			std::vector<Track*> tracks;
+			{
+				Registry& registry = GetRegistry();
+				std::lock_guard<std::mutex> lock(registry.mutex);
+				for (auto& track : registry.tracks)
+				{
+					tracks.push_back(track.get());
+				}
+			}
+
+			std::ofstream file(filename, std::ios::out);
+			if (!file.is_open())
+			{
+				return false;
+			}
+
+			file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+			bool first = true;
+			std::vector<Event> events;
+			for (size_t tid = 0; tid < tracks.size(); ++tid)
+			{
+				file << fmt::format("{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}", first ? "" : ",\n", tid, Escape(tracks[tid]->Name().c_str()));
+				first = false;
+
+				events.clear();
+				tracks[tid]->Collect(begin, end, events);
+				for (const auto& event : events)
+				{
+					if (event.Id == InvalidScopeId)
+					{
+						continue;
+					}
+					// chrome wants microseconds
+					file << fmt::format(",\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":0,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+						Escape(Name(event.Id)), tid, event.Begin * 1e-3, (event.End - event.Begin) * 1e-3);
+				}
+			}
+			file << "\n]}\n";
+			return file.good();
+		}
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// one interned id per call site, the name has to be a string literal
+#define PROFILER_SCOPE_ID(name) ([]() { static const uint32_t scopeId = Utilities::Profiler::Intern(name); return scopeId; }())
+#define PROFILER_SCOPE(name) Utilities::Profiler::Scope profilerScope(PROFILER_SCOPE_ID(name))
+
+namespace Utilities
+{
+	namespace Profiler
+	{
+		constexpr uint32_t MaxScopeIds = 1024;
+		constexpr uint32_t InvalidScopeId = UINT32_MAX;
+
+		struct Event
+		{
+			uint32_t Id;
+			int64_t Begin;
+			int64_t End;
+		};
+
+		// Single producer event ring. The owner appends without locks or allocation, readers take whatever lies
+		// behind the published head, the oldest events are overwritten once the ring wrapped.
+		class Track final
+		{
+		public:
+			static constexpr uint32_t Capacity = 1 << 15;
+
+			explicit Track(std::string name) : name_(std::move(name)), events_(Capacity) {}
+
+			void Emit(uint32_t id, int64_t begin, int64_t end)
+			{
+				const uint64_t head = head_.load(std::memory_order_relaxed);
+				events_[head % Capacity] = {id, begin, end};
+				head_.store(head + 1, std::memory_order_release);
+			}
+
+			// events ending inside [begin, end], in emission order
+			void Collect(int64_t begin, int64_t end, std::vector<Event>& out) const;
+			const std::string& Name() const { return name_; }
+
+		private:
+			const std::string name_;
+			std::vector<Event> events_;
+			std::atomic<uint64_t> head_{};
+		};
+
+		// nanoseconds since the profiler started
+		int64_t Now();
+
+		uint32_t Intern(const char* name);
+		// linear search, no allocation, InvalidScopeId if the name was never interned
+		uint32_t Find(const char* name);
+		const char* Name(uint32_t id);
+
+		// the calling thread's own track, created on first use and kept until exit
+		Track& ThreadTrack();
+		void SetThreadName(const char* name);
+		// a track fed by someone else, like the gpu timeline
+		Track& CreateTrack(const char* name);
+
+		// frame boundaries, kept for the last FrameHistory frames to pick a trace range
+		constexpr uint32_t FrameHistory = 4096;
+		void MarkFrame(uint64_t frame);
+		bool FrameTime(uint64_t frame, int64_t& time);
+
+		// chrome://tracing / perfetto json of everything recorded in [begin, end]
+		bool ExportChromeTrace(const std::string& filename, int64_t begin, int64_t end);
+
+		class Scope final
+		{
+		public:
+			explicit Scope(uint32_t id) : id_(id), begin_(Now()) {}
+			~Scope() { ThreadTrack().Emit(id_, begin_, Now()); }
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+		private:
+			const uint32_t id_;
+			const int64_t begin_;
+		};
+	}
+}
@@ -39,6 +39,7 @@ namespace Vulkan
 		const auto contentSize = sizeof(content[0]) * content.size();
 		
 		// Create a temporary host-visible staging buffer.
+		MemoryScope memoryScope(EMemoryCategory::Staging, nullptr);
 		auto stagingBuffer = std::make_unique<Buffer>(device, contentSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
 		auto stagingBufferMemory = stagingBuffer->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
@@ -61,6 +62,7 @@ namespace Vulkan
 		const auto contentSize = sizeof(content[0]) * content.size();
 		
 		// Create a temporary host-visible staging buffer.
+		MemoryScope memoryScope(EMemoryCategory::Staging, nullptr);
 		auto stagingBuffer = std::make_unique<Buffer>(device, contentSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
 		auto stagingBufferMemory = stagingBuffer->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
@@ -92,6 +94,8 @@ namespace Vulkan
 			? VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
 			: 0;
 		
+		// the caller's scope picks the category
+		MemoryScope memoryScope(name);
 		buffer.reset(new Buffer(device, contentSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | usage));
 		memory.reset(new DeviceMemory(buffer->AllocateMemory(allocateFlags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
 
@@ -47,6 +47,7 @@ namespace Vulkan {
 	{
 		const auto& device = commandPool.Device();
 
+		MemoryScope memoryScope(EMemoryCategory::RenderTarget, "depth buffer");
 		image_.reset(new Image(device, extent, format_, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT));
 		imageMemory_.reset(new DeviceMemory(image_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
 		imageView_.reset(new class ImageView(device, image_->Handle(), format_, VK_IMAGE_ASPECT_DEPTH_BIT));
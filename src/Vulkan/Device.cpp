@@ -5,6 +5,7 @@
 #include "Utilities/Exception.hpp"
 #include "Vulkan/RayTracing/DeviceProcedures.hpp"
 #include <algorithm>
+#include <cstring>
 #include <set>
 
 namespace Vulkan {
@@ -135,6 +136,11 @@ Device::Device(
 	vkGetDeviceQueue(device_, transferFamilyIndex_, 0, &transferQueue_);
 
     vkGetPhysicalDeviceProperties(PhysicalDevice(), &deviceProp_);
+
+	memoryBudgetSupported_ = std::any_of(requiredExtensions.begin(), requiredExtensions.end(), [](const char* extension)
+	{
+		return std::strcmp(extension, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0;
+	});
 	
 	deviceProcedures_.reset(new DeviceProcedures(*this, true, true));
 }
@@ -43,6 +43,9 @@ namespace Vulkan
 
 		VkPhysicalDeviceProperties DeviceProperties() const { return deviceProp_; }
 
+		// VK_EXT_memory_budget is optional, the renderer enables it where the driver has it
+		bool MemoryBudgetSupported() const { return memoryBudgetSupported_; }
+
 		void WaitIdle() const;
 
 		const DeviceProcedures& GetDeviceProcedures() const { return *deviceProcedures_; }
@@ -70,6 +73,7 @@ namespace Vulkan
 				
 		std::unique_ptr<DeviceProcedures> deviceProcedures_;
 		VkPhysicalDeviceProperties deviceProp_;
+		bool memoryBudgetSupported_{};
 	};
 
 }
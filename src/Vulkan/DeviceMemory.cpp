@@ -87,6 +87,9 @@ DeviceMemory::DeviceMemory(
 	bool external) :
 	device_(device)
 {
+	VkPhysicalDeviceMemoryProperties memProperties;
+	vkGetPhysicalDeviceMemoryProperties(device_.PhysicalDevice(), &memProperties);
+
 	VkMemoryAllocateFlagsInfo flagsInfo = {};
 	flagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
 	flagsInfo.pNext = nullptr;
@@ -96,7 +99,7 @@ DeviceMemory::DeviceMemory(
 	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 	allocInfo.pNext = &flagsInfo;
 	allocInfo.allocationSize = size;
-	allocInfo.memoryTypeIndex = FindMemoryType(memoryTypeBits, propertyFlags);
+	allocInfo.memoryTypeIndex = FindMemoryType(memProperties, memoryTypeBits, propertyFlags);
 
 	VkExportMemoryAllocateInfoKHR export_memory_allocate_info{};
 	export_memory_allocate_info.sType       = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO_KHR;
@@ -123,12 +126,20 @@ DeviceMemory::DeviceMemory(
 	}
 #endif
 	
-	Check(vkAllocateMemory(device.Handle(), &allocInfo, nullptr, &memory_),
+	const VkResult result = vkAllocateMemory(device.Handle(), &allocInfo, nullptr, &memory_);
+	if (result == VK_ERROR_OUT_OF_DEVICE_MEMORY || result == VK_ERROR_OUT_OF_HOST_MEMORY)
+	{
+		MemoryTracker::Print(device);
+	}
+	Check(result,
 		"allocate memory");
+
+	allocation_ = MemoryTracker::Track(memProperties, allocInfo.memoryTypeIndex, size);
 }
 
 DeviceMemory::DeviceMemory(DeviceMemory&& other) noexcept :
 	device_(other.device_),
+	allocation_(other.allocation_),
 	memory_(other.memory_)
 {
 	other.memory_ = nullptr;
@@ -140,6 +151,7 @@ DeviceMemory::~DeviceMemory()
 	{
 		vkFreeMemory(device_.Handle(), memory_, nullptr);
 		memory_ = nullptr;
+		MemoryTracker::Untrack(allocation_);
 	}
 }
 
@@ -157,11 +169,8 @@ void DeviceMemory::Unmap()
 	vkUnmapMemory(device_.Handle(), memory_);
 }
 
-uint32_t DeviceMemory::FindMemoryType(const uint32_t typeFilter, const VkMemoryPropertyFlags propertyFlags) const
+uint32_t DeviceMemory::FindMemoryType(const VkPhysicalDeviceMemoryProperties& memProperties, const uint32_t typeFilter, const VkMemoryPropertyFlags propertyFlags) const
 {
-	VkPhysicalDeviceMemoryProperties memProperties;
-	vkGetPhysicalDeviceMemoryProperties(device_.PhysicalDevice(), &memProperties);
-
 	for (uint32_t i = 0; i != memProperties.memoryTypeCount; ++i)
 	{
 		if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & propertyFlags) == propertyFlags)
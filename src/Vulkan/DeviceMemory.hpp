@@ -1,5 +1,6 @@
 #pragma once
 
+#include "MemoryTracker.hpp"
 #include "Vulkan.hpp"
 
 namespace Vulkan
@@ -25,9 +26,10 @@ namespace Vulkan
 
 	private:
 
-		uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+		uint32_t FindMemoryType(const VkPhysicalDeviceMemoryProperties& memProperties, uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
 
 		const class Device& device_;
+		MemoryTracker::Allocation allocation_{};
 
 		VULKAN_HANDLE(VkDeviceMemory, memory_)
 	};
@@ -23,7 +23,9 @@ namespace Vulkan::HybridDeferred
                                                  const ImageView& finalImageView, const ImageView& motionVectorImageView,
                                                  const ImageView& directLight0ImageView, const ImageView& directLight1ImageView,
                                                  const ImageView& albedoImageView, const ImageView& normalImageView,
-                                                 const std::vector<Assets::UniformBuffer>& uniformBuffers, const Assets::Scene& scene): swapChain_(swapChain)
+                                                 const std::vector<Assets::UniformBuffer>& uniformBuffers,
+                                                 const std::vector<Assets::RayStatisticsBuffer>& rayStatisticsBuffers, const Buffer& adaptiveTileBuffer,
+                                                 const Assets::Scene& scene): swapChain_(swapChain)
     {
         // Create descriptor pool/sets.
         const auto& device = swapChain.Device();
@@ -53,6 +55,12 @@ namespace Vulkan::HybridDeferred
 
             {13, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
             {14, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+
+            // ray statistics
+            {15, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+
+            // adaptive sampling tile errors
+            {16, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
         };
 
         descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, uniformBuffers.size()));
@@ -108,6 +116,16 @@ namespace Vulkan::HybridDeferred
             nodesBufferInfo.buffer = scene.NodeMatrixBuffer().Handle();
             nodesBufferInfo.range = VK_WHOLE_SIZE;
 
+            // Ray statistics buffer
+            VkDescriptorBufferInfo rayStatisticsBufferInfo = {};
+            rayStatisticsBufferInfo.buffer = rayStatisticsBuffers[i].Buffer().Handle();
+            rayStatisticsBufferInfo.range = VK_WHOLE_SIZE;
+
+            // Adaptive sampling tiles
+            VkDescriptorBufferInfo adaptiveTileBufferInfo = {};
+            adaptiveTileBufferInfo.buffer = adaptiveTileBuffer.Handle();
+            adaptiveTileBufferInfo.range = VK_WHOLE_SIZE;
+
             std::vector<VkWriteDescriptorSet> descriptorWrites =
             {
                 descriptorSets.Bind(i, 0, Info0),
@@ -124,7 +142,9 @@ namespace Vulkan::HybridDeferred
                 descriptorSets.Bind(i, 11, Info11),
                 descriptorSets.Bind(i, 12, Info12),
                 descriptorSets.Bind(i, 13, Info13),
-                descriptorSets.Bind(i, 14, Info14)
+                descriptorSets.Bind(i, 14, Info14),
+                descriptorSets.Bind(i, 15, rayStatisticsBufferInfo),
+                descriptorSets.Bind(i, 16, adaptiveTileBufferInfo)
             };
 
             descriptorSets.UpdateDescriptors(i, descriptorWrites);
@@ -11,6 +11,7 @@ namespace Assets
 {
 	class Scene;
 	class UniformBuffer;
+	class RayStatisticsBuffer;
 }
 
 namespace Vulkan
@@ -20,6 +21,7 @@ namespace Vulkan
 	class RenderPass;
 	class SwapChain;
 	class DescriptorSetManager;
+	class Buffer;
 
 	namespace RayTracing
 	{
@@ -44,6 +46,8 @@ namespace Vulkan::HybridDeferred
 			const ImageView& directLight0ImageView, const ImageView& directLight1ImageView,
 			const ImageView& albedoImageView, const ImageView& normalImageView,
 			const std::vector<Assets::UniformBuffer>& uniformBuffers,
+			const std::vector<Assets::RayStatisticsBuffer>& rayStatisticsBuffers,
+			const Buffer& adaptiveTileBuffer,
 			const Assets::Scene& scene);
 		~HybridShadingPipeline();
 
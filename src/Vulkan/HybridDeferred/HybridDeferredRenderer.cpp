@@ -2,6 +2,7 @@
 #include "HybridDeferredPipeline.hpp"
 
 #include "Vulkan/Buffer.hpp"
+#include "Vulkan/BufferUtil.hpp"
 #include "Vulkan/Device.hpp"
 #include "Vulkan/FrameBuffer.hpp"
 #include "Vulkan/PipelineLayout.hpp"
@@ -9,6 +10,7 @@
 #include "Vulkan/SwapChain.hpp"
 #include "Vulkan/Window.hpp"
 #include "Vulkan/ImageMemoryBarrier.hpp"
+#include "Vulkan/MemoryTracker.hpp"
 #include "Vulkan/PipelineCommon/CommonComputePipeline.hpp"
 #include "Assets/Model.hpp"
 #include "Assets/Scene.hpp"
@@ -93,8 +95,21 @@ namespace Vulkan::HybridDeferred
                                           VK_IMAGE_TILING_OPTIMAL,
                                           VK_IMAGE_USAGE_STORAGE_BIT));
 
-        rtAlbedo_.reset(new RenderImage(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_STORAGE_BIT, true, "albedo"));
-        rtNormal_.reset(new RenderImage(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_STORAGE_BIT, true, "normal"));
+        rtAlbedo_.reset(new RenderImage(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, true, "albedo"));
+        rtNormal_.reset(new RenderImage(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, true, "normal"));
+
+        rtMoments0.reset(new RenderImage(Device(), extent, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT, false, "moments0"));
+        rtMoments1.reset(new RenderImage(Device(), extent, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT, false, "moments1"));
+        rtDirectLightMoments0.reset(new RenderImage(Device(), extent, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT, false, "dlight moments0"));
+        rtDirectLightMoments1.reset(new RenderImage(Device(), extent, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT, false, "dlight moments1"));
+
+        {
+            MemoryScope memoryScope(EMemoryCategory::RenderTarget, "adaptive tiles");
+            const std::vector<uint32_t> tiles(2 + Utilities::Math::GetSafeDispatchCount(extent.width, ADAPTIVE_TILE_WIDTH) *
+                                                  Utilities::Math::GetSafeDispatchCount(extent.height, ADAPTIVE_TILE_HEIGHT), 0);
+            BufferUtil::CreateDeviceBuffer(CommandPool(), "AdaptiveTiles", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, tiles, adaptiveTileBuffer_, adaptiveTileBufferMemory_);
+            BufferUtil::CreateDeviceBuffer(CommandPool(), "DirectLightTiles", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, tiles, directLightTileBuffer_, directLightTileBufferMemory_);
+        }
         
         deferredFrameBuffer0_.reset(new FrameBuffer(rtVisibility0->GetImageView(), visibilityPipeline0_->RenderPass()));
         deferredFrameBuffer1_.reset(new FrameBuffer(rtVisibility1->GetImageView(), visibilityPipeline1_->RenderPass()));
@@ -108,7 +123,7 @@ namespace Vulkan::HybridDeferred
                                                          rtDirectLightSource->GetImageView(),
                                                          rtAlbedo_->GetImageView(),
                                                          rtNormal_->GetImageView(),
-                                                         UniformBuffers(), GetScene()));
+                                                         UniformBuffers(), RayStatisticsBuffers(), *adaptiveTileBuffer_, GetScene()));
         
         accumulatePipeline_.reset(new PipelineCommon::AccumulatePipeline(SwapChain(),
                                                                          rtAccumlation->GetImageView(),
@@ -118,6 +133,9 @@ namespace Vulkan::HybridDeferred
                                                                          rtVisibility0->GetImageView(),
                                                                          rtVisibility0->GetImageView(),
                                                                          rtOutput->GetImageView(),
+                                                                         rtMoments0->GetImageView(),
+                                                                         rtMoments1->GetImageView(),
+                                                                         *adaptiveTileBuffer_,
                                                                          UniformBuffers(), GetScene()));
 
         accumulateForLightPipeline_.reset(new PipelineCommon::AccumulatePipeline(SwapChain(),
@@ -128,6 +146,9 @@ namespace Vulkan::HybridDeferred
                                                                          rtVisibility0->GetImageView(),
                                                                          rtVisibility1->GetImageView(),
                                                                          rtDirectLightDest->GetImageView(),
+                                                                         rtDirectLightMoments0->GetImageView(),
+                                                                         rtDirectLightMoments1->GetImageView(),
+                                                                         *directLightTileBuffer_,
                                                                          UniformBuffers(), GetScene()));
 
         composePipeline_.reset(new PipelineCommon::FinalComposePipeline(SwapChain(), rtOutput->GetImageView(), rtAlbedo_->GetImageView(),  rtNormal_->GetImageView(), rtVisibility0->GetImageView(), rtVisibility0->GetImageView(), UniformBuffers()));
@@ -168,6 +189,16 @@ namespace Vulkan::HybridDeferred
 
         rtAlbedo_.reset();
         rtNormal_.reset();
+
+        rtMoments0.reset();
+        rtMoments1.reset();
+        rtDirectLightMoments0.reset();
+        rtDirectLightMoments1.reset();
+
+        adaptiveTileBuffer_.reset();
+        adaptiveTileBufferMemory_.reset();
+        directLightTileBuffer_.reset();
+        directLightTileBufferMemory_.reset();
     }
 
     void HybridDeferredRenderer::Render(VkCommandBuffer commandBuffer, uint32_t imageIndex)
@@ -234,6 +265,10 @@ namespace Vulkan::HybridDeferred
             rtDirectLightDest->InsertBarrier(commandBuffer, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
             rtAlbedo_->InsertBarrier(commandBuffer, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
             rtNormal_->InsertBarrier(commandBuffer, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+            rtMoments0->InsertBarrier(commandBuffer, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+            rtMoments1->InsertBarrier(commandBuffer, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+            rtDirectLightMoments0->InsertBarrier(commandBuffer, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+            rtDirectLightMoments1->InsertBarrier(commandBuffer, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
         }
 
         {
@@ -10,6 +10,8 @@
 
 namespace Vulkan
 {
+	class Buffer;
+	class DeviceMemory;
 	class RenderImage;
 }
 
@@ -44,6 +46,9 @@ namespace Vulkan::HybridDeferred
 		void CreateSwapChain() override;
 		void DeleteSwapChain() override;
 		void Render(VkCommandBuffer commandBuffer, uint32_t imageIndex) override;
+		const RenderImage* LinearOutput() const override { return rtOutput.get(); }
+		const RenderImage* AlbedoOutput() const override { return rtAlbedo_.get(); }
+		const RenderImage* NormalOutput() const override { return rtNormal_.get(); }
 
 	private:
 		std::unique_ptr<ModernDeferred::VisibilityPipeline> visibilityPipeline0_;
@@ -76,6 +81,18 @@ namespace Vulkan::HybridDeferred
 
 		std::unique_ptr<RenderImage> rtAlbedo_;
 		std::unique_ptr<RenderImage> rtNormal_;
+
+		// luminance moments of both accumulations, only the indirect one steers the shading pass's samples but each
+		// needs tiles of its own to write
+		std::unique_ptr<RenderImage> rtMoments0;
+		std::unique_ptr<RenderImage> rtMoments1;
+		std::unique_ptr<RenderImage> rtDirectLightMoments0;
+		std::unique_ptr<RenderImage> rtDirectLightMoments1;
+
+		std::unique_ptr<Buffer> adaptiveTileBuffer_;
+		std::unique_ptr<DeviceMemory> adaptiveTileBufferMemory_;
+		std::unique_ptr<Buffer> directLightTileBuffer_;
+		std::unique_ptr<DeviceMemory> directLightTileBufferMemory_;
 	};
 
 }
@@ -0,0 +1,231 @@
+#include "MemoryTracker.hpp"
+#include "Device.hpp"
+#include "Utilities/Console.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+#include <fmt/format.h>
+
+namespace Vulkan
+{
+	namespace
+	{
+		thread_local EMemoryCategory CurrentCategory = EMemoryCategory::Other;
+		thread_local const char* CurrentOwner = nullptr;
+
+		struct HeapTotals
+		{
+			std::array<VkDeviceSize, MemoryTracker::CategoryCount> Categories{};
+			VkDeviceSize Tracked{};
+			VkDeviceSize Peak{};
+			uint32_t Allocations{};
+		};
+
+		struct TrackerState
+		{
+			std::mutex Mutex;
+			std::array<HeapTotals, VK_MAX_MEMORY_HEAPS> Heaps{};
+			VkDeviceSize DeviceLocal{};
+			VkDeviceSize DeviceLocalPeak{};
+			// owners are never removed, their ids stay valid for the allocations that refer to them
+			std::vector<MemoryTracker::OwnerUsage> Owners;
+			std::unordered_map<std::string, uint32_t> OwnerIds;
+		};
+
+		TrackerState& State()
+		{
+			static TrackerState state;
+			return state;
+		}
+
+		float ToMB(VkDeviceSize bytes)
+		{
+			return static_cast<float>(bytes) / (1024.0f * 1024.0f);
+		}
+	}
+
+	const char* MemoryCategoryName(const EMemoryCategory category)
+	{
+		switch (category)
+		{
+		case EMemoryCategory::Geometry: return "geometry";
+		case EMemoryCategory::AccelerationStructure: return "acceleration structures";
+		case EMemoryCategory::Texture: return "textures";
+		case EMemoryCategory::RenderTarget: return "render targets";
+		case EMemoryCategory::Uniform: return "uniforms";
+		case EMemoryCategory::Staging: return "staging";
+		default: return "other";
+		}
+	}
+
+	MemoryScope::MemoryScope(const EMemoryCategory category, const char* owner) :
+		prevCategory_(CurrentCategory),
+		prevOwner_(CurrentOwner)
+	{
+		CurrentCategory = category;
+		if (owner != nullptr)
+		{
+			CurrentOwner = owner;
+		}
+	}
+
+	MemoryScope::MemoryScope(const char* owner) :
+		MemoryScope(CurrentCategory, owner)
+	{
+	}
+
+	MemoryScope::~MemoryScope()
+	{
+		CurrentCategory = prevCategory_;
+		CurrentOwner = prevOwner_;
+	}
+
+	MemoryTracker::Allocation MemoryTracker::Track(const VkPhysicalDeviceMemoryProperties& properties, const uint32_t memoryTypeIndex, const VkDeviceSize size)
+	{
+		const auto& type = properties.memoryTypes[memoryTypeIndex];
+
+		Allocation allocation{};
+		allocation.Heap = type.heapIndex;
+		allocation.Size = size;
+		allocation.DeviceLocal = (properties.memoryHeaps[type.heapIndex].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+		allocation.Category = CurrentCategory;
+		if (allocation.Category == EMemoryCategory::Other && CurrentOwner == nullptr && (type.propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+		{
+			allocation.Category = EMemoryCategory::Staging;
+		}
+
+		const std::string owner = CurrentOwner != nullptr ? CurrentOwner : "untagged";
+		const std::string key = owner + '/' + MemoryCategoryName(allocation.Category);
+
+		auto& state = State();
+		std::lock_guard<std::mutex> lock(state.Mutex);
+
+		const auto id = state.OwnerIds.find(key);
+		if (id == state.OwnerIds.end())
+		{
+			allocation.Owner = static_cast<uint32_t>(state.Owners.size());
+			state.OwnerIds.emplace(key, allocation.Owner);
+			state.Owners.push_back({owner, allocation.Category, 0, 0});
+		}
+		else
+		{
+			allocation.Owner = id->second;
+		}
+
+		auto& ownerUsage = state.Owners[allocation.Owner];
+		ownerUsage.Bytes += size;
+		ownerUsage.Allocations++;
+
+		auto& heap = state.Heaps[allocation.Heap];
+		heap.Categories[static_cast<uint32_t>(allocation.Category)] += size;
+		heap.Tracked += size;
+		heap.Peak = std::max(heap.Peak, heap.Tracked);
+		heap.Allocations++;
+
+		if (allocation.DeviceLocal)
+		{
+			state.DeviceLocal += size;
+			state.DeviceLocalPeak = std::max(state.DeviceLocalPeak, state.DeviceLocal);
+		}
+
+		return allocation;
+	}
+
+	void MemoryTracker::Untrack(const Allocation& allocation)
+	{
+		auto& state = State();
+		std::lock_guard<std::mutex> lock(state.Mutex);
+
+		auto& ownerUsage = state.Owners[allocation.Owner];
+		ownerUsage.Bytes -= allocation.Size;
+		ownerUsage.Allocations--;
+
+		auto& heap = state.Heaps[allocation.Heap];
+		heap.Categories[static_cast<uint32_t>(allocation.Category)] -= allocation.Size;
+		heap.Tracked -= allocation.Size;
+		heap.Allocations--;
+
+		if (allocation.DeviceLocal)
+		{
+			state.DeviceLocal -= allocation.Size;
+		}
+	}
+
+	std::vector<MemoryTracker::HeapUsage> MemoryTracker::Heaps(const Device& device)
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {};
+		budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+		VkPhysicalDeviceMemoryProperties2 properties = {};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		properties.pNext = device.MemoryBudgetSupported() ? &budget : nullptr;
+		vkGetPhysicalDeviceMemoryProperties2(device.PhysicalDevice(), &properties);
+
+		const auto& memory = properties.memoryProperties;
+		std::vector<HeapUsage> heaps(memory.memoryHeapCount);
+
+		auto& state = State();
+		std::lock_guard<std::mutex> lock(state.Mutex);
+
+		for (uint32_t i = 0; i != memory.memoryHeapCount; ++i)
+		{
+			const auto& totals = state.Heaps[i];
+			auto& heap = heaps[i];
+			heap.Index = i;
+			heap.DeviceLocal = (memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+			heap.Size = memory.memoryHeaps[i].size;
+			heap.Budget = device.MemoryBudgetSupported() ? budget.heapBudget[i] : heap.Size;
+			heap.Usage = device.MemoryBudgetSupported() ? budget.heapUsage[i] : totals.Tracked;
+			heap.Tracked = totals.Tracked;
+			heap.Peak = totals.Peak;
+			heap.Allocations = totals.Allocations;
+			heap.Categories = totals.Categories;
+		}
+
+		return heaps;
+	}
+
+	std::vector<MemoryTracker::OwnerUsage> MemoryTracker::Owners()
+	{
+		std::vector<OwnerUsage> owners;
+		{
+			auto& state = State();
+			std::lock_guard<std::mutex> lock(state.Mutex);
+			std::copy_if(state.Owners.begin(), state.Owners.end(), std::back_inserter(owners), [](const OwnerUsage& owner) { return owner.Allocations > 0; });
+		}
+
+		std::sort(owners.begin(), owners.end(), [](const OwnerUsage& a, const OwnerUsage& b) { return a.Bytes > b.Bytes; });
+		return owners;
+	}
+
+	VkDeviceSize MemoryTracker::DeviceLocalPeak()
+	{
+		auto& state = State();
+		std::lock_guard<std::mutex> lock(state.Mutex);
+		return state.DeviceLocalPeak;
+	}
+
+	void MemoryTracker::Print(const Device& device)
+	{
+		fmt::print("{} device memory{}\n", CONSOLE_GOLD_COLOR, CONSOLE_DEFAULT_COLOR);
+		for (const auto& heap : Heaps(device))
+		{
+			fmt::print("\theap {}{}: {:.1f} MB tracked in {} allocations, {:.1f} / {:.1f} MB used, peak {:.1f} MB\n", heap.Index, heap.DeviceLocal ? " (device local)" : "",
+				ToMB(heap.Tracked), heap.Allocations, ToMB(heap.Usage), ToMB(heap.Budget), ToMB(heap.Peak));
+			for (uint32_t i = 0; i != CategoryCount; ++i)
+			{
+				if (heap.Categories[i] > 0)
+				{
+					fmt::print("\t\t{}: {:.1f} MB\n", MemoryCategoryName(static_cast<EMemoryCategory>(i)), ToMB(heap.Categories[i]));
+				}
+			}
+		}
+		for (const auto& owner : Owners())
+		{
+			fmt::print("\t{} ({}): {:.1f} MB in {} allocations\n", owner.Name, MemoryCategoryName(owner.Category), ToMB(owner.Bytes), owner.Allocations);
+		}
+	}
+
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Vulkan.hpp"
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace Vulkan
+{
+	class Device;
+
+	enum class EMemoryCategory : uint32_t
+	{
+		Other,
+		Geometry,
+		AccelerationStructure,
+		Texture,
+		RenderTarget,
+		Uniform,
+		Staging,
+		Count
+	};
+
+	const char* MemoryCategoryName(EMemoryCategory category);
+
+	// Tags every DeviceMemory allocated on this thread while it lives. Scopes nest, the innermost one wins;
+	// a null owner keeps the enclosing owner, so a generic helper can refine the category without losing it.
+	class MemoryScope final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(MemoryScope)
+
+		MemoryScope(EMemoryCategory category, const char* owner);
+		// keeps the enclosing category
+		explicit MemoryScope(const char* owner);
+		~MemoryScope();
+
+	private:
+
+		const EMemoryCategory prevCategory_;
+		const char* const prevOwner_;
+	};
+
+	// Live totals of every DeviceMemory per heap, category and owner. Untagged host visible memory counts as
+	// staging, anything else untagged as other. Budget and usage come from VK_EXT_memory_budget when the device
+	// enabled it, they also cover memory the driver allocates on its own; without it the budget is the heap size.
+	class MemoryTracker final
+	{
+	public:
+
+		static constexpr uint32_t CategoryCount = static_cast<uint32_t>(EMemoryCategory::Count);
+
+		struct Allocation
+		{
+			uint32_t Heap;
+			uint32_t Owner;
+			VkDeviceSize Size;
+			EMemoryCategory Category;
+			bool DeviceLocal;
+		};
+
+		struct HeapUsage
+		{
+			uint32_t Index;
+			bool DeviceLocal;
+			VkDeviceSize Size;
+			VkDeviceSize Budget;
+			VkDeviceSize Usage;
+			VkDeviceSize Tracked;
+			VkDeviceSize Peak;
+			uint32_t Allocations;
+			std::array<VkDeviceSize, CategoryCount> Categories;
+		};
+
+		struct OwnerUsage
+		{
+			std::string Name;
+			EMemoryCategory Category;
+			VkDeviceSize Bytes;
+			uint32_t Allocations;
+		};
+
+		static Allocation Track(const VkPhysicalDeviceMemoryProperties& properties, uint32_t memoryTypeIndex, VkDeviceSize size);
+		static void Untrack(const Allocation& allocation);
+
+		static std::vector<HeapUsage> Heaps(const Device& device);
+		// live owners, largest first
+		static std::vector<OwnerUsage> Owners();
+		// highest total of device local heaps since start
+		static VkDeviceSize DeviceLocalPeak();
+
+		// printed when an allocation fails, so the report names the subsystem that grew
+		static void Print(const Device& device);
+	};
+
+}
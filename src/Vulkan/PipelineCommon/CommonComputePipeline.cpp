@@ -22,6 +22,9 @@ namespace Vulkan::PipelineCommon
                                            const ImageView& visibilityBufferImageView,
                                            const ImageView& prevVisibilityBufferImageView,
                                            const ImageView& outputImage1View,
+                                           const ImageView& momentsImageView,
+                                           const ImageView& prevMomentsImageView,
+                                           const Buffer& adaptiveTileBuffer,
                                            const std::vector<Assets::UniformBuffer>& uniformBuffers,
                                            const Assets::Scene& scene): swapChain_(swapChain)
     {
@@ -37,6 +40,9 @@ namespace Vulkan::PipelineCommon
             {5, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
             {6, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
             {7, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+            {8, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+            {9, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+            {10, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
         };
 
         descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, uniformBuffers.size()));
@@ -52,10 +58,16 @@ namespace Vulkan::PipelineCommon
             VkDescriptorImageInfo Info5 = {NULL, visibilityBufferImageView.Handle(), VK_IMAGE_LAYOUT_GENERAL};
             VkDescriptorImageInfo Info6 = {NULL, prevVisibilityBufferImageView.Handle(), VK_IMAGE_LAYOUT_GENERAL};
             VkDescriptorImageInfo Info7 = {NULL, outputImage1View.Handle(), VK_IMAGE_LAYOUT_GENERAL};
+            VkDescriptorImageInfo Info8 = {NULL, momentsImageView.Handle(), VK_IMAGE_LAYOUT_GENERAL};
+            VkDescriptorImageInfo Info9 = {NULL, prevMomentsImageView.Handle(), VK_IMAGE_LAYOUT_GENERAL};
             // Uniform buffer
             VkDescriptorBufferInfo uniformBufferInfo = {};
             uniformBufferInfo.buffer = uniformBuffers[i].Buffer().Handle();
             uniformBufferInfo.range = VK_WHOLE_SIZE;
+            // Adaptive sampling tiles
+            VkDescriptorBufferInfo adaptiveTileBufferInfo = {};
+            adaptiveTileBufferInfo.buffer = adaptiveTileBuffer.Handle();
+            adaptiveTileBufferInfo.range = VK_WHOLE_SIZE;
 
             std::vector<VkWriteDescriptorSet> descriptorWrites =
             {
@@ -67,6 +79,9 @@ namespace Vulkan::PipelineCommon
                 descriptorSets.Bind(i, 5, Info5),
                 descriptorSets.Bind(i, 6, Info6),
                 descriptorSets.Bind(i, 7, Info7),
+                descriptorSets.Bind(i, 8, Info8),
+                descriptorSets.Bind(i, 9, Info9),
+                descriptorSets.Bind(i, 10, adaptiveTileBufferInfo),
             };
 
             descriptorSets.UpdateDescriptors(i, descriptorWrites);
@@ -184,6 +199,172 @@ namespace Vulkan::PipelineCommon
         return descriptorSetManager_->DescriptorSets().Handle(index);
     }
 
+    SvgfVariancePipeline::SvgfVariancePipeline(const SwapChain& swapChain,
+                                               const ImageView& sourceImageView,
+                                               const ImageView& albedoBufferImageView,
+                                               const ImageView& normalBufferImageView,
+                                               const ImageView& momentsImageView,
+                                               const ImageView& prevMomentsImageView,
+                                               const ImageView& outputImageView,
+                                               const std::vector<Assets::UniformBuffer>& uniformBuffers): swapChain_(swapChain)
+    {
+        // Create descriptor pool/sets.
+        const auto& device = swapChain.Device();
+        const std::vector<DescriptorBinding> descriptorBindings =
+        {
+            {0, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+            {1, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+            {2, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+            {3, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+            {4, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+            {5, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+            {6, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+        };
+
+        descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, swapChain.ImageViews().size()));
+
+        auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+        for (uint32_t i = 0; i != swapChain.Images().size(); ++i)
+        {
+            VkDescriptorImageInfo Info0 = {NULL, sourceImageView.Handle(), VK_IMAGE_LAYOUT_GENERAL};
+            VkDescriptorImageInfo Info1 = {NULL, albedoBufferImageView.Handle(), VK_IMAGE_LAYOUT_GENERAL};
+            VkDescriptorImageInfo Info2 = {NULL, normalBufferImageView.Handle(), VK_IMAGE_LAYOUT_GENERAL};
+            VkDescriptorImageInfo Info3 = {NULL, momentsImageView.Handle(), VK_IMAGE_LAYOUT_GENERAL};
+            VkDescriptorImageInfo Info4 = {NULL, prevMomentsImageView.Handle(), VK_IMAGE_LAYOUT_GENERAL};
+            VkDescriptorImageInfo Info5 = {NULL, outputImageView.Handle(), VK_IMAGE_LAYOUT_GENERAL};
+            VkDescriptorBufferInfo uniformBufferInfo = {};
+            uniformBufferInfo.buffer = uniformBuffers[i].Buffer().Handle();
+            uniformBufferInfo.range = VK_WHOLE_SIZE;
+            std::vector<VkWriteDescriptorSet> descriptorWrites =
+            {
+                descriptorSets.Bind(i, 0, Info0),
+                descriptorSets.Bind(i, 1, Info1),
+                descriptorSets.Bind(i, 2, Info2),
+                descriptorSets.Bind(i, 3, Info3),
+                descriptorSets.Bind(i, 4, Info4),
+                descriptorSets.Bind(i, 5, Info5),
+                descriptorSets.Bind(i, 6, uniformBufferInfo),
+            };
+
+            descriptorSets.UpdateDescriptors(i, descriptorWrites);
+        }
+
+        pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout()));
+        const ShaderModule varianceShader(device, Utilities::FileHelper::GetPlatformFilePath("assets/shaders/SvgfVariance.comp.spv"));
+
+        VkComputePipelineCreateInfo pipelineCreateInfo = {};
+        pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineCreateInfo.stage = varianceShader.CreateShaderStage(VK_SHADER_STAGE_COMPUTE_BIT);
+        pipelineCreateInfo.layout = pipelineLayout_->Handle();
+
+        Check(vkCreateComputePipelines(device.Handle(), VK_NULL_HANDLE,
+                                       1, &pipelineCreateInfo,
+                                       NULL, &pipeline_),
+              "create svgf variance pipeline");
+    }
+
+    SvgfVariancePipeline::~SvgfVariancePipeline()
+    {
+        if (pipeline_ != nullptr)
+        {
+            vkDestroyPipeline(swapChain_.Device().Handle(), pipeline_, nullptr);
+            pipeline_ = nullptr;
+        }
+
+        pipelineLayout_.reset();
+        descriptorSetManager_.reset();
+    }
+
+    VkDescriptorSet SvgfVariancePipeline::DescriptorSet(uint32_t index) const
+    {
+        return descriptorSetManager_->DescriptorSets().Handle(index);
+    }
+
+    SvgfAtrousPipeline::SvgfAtrousPipeline(const SwapChain& swapChain,
+                                           const ImageView& pingImageView,
+                                           const ImageView& pongImageView,
+                                           const ImageView& albedoBufferImageView,
+                                           const ImageView& normalBufferImageView,
+                                           const ImageView& outputImageView,
+                                           const std::vector<Assets::UniformBuffer>& uniformBuffers): swapChain_(swapChain)
+    {
+        // Create descriptor pool/sets.
+        const auto& device = swapChain.Device();
+        const std::vector<DescriptorBinding> descriptorBindings =
+        {
+            {0, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+            {1, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+            {2, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+            {3, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+            {4, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+            {5, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+        };
+
+        descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, swapChain.ImageViews().size()));
+
+        auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+        for (uint32_t i = 0; i != swapChain.Images().size(); ++i)
+        {
+            VkDescriptorImageInfo Info0 = {NULL, pingImageView.Handle(), VK_IMAGE_LAYOUT_GENERAL};
+            VkDescriptorImageInfo Info1 = {NULL, pongImageView.Handle(), VK_IMAGE_LAYOUT_GENERAL};
+            VkDescriptorImageInfo Info2 = {NULL, albedoBufferImageView.Handle(), VK_IMAGE_LAYOUT_GENERAL};
+            VkDescriptorImageInfo Info3 = {NULL, normalBufferImageView.Handle(), VK_IMAGE_LAYOUT_GENERAL};
+            VkDescriptorImageInfo Info4 = {NULL, outputImageView.Handle(), VK_IMAGE_LAYOUT_GENERAL};
+            VkDescriptorBufferInfo uniformBufferInfo = {};
+            uniformBufferInfo.buffer = uniformBuffers[i].Buffer().Handle();
+            uniformBufferInfo.range = VK_WHOLE_SIZE;
+            std::vector<VkWriteDescriptorSet> descriptorWrites =
+            {
+                descriptorSets.Bind(i, 0, Info0),
+                descriptorSets.Bind(i, 1, Info1),
+                descriptorSets.Bind(i, 2, Info2),
+                descriptorSets.Bind(i, 3, Info3),
+                descriptorSets.Bind(i, 4, Info4),
+                descriptorSets.Bind(i, 5, uniformBufferInfo),
+            };
+
+            descriptorSets.UpdateDescriptors(i, descriptorWrites);
+        }
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = 2 * sizeof(uint32_t);
+
+        pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout(),
+                                                       &pushConstantRange, 1));
+        const ShaderModule atrousShader(device, Utilities::FileHelper::GetPlatformFilePath("assets/shaders/SvgfAtrous.comp.spv"));
+
+        VkComputePipelineCreateInfo pipelineCreateInfo = {};
+        pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineCreateInfo.stage = atrousShader.CreateShaderStage(VK_SHADER_STAGE_COMPUTE_BIT);
+        pipelineCreateInfo.layout = pipelineLayout_->Handle();
+
+        Check(vkCreateComputePipelines(device.Handle(), VK_NULL_HANDLE,
+                                       1, &pipelineCreateInfo,
+                                       NULL, &pipeline_),
+              "create svgf atrous pipeline");
+    }
+
+    SvgfAtrousPipeline::~SvgfAtrousPipeline()
+    {
+        if (pipeline_ != nullptr)
+        {
+            vkDestroyPipeline(swapChain_.Device().Handle(), pipeline_, nullptr);
+            pipeline_ = nullptr;
+        }
+
+        pipelineLayout_.reset();
+        descriptorSetManager_.reset();
+    }
+
+    VkDescriptorSet SvgfAtrousPipeline::DescriptorSet(uint32_t index) const
+    {
+        return descriptorSetManager_->DescriptorSets().Handle(index);
+    }
+
     BufferClearPipeline::BufferClearPipeline(const SwapChain& swapChain):swapChain_(swapChain)
     {
         // Create descriptor pool/sets.
@@ -239,6 +420,63 @@ namespace Vulkan::PipelineCommon
         return descriptorSetManager_->DescriptorSets().Handle(index);
     }
 
+    RadianceCacheResolvePipeline::RadianceCacheResolvePipeline(const SwapChain& swapChain, const Buffer& radianceCacheBuffer):swapChain_(swapChain)
+    {
+        // Create descriptor pool/sets.
+        const auto& device = swapChain.Device();
+        const std::vector<DescriptorBinding> descriptorBindings =
+        {
+            {0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+        };
+
+        descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, swapChain.ImageViews().size()));
+
+        auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+        for (uint32_t i = 0; i != swapChain.Images().size(); ++i)
+        {
+            VkDescriptorBufferInfo radianceCacheBufferInfo = {};
+            radianceCacheBufferInfo.buffer = radianceCacheBuffer.Handle();
+            radianceCacheBufferInfo.range = VK_WHOLE_SIZE;
+
+            std::vector<VkWriteDescriptorSet> descriptorWrites =
+            {
+                descriptorSets.Bind(i, 0, radianceCacheBufferInfo),
+            };
+            descriptorSets.UpdateDescriptors(i, descriptorWrites);
+        }
+
+        pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout()));
+        const ShaderModule resolveShader(device, Utilities::FileHelper::GetPlatformFilePath("assets/shaders/RadianceCacheResolve.comp.spv"));
+
+        VkComputePipelineCreateInfo pipelineCreateInfo = {};
+        pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineCreateInfo.stage = resolveShader.CreateShaderStage(VK_SHADER_STAGE_COMPUTE_BIT);
+        pipelineCreateInfo.layout = pipelineLayout_->Handle();
+
+        Check(vkCreateComputePipelines(device.Handle(), VK_NULL_HANDLE,
+                                       1, &pipelineCreateInfo,
+                                       NULL, &pipeline_),
+              "create radiance cache resolve pipeline");
+    }
+
+    RadianceCacheResolvePipeline::~RadianceCacheResolvePipeline()
+    {
+        if (pipeline_ != nullptr)
+        {
+            vkDestroyPipeline(swapChain_.Device().Handle(), pipeline_, nullptr);
+            pipeline_ = nullptr;
+        }
+
+        pipelineLayout_.reset();
+        descriptorSetManager_.reset();
+    }
+
+    VkDescriptorSet RadianceCacheResolvePipeline::DescriptorSet(uint32_t index) const
+    {
+        return descriptorSetManager_->DescriptorSets().Handle(index);
+    }
+
     VisualDebuggerPipeline::VisualDebuggerPipeline(const SwapChain& swapChain, const ImageView& debugImage1View, const ImageView& debugImage2View,
                                                    const ImageView& debugImage3View, const ImageView& debugImage4View, const std::vector<Assets::UniformBuffer>& uniformBuffers): swapChain_(swapChain)
     {
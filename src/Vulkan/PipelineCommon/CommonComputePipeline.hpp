@@ -40,6 +40,8 @@ namespace Vulkan::PipelineCommon
 			const ImageView& sourceImageView, const ImageView& accumulateImageView, const ImageView& prevAccumulateImageView, const ImageView& motionVectorImageView,
 			const ImageView& visibilityBufferImageView,const ImageView& prevVisibilityBufferImageView,
 			const ImageView& outputImage1View,
+			const ImageView& momentsImageView, const ImageView& prevMomentsImageView,
+			const Buffer& adaptiveTileBuffer,
 			const std::vector<Assets::UniformBuffer>& uniformBuffers,
 			const Assets::Scene& scene);
 		~AccumulatePipeline();
@@ -81,6 +83,58 @@ namespace Vulkan::PipelineCommon
 		std::unique_ptr<Vulkan::PipelineLayout> pipelineLayout_;
 	};
 
+	class SvgfVariancePipeline final
+	{
+	public:
+		VULKAN_NON_COPIABLE(SvgfVariancePipeline)
+	
+		SvgfVariancePipeline(
+			const SwapChain& swapChain, 
+			const ImageView& sourceImageView,
+			const ImageView& albedoBufferImageView,
+			const ImageView& normalBufferImageView,
+			const ImageView& momentsImageView, const ImageView& prevMomentsImageView,
+			const ImageView& outputImageView,
+			const std::vector<Assets::UniformBuffer>& uniformBuffers);
+		~SvgfVariancePipeline();
+
+		VkDescriptorSet DescriptorSet(uint32_t index) const;
+		const Vulkan::PipelineLayout& PipelineLayout() const { return *pipelineLayout_; }
+	private:
+		const SwapChain& swapChain_;
+		
+		VULKAN_HANDLE(VkPipeline, pipeline_)
+
+		std::unique_ptr<Vulkan::DescriptorSetManager> descriptorSetManager_;
+		std::unique_ptr<Vulkan::PipelineLayout> pipelineLayout_;
+	};
+
+	// one pipeline for every a-trous iteration, the iteration and their count go in as push constants
+	class SvgfAtrousPipeline final
+	{
+	public:
+		VULKAN_NON_COPIABLE(SvgfAtrousPipeline)
+	
+		SvgfAtrousPipeline(
+			const SwapChain& swapChain, 
+			const ImageView& pingImageView, const ImageView& pongImageView,
+			const ImageView& albedoBufferImageView,
+			const ImageView& normalBufferImageView,
+			const ImageView& outputImageView,
+			const std::vector<Assets::UniformBuffer>& uniformBuffers);
+		~SvgfAtrousPipeline();
+
+		VkDescriptorSet DescriptorSet(uint32_t index) const;
+		const Vulkan::PipelineLayout& PipelineLayout() const { return *pipelineLayout_; }
+	private:
+		const SwapChain& swapChain_;
+		
+		VULKAN_HANDLE(VkPipeline, pipeline_)
+
+		std::unique_ptr<Vulkan::DescriptorSetManager> descriptorSetManager_;
+		std::unique_ptr<Vulkan::PipelineLayout> pipelineLayout_;
+	};
+
 	class BufferClearPipeline final
 	{
 	public:
@@ -101,6 +155,27 @@ namespace Vulkan::PipelineCommon
 		std::unique_ptr<Vulkan::PipelineLayout> pipelineLayout_;
 	};
 
+	class RadianceCacheResolvePipeline final
+	{
+	public:
+		VULKAN_NON_COPIABLE(RadianceCacheResolvePipeline)
+	
+		RadianceCacheResolvePipeline(
+			const SwapChain& swapChain,
+			const Buffer& radianceCacheBuffer);
+		~RadianceCacheResolvePipeline();
+
+		VkDescriptorSet DescriptorSet(uint32_t index) const;
+		const Vulkan::PipelineLayout& PipelineLayout() const { return *pipelineLayout_; }
+	private:
+		const SwapChain& swapChain_;
+		
+		VULKAN_HANDLE(VkPipeline, pipeline_)
+
+		std::unique_ptr<Vulkan::DescriptorSetManager> descriptorSetManager_;
+		std::unique_ptr<Vulkan::PipelineLayout> pipelineLayout_;
+	};
+
 	class VisualDebuggerPipeline final
 	{
 	public:
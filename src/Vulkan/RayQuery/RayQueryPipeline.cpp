@@ -5,6 +5,7 @@
 #include "Vulkan/RayTracing/DeviceProcedures.hpp"
 #include "Vulkan/RayTracing/TopLevelAccelerationStructure.hpp"
 #include "Assets/Scene.hpp"
+#include "Assets/Texture.hpp"
 #include "Assets/UniformBuffer.hpp"
 #include "Utilities/Exception.hpp"
 #include "Vulkan/Buffer.hpp"
@@ -30,7 +31,8 @@ namespace Vulkan::RayTracing
         const ImageView& AdaptiveSampleImageView,
         const ImageView& OutShaderTimerImageView,
         
-        const std::vector<Assets::UniformBuffer>& uniformBuffers, const Assets::Scene& scene):swapChain_(swapChain)
+        const std::vector<Assets::UniformBuffer>& uniformBuffers,
+        const std::vector<Assets::RayStatisticsBuffer>& rayStatisticsBuffers, const Buffer& samplerTableBuffer, const Buffer& adaptiveTileBuffer, const Buffer& radianceCacheBuffer, const Assets::Scene& scene):swapChain_(swapChain)
     {
          // Create descriptor pool/sets.
         const auto& device = swapChain.Device();
@@ -38,8 +40,9 @@ namespace Vulkan::RayTracing
         {
             // Top level acceleration structure.
             {0, 1, VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, VK_SHADER_STAGE_COMPUTE_BIT},
-            // Light buffer
+            // Light buffer, light alias table
             {1, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+            {2, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
             // Camera information & co
             {3, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
 
@@ -49,6 +52,10 @@ namespace Vulkan::RayTracing
             {6, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
             {7, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
 
+            // Light bvh, hdri importance tables
+            {8, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+            {9, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+
             {10, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
             {11, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
             {12, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
@@ -60,6 +67,16 @@ namespace Vulkan::RayTracing
             {16, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
 
                 {17, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+
+            // Ray statistics
+            {18, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+
+            // Sobol matrices and ranking tile
+            {19, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+
+            // Adaptive sampling tile errors
+            {20, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+            {21, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
         };
 
         descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, uniformBuffers.size()));
@@ -106,6 +123,21 @@ namespace Vulkan::RayTracing
             lightBufferInfo.buffer = scene.LightBuffer().Handle();
             lightBufferInfo.range = VK_WHOLE_SIZE;
 
+            // Light alias table
+            VkDescriptorBufferInfo lightAliasBufferInfo = {};
+            lightAliasBufferInfo.buffer = scene.LightAliasBuffer().Handle();
+            lightAliasBufferInfo.range = VK_WHOLE_SIZE;
+
+            // Light bvh
+            VkDescriptorBufferInfo lightTreeBufferInfo = {};
+            lightTreeBufferInfo.buffer = scene.LightTreeBuffer().Handle();
+            lightTreeBufferInfo.range = VK_WHOLE_SIZE;
+
+            // Hdri importance tables
+            VkDescriptorBufferInfo environmentTableBufferInfo = {};
+            environmentTableBufferInfo.buffer = Assets::GlobalTexturePool::GetInstance()->EnvironmentTableBuffer().Handle();
+            environmentTableBufferInfo.range = VK_WHOLE_SIZE;
+
             // Accumulation image
             VkDescriptorImageInfo accumulationImageInfo = {};
             accumulationImageInfo.imageView = accumulationImageView.Handle();
@@ -139,16 +171,38 @@ namespace Vulkan::RayTracing
             VkDescriptorImageInfo outShaderTimerImageInfo = {};
             outShaderTimerImageInfo.imageView = OutShaderTimerImageView.Handle();
             outShaderTimerImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+            // Ray statistics buffer
+            VkDescriptorBufferInfo rayStatisticsBufferInfo = {};
+            rayStatisticsBufferInfo.buffer = rayStatisticsBuffers[i].Buffer().Handle();
+            rayStatisticsBufferInfo.range = VK_WHOLE_SIZE;
+
+            // Sampler tables
+            VkDescriptorBufferInfo samplerTableBufferInfo = {};
+            samplerTableBufferInfo.buffer = samplerTableBuffer.Handle();
+            samplerTableBufferInfo.range = VK_WHOLE_SIZE;
+
+            // Adaptive sampling tiles
+            VkDescriptorBufferInfo adaptiveTileBufferInfo = {};
+            adaptiveTileBufferInfo.buffer = adaptiveTileBuffer.Handle();
+            adaptiveTileBufferInfo.range = VK_WHOLE_SIZE;
+
+            VkDescriptorBufferInfo radianceCacheBufferInfo = {};
+            radianceCacheBufferInfo.buffer = radianceCacheBuffer.Handle();
+            radianceCacheBufferInfo.range = VK_WHOLE_SIZE;
             
             std::vector<VkWriteDescriptorSet> descriptorWrites =
             {
                 descriptorSets.Bind(i, 0, structureInfo),
                 descriptorSets.Bind(i, 1, lightBufferInfo),
+                descriptorSets.Bind(i, 2, lightAliasBufferInfo),
                 descriptorSets.Bind(i, 3, uniformBufferInfo),
                 descriptorSets.Bind(i, 4, vertexBufferInfo),
                 descriptorSets.Bind(i, 5, indexBufferInfo),
                 descriptorSets.Bind(i, 6, materialBufferInfo),
                 descriptorSets.Bind(i, 7, offsetsBufferInfo),
+                descriptorSets.Bind(i, 8, lightTreeBufferInfo),
+                descriptorSets.Bind(i, 9, environmentTableBufferInfo),
                 descriptorSets.Bind(i, 10, accumulationImageInfo),
                 descriptorSets.Bind(i, 11, motionVectorImageInfo),
                 descriptorSets.Bind(i, 12, visibilityBufferImageInfo),
@@ -157,6 +211,10 @@ namespace Vulkan::RayTracing
                 descriptorSets.Bind(i, 15, outNormalImageInfo),
                 descriptorSets.Bind(i, 16, adaptiveSampleImageInfo),
                 descriptorSets.Bind(i, 17, outShaderTimerImageInfo),
+                descriptorSets.Bind(i, 18, rayStatisticsBufferInfo),
+                descriptorSets.Bind(i, 19, samplerTableBufferInfo),
+                descriptorSets.Bind(i, 20, adaptiveTileBufferInfo),
+                descriptorSets.Bind(i, 21, radianceCacheBufferInfo),
             };
 
             descriptorSets.UpdateDescriptors(i, descriptorWrites);
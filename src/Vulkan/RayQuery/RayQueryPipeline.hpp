@@ -8,10 +8,12 @@ namespace Assets
 {
 	class Scene;
 	class UniformBuffer;
+	class RayStatisticsBuffer;
 }
 
 namespace Vulkan
 {
+	class Buffer;
 	class DescriptorSetManager;
 	class ImageView;
 	class PipelineLayout;
@@ -43,6 +45,10 @@ namespace Vulkan::RayTracing
 			const ImageView& AdaptiveSampleImageView,
 			const ImageView& OutShaderTimerImageView,
 			const std::vector<Assets::UniformBuffer>& uniformBuffers,
+			const std::vector<Assets::RayStatisticsBuffer>& rayStatisticsBuffers,
+			const Buffer& samplerTableBuffer,
+			const Buffer& adaptiveTileBuffer,
+			const Buffer& radianceCacheBuffer,
 			const Assets::Scene& scene);
 		~RayQueryPipeline();
 
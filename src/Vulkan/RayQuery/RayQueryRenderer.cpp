@@ -1,13 +1,17 @@
 #include "RayQueryRenderer.hpp"
 #include "Vulkan/RayTracing/DeviceProcedures.hpp"
+#include "Assets/RadianceCache.hpp"
 #include "Assets/Scene.hpp"
+#include "Assets/SobolSampler.hpp"
 #include "Utilities/Glm.hpp"
 #include "Vulkan/BufferUtil.hpp"
 #include "Vulkan/Image.hpp"
 #include "Vulkan/ImageMemoryBarrier.hpp"
+#include "Vulkan/MemoryTracker.hpp"
 #include "Vulkan/PipelineLayout.hpp"
 #include "Vulkan/SingleTimeCommands.hpp"
 #include "Vulkan/SwapChain.hpp"
+#include <algorithm>
 #include <chrono>
 #include <numeric>
 
@@ -27,6 +31,8 @@ namespace Vulkan::RayTracing
     RayQueryRenderer::~RayQueryRenderer()
     {
         RayQueryRenderer::DeleteSwapChain();
+        radianceCacheBuffer_.reset();
+        radianceCacheBufferMemory_.reset();
     }
 
     void RayQueryRenderer::SetPhysicalDeviceImpl(
@@ -71,10 +77,32 @@ namespace Vulkan::RayTracing
     void RayQueryRenderer::CreateSwapChain()
     {
         CreateOutputImage();
-        rayTracingPipeline_.reset(new RayQueryPipeline(Device().GetDeviceProcedures(), SwapChain(), TLAS()[0], rtAccumulation_->GetImageView(), rtMotionVector_->GetImageView(),
-                                                         rtVisibility0_->GetImageView(), rtVisibility1_->GetImageView(),
-                                                         rtAlbedo_->GetImageView(), rtNormal_->GetImageView(),
-                                                         rtAdaptiveSample_->GetImageView(), rtShaderTimer_->GetImageView(), UniformBuffers(), GetScene()));
+        if (!samplerTableBuffer_)
+        {
+            MemoryScope memoryScope(EMemoryCategory::Other, "sampler tables");
+            BufferUtil::CreateDeviceBuffer(CommandPool(), "SamplerTables", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, Assets::SobolSampler::BuildTables(),
+                                           samplerTableBuffer_, samplerTableBufferMemory_);
+        }
+        {
+            MemoryScope memoryScope(EMemoryCategory::RenderTarget, "adaptive tiles");
+            const uint32_t tiles = Utilities::Math::GetSafeDispatchCount(SwapChain().Extent().width, ADAPTIVE_TILE_WIDTH) *
+                                   Utilities::Math::GetSafeDispatchCount(SwapChain().Extent().height, ADAPTIVE_TILE_HEIGHT);
+            BufferUtil::CreateDeviceBuffer(CommandPool(), "AdaptiveTiles", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, std::vector<uint32_t>(2 + tiles, 0),
+                                           adaptiveTileBuffer_, adaptiveTileBufferMemory_);
+        }
+        if (!radianceCacheBuffer_ || (RadianceCacheBounce() > 0 && !radianceCacheAllocated_))
+        {
+            CreateRadianceCache();
+        }
+        else
+        {
+            // a new scene or resolution starts without stale cells
+            SingleTimeCommands::Submit(CommandPool(), [this](VkCommandBuffer commandBuffer)
+            {
+                vkCmdFillBuffer(commandBuffer, radianceCacheBuffer_->Handle(), 0, VK_WHOLE_SIZE, 0);
+            });
+        }
+        CreateRayTracingPipelines();
 
         accumulatePipeline_.reset(new PipelineCommon::AccumulatePipeline(SwapChain(),
                                                                         rtAccumulation_->GetImageView(),
@@ -84,11 +112,21 @@ namespace Vulkan::RayTracing
                                                                         rtVisibility0_->GetImageView(),
                                                                         rtVisibility1_->GetImageView(),
                                                                         rtOutput_->GetImageView(),
+                                                                        rtMoments0_->GetImageView(),
+                                                                        rtMoments1_->GetImageView(),
+                                                                        *adaptiveTileBuffer_,
                                                                         UniformBuffers(), GetScene()));
 
+        svgfVariancePipeline_.reset(new PipelineCommon::SvgfVariancePipeline(SwapChain(), rtOutput_->GetImageView(), rtAlbedo_->GetImageView(), rtNormal_->GetImageView(),
+                                                                             rtMoments0_->GetImageView(), rtMoments1_->GetImageView(),
+                                                                             rtSvgfPing_->GetImageView(), UniformBuffers()));
+        svgfAtrousPipeline_.reset(new PipelineCommon::SvgfAtrousPipeline(SwapChain(), rtSvgfPing_->GetImageView(), rtSvgfPong_->GetImageView(),
+                                                                         rtAlbedo_->GetImageView(), rtNormal_->GetImageView(),
+                                                                         rtSvgfOutput_->GetImageView(), UniformBuffers()));
 
         composePipelineNonDenoiser_.reset(new PipelineCommon::FinalComposePipeline(SwapChain(), rtOutput_->GetImageView(), rtAlbedo_->GetImageView(), rtNormal_->GetImageView(), rtVisibility0_->GetImageView(), rtVisibility1_->GetImageView(), UniformBuffers()));
         composePipelineDenoiser_.reset(new PipelineCommon::FinalComposePipeline(SwapChain(), rtDenoise1_->GetImageView(), rtAlbedo_->GetImageView(), rtNormal_->GetImageView(), rtVisibility0_->GetImageView(), rtVisibility1_->GetImageView(), UniformBuffers()));
+        composePipelineSvgf_.reset(new PipelineCommon::FinalComposePipeline(SwapChain(), rtSvgfOutput_->GetImageView(), rtAlbedo_->GetImageView(), rtNormal_->GetImageView(), rtVisibility0_->GetImageView(), rtVisibility1_->GetImageView(), UniformBuffers()));
         
         visualDebugPipeline_.reset(new PipelineCommon::VisualDebuggerPipeline(SwapChain(),
                                                                       rtAlbedo_->GetImageView(), rtNormal_->GetImageView(), rtAdaptiveSample_->GetImageView(), rtShaderTimer_->GetImageView(),
@@ -99,8 +137,12 @@ namespace Vulkan::RayTracing
     {
         rayTracingPipeline_.reset();
         accumulatePipeline_.reset();
+        svgfVariancePipeline_.reset();
+        svgfAtrousPipeline_.reset();
+        radianceCacheResolvePipeline_.reset();
         composePipelineNonDenoiser_.reset();
         composePipelineDenoiser_.reset();
+        composePipelineSvgf_.reset();
         visualDebugPipeline_.reset();
         
         rtAccumulation_.reset();
@@ -116,6 +158,13 @@ namespace Vulkan::RayTracing
         rtShaderTimer_.reset();
 
         rtAdaptiveSample_.reset();
+        rtMoments0_.reset();
+        rtMoments1_.reset();
+        rtSvgfPing_.reset();
+        rtSvgfPong_.reset();
+        rtSvgfOutput_.reset();
+        adaptiveTileBuffer_.reset();
+        adaptiveTileBufferMemory_.reset();
 
         rtDenoise0_.reset();
         rtDenoise1_.reset();
@@ -142,6 +191,44 @@ namespace Vulkan::RayTracing
         rtNormal_->InsertBarrier(commandBuffer, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
         rtShaderTimer_->InsertBarrier(commandBuffer, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
         rtAdaptiveSample_->InsertBarrier(commandBuffer, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+        rtMoments0_->InsertBarrier(commandBuffer, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+        rtMoments1_->InsertBarrier(commandBuffer, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+        rtSvgfPing_->InsertBarrier(commandBuffer, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+        rtSvgfPong_->InsertBarrier(commandBuffer, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+        rtSvgfOutput_->InsertBarrier(commandBuffer, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+        // turned on at runtime while only the placeholder exists, nothing recorded yet binds the pipelines that are rebuilt
+        if (RadianceCacheBounce() > 0 && !radianceCacheAllocated_)
+        {
+            Device().WaitIdle();
+            rayTracingPipeline_.reset();
+            radianceCacheResolvePipeline_.reset();
+            CreateRadianceCache();
+            CreateRayTracingPipelines();
+        }
+
+        // blend last frame's radiance into the cache cells before the paths query them
+        if (RadianceCacheBounce() > 0)
+        {
+            SCOPED_GPU_TIMER("radiance cache resolve");
+            VkBufferMemoryBarrier barrier = {};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.buffer = radianceCacheBuffer_->Handle();
+            barrier.size = VK_WHOLE_SIZE;
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+            VkDescriptorSet DescriptorSets[] = {radianceCacheResolvePipeline_->DescriptorSet(imageIndex)};
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, radianceCacheResolvePipeline_->Handle());
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                    radianceCacheResolvePipeline_->PipelineLayout().Handle(), 0, 1, DescriptorSets, 0, nullptr);
+            vkCmdDispatch(commandBuffer, Utilities::Math::GetSafeDispatchCount(RADIANCE_CACHE_SIZE, 64), 1, 1);
+
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+        }
 
         // Execute ray tracing shaders.
         {
@@ -181,6 +268,47 @@ namespace Vulkan::RayTracing
             vkCmdDispatch(commandBuffer, Utilities::Math::GetSafeDispatchCount(SwapChain().RenderExtent().width, 8), Utilities::Math::GetSafeDispatchCount(SwapChain().RenderExtent().width, 4), 1);
         }
 
+        // spatiotemporal variance guided filter, the accumulation already reprojected the moments, so the variance pass
+        // and the a-trous passes work on this frame alone and the filtered result never feeds back into the history.
+        // It lands in its own image, rtOutput_ stays the raw linear output the captures and the convergence read
+        if (SvgfIterations() > 0)
+        {
+            SCOPED_GPU_TIMER("svgf pass");
+            const uint32_t groupsX = Utilities::Math::GetSafeDispatchCount(SwapChain().RenderExtent().width, 8);
+            const uint32_t groupsY = Utilities::Math::GetSafeDispatchCount(SwapChain().RenderExtent().height, 4);
+
+            rtOutput_->InsertBarrier(commandBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+            rtMoments0_->InsertBarrier(commandBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+            rtMoments1_->InsertBarrier(commandBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+            rtAlbedo_->InsertBarrier(commandBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+            rtNormal_->InsertBarrier(commandBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+            {
+                VkDescriptorSet DescriptorSets[] = {svgfVariancePipeline_->DescriptorSet(imageIndex)};
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, svgfVariancePipeline_->Handle());
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                        svgfVariancePipeline_->PipelineLayout().Handle(), 0, 1, DescriptorSets, 0, nullptr);
+                vkCmdDispatch(commandBuffer, groupsX, groupsY, 1);
+            }
+
+            VkDescriptorSet DescriptorSets[] = {svgfAtrousPipeline_->DescriptorSet(imageIndex)};
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, svgfAtrousPipeline_->Handle());
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                    svgfAtrousPipeline_->PipelineLayout().Handle(), 0, 1, DescriptorSets, 0, nullptr);
+            const uint32_t iterations = std::min<uint32_t>(SvgfIterations(), SVGF_MAX_ITERATIONS);
+            for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+            {
+                rtSvgfPing_->InsertBarrier(commandBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+                rtSvgfPong_->InsertBarrier(commandBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+
+                const uint32_t pass[2] = {iteration, iterations};
+                vkCmdPushConstants(commandBuffer, svgfAtrousPipeline_->PipelineLayout().Handle(), VK_SHADER_STAGE_COMPUTE_BIT,
+                                   0, sizeof(pass), pass);
+                vkCmdDispatch(commandBuffer, groupsX, groupsY, 1);
+            }
+
+            rtSvgfOutput_->InsertBarrier(commandBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+        }
+
         {
             SCOPED_GPU_TIMER("compose");
             
@@ -208,10 +336,11 @@ namespace Vulkan::RayTracing
                                                VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
                                                VK_IMAGE_LAYOUT_GENERAL);
 
-                VkDescriptorSet DescriptorSets[] = {composePipelineNonDenoiser_->DescriptorSet(imageIndex)};
-                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, composePipelineNonDenoiser_->Handle());
+                const auto& composePipeline = SvgfIterations() > 0 ? composePipelineSvgf_ : composePipelineNonDenoiser_;
+                VkDescriptorSet DescriptorSets[] = {composePipeline->DescriptorSet(imageIndex)};
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, composePipeline->Handle());
                 vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                                        composePipelineNonDenoiser_->PipelineLayout().Handle(), 0, 1, DescriptorSets, 0, nullptr);
+                                        composePipeline->PipelineLayout().Handle(), 0, 1, DescriptorSets, 0, nullptr);
                 vkCmdDispatch(commandBuffer, Utilities::Math::GetSafeDispatchCount(SwapChain().RenderExtent().width, 16), Utilities::Math::GetSafeDispatchCount(SwapChain().RenderExtent().width, 16), 1);
             }
             
@@ -290,6 +419,28 @@ namespace Vulkan::RayTracing
 #endif
     }
 
+    void RayQueryRenderer::CreateRadianceCache()
+    {
+        // the whole hash grid only once the cache is turned on, a single entry keeps the bindings valid until then
+        radianceCacheAllocated_ = RadianceCacheBounce() > 0;
+        radianceCacheBuffer_.reset();
+        radianceCacheBufferMemory_.reset();
+
+        MemoryScope memoryScope(EMemoryCategory::Other, "radiance cache");
+        BufferUtil::CreateDeviceBuffer(CommandPool(), "RadianceCache", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                       std::vector<Assets::RadianceCacheEntry>(radianceCacheAllocated_ ? RADIANCE_CACHE_SIZE : 1),
+                                       radianceCacheBuffer_, radianceCacheBufferMemory_);
+    }
+
+    void RayQueryRenderer::CreateRayTracingPipelines()
+    {
+        rayTracingPipeline_.reset(new RayQueryPipeline(Device().GetDeviceProcedures(), SwapChain(), TLAS()[0], rtAccumulation_->GetImageView(), rtMotionVector_->GetImageView(),
+                                                         rtVisibility0_->GetImageView(), rtVisibility1_->GetImageView(),
+                                                         rtAlbedo_->GetImageView(), rtNormal_->GetImageView(),
+                                                         rtAdaptiveSample_->GetImageView(), rtShaderTimer_->GetImageView(), UniformBuffers(), RayStatisticsBuffers(), *samplerTableBuffer_, *adaptiveTileBuffer_, *radianceCacheBuffer_, GetScene()));
+        radianceCacheResolvePipeline_.reset(new PipelineCommon::RadianceCacheResolvePipeline(SwapChain(), *radianceCacheBuffer_));
+    }
+
     void RayQueryRenderer::BeforeNextFrame()
     {
         {
@@ -319,12 +470,17 @@ namespace Vulkan::RayTracing
         rtVisibility0_.reset(new RenderImage(Device(), extent, VK_FORMAT_R32_UINT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT, false, "vis0"));
         rtVisibility1_.reset(new RenderImage(Device(), extent, VK_FORMAT_R32_UINT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT, false, "vis1"));
 
-        rtAlbedo_.reset(new RenderImage(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_STORAGE_BIT, true, "albedo"));
-        rtNormal_.reset(new RenderImage(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_STORAGE_BIT, true, "normal"));
+        rtAlbedo_.reset(new RenderImage(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, true, "albedo"));
+        rtNormal_.reset(new RenderImage(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, true, "normal"));
         
         rtShaderTimer_.reset(new RenderImage(Device(), extent, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_STORAGE_BIT, true, "shadertimer"));
         
         rtAdaptiveSample_.reset(new RenderImage(Device(), extent, VK_FORMAT_R8_UINT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT, false, "adaptive sample"));
+        rtMoments0_.reset(new RenderImage(Device(), extent, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT, false, "moments0"));
+        rtMoments1_.reset(new RenderImage(Device(), extent, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT, false, "moments1"));
+        rtSvgfPing_.reset(new RenderImage(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT, false, "svgf ping"));
+        rtSvgfPong_.reset(new RenderImage(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT, false, "svgf pong"));
+        rtSvgfOutput_.reset(new RenderImage(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT, false, "svgf output"));
 
         rtDenoise0_.reset(new RenderImage(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, true, "denoise0"));
         rtDenoise1_.reset(new RenderImage(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_STORAGE_BIT, true, "denoise1"));
@@ -13,6 +13,9 @@ namespace Vulkan
 	{
 		class AccumulatePipeline;
 		class FinalComposePipeline;
+		class SvgfVariancePipeline;
+		class SvgfAtrousPipeline;
+		class RadianceCacheResolvePipeline;
 		class RayCastPipeline;
 	}
 
@@ -49,9 +52,14 @@ namespace Vulkan::RayTracing
 		void DeleteSwapChain() override;
 		void Render(VkCommandBuffer commandBuffer, uint32_t imageIndex) override;
 		void BeforeNextFrame();// override;
+		const RenderImage* LinearOutput() const override { return rtOutput_.get(); }
+		const RenderImage* AlbedoOutput() const override { return rtAlbedo_.get(); }
+		const RenderImage* NormalOutput() const override { return rtNormal_.get(); }
 	
 	private:
 		void CreateOutputImage();
+		void CreateRadianceCache();
+		void CreateRayTracingPipelines();
 
 		
 		
@@ -70,14 +78,39 @@ namespace Vulkan::RayTracing
 		std::unique_ptr<RenderImage> rtDenoise1_;
 		
 		std::unique_ptr<RenderImage> rtAdaptiveSample_;
+		std::unique_ptr<RenderImage> rtMoments0_;
+		std::unique_ptr<RenderImage> rtMoments1_;
+
+		// the variance guided filter's demodulated illumination with its variance in alpha
+		std::unique_ptr<RenderImage> rtSvgfPing_;
+		std::unique_ptr<RenderImage> rtSvgfPong_;
+		// the filtered and remodulated color, only the compose reads it
+		std::unique_ptr<RenderImage> rtSvgfOutput_;
 
 		std::unique_ptr<RenderImage> rtShaderTimer_;
 		
 		std::unique_ptr<RayQueryPipeline> rayTracingPipeline_;
 
+		// the sobol sampler's tables, they depend on nothing so they outlive the swap chain
+		std::unique_ptr<Buffer> samplerTableBuffer_;
+		std::unique_ptr<DeviceMemory> samplerTableBufferMemory_;
+
+		// the adaptive sampler's frame totals and tile errors, sized by the swap chain
+		std::unique_ptr<Buffer> adaptiveTileBuffer_;
+		std::unique_ptr<DeviceMemory> adaptiveTileBufferMemory_;
+
+		// the world space radiance cache, allocated once and only cleared with the swap chain
+		std::unique_ptr<Buffer> radianceCacheBuffer_;
+		std::unique_ptr<DeviceMemory> radianceCacheBufferMemory_;
+		bool radianceCacheAllocated_{};
+
 		std::unique_ptr<PipelineCommon::AccumulatePipeline> accumulatePipeline_;
+		std::unique_ptr<PipelineCommon::SvgfVariancePipeline> svgfVariancePipeline_;
+		std::unique_ptr<PipelineCommon::SvgfAtrousPipeline> svgfAtrousPipeline_;
+		std::unique_ptr<PipelineCommon::RadianceCacheResolvePipeline> radianceCacheResolvePipeline_;
 		std::unique_ptr<PipelineCommon::FinalComposePipeline> composePipelineNonDenoiser_;
 		std::unique_ptr<PipelineCommon::FinalComposePipeline> composePipelineDenoiser_;
+		std::unique_ptr<PipelineCommon::FinalComposePipeline> composePipelineSvgf_;
 		std::unique_ptr<PipelineCommon::VisualDebuggerPipeline> visualDebugPipeline_;
 
 #if WITH_OIDN
@@ -234,6 +234,33 @@ namespace Vulkan::RayTracing
         cameraCenterCastContext_.Direction = glm::vec4(dir, 0);
     }
 
+    const RenderImage* RayTraceBaseRenderer::GetLinearOutputImage() const
+    {
+        if( currentLogicRenderer_ < logicRenderers_.size() )
+        {
+            return logicRenderers_[currentLogicRenderer_]->LinearOutput();
+        }
+        return nullptr;
+    }
+
+    const RenderImage* RayTraceBaseRenderer::GetAlbedoImage() const
+    {
+        if( currentLogicRenderer_ < logicRenderers_.size() )
+        {
+            return logicRenderers_[currentLogicRenderer_]->AlbedoOutput();
+        }
+        return nullptr;
+    }
+
+    const RenderImage* RayTraceBaseRenderer::GetNormalImage() const
+    {
+        if( currentLogicRenderer_ < logicRenderers_.size() )
+        {
+            return logicRenderers_[currentLogicRenderer_]->NormalOutput();
+        }
+        return nullptr;
+    }
+
     void RayTraceBaseRenderer::OnPreLoadScene()
     {
         Vulkan::VulkanBaseRenderer::OnPreLoadScene();
@@ -301,6 +328,7 @@ namespace Vulkan::RayTracing
 
         // Allocate the structures memory.
         const auto total = GetTotalRequirements(bottomAs_);
+        MemoryScope memoryScope(EMemoryCategory::AccelerationStructure, "BLAS");
 
         bottomBuffer_.reset(new Buffer(Device(), total.accelerationStructureSize,
                                        VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR |
@@ -342,6 +370,7 @@ namespace Vulkan::RayTracing
 
         // Top level acceleration structure
         std::vector<VkAccelerationStructureInstanceKHR> instances;
+        MemoryScope memoryScope(EMemoryCategory::AccelerationStructure, "TLAS");
 
         // Hit group 0: triangles
         // Hit group 1: procedurals
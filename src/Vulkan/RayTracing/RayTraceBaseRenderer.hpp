@@ -64,6 +64,10 @@ namespace Vulkan::RayTracing
 		virtual bool GetLastRaycastResult(Assets::RayCastResult& result) const override;
 		virtual void SetRaycastRay(glm::vec3 org, glm::vec3 dir) const override;
 
+		virtual const RenderImage* GetLinearOutputImage() const override;
+		virtual const RenderImage* GetAlbedoImage() const override;
+		virtual const RenderImage* GetNormalImage() const override;
+
 
 	protected:
 		void CreateBottomLevelStructures(VkCommandBuffer commandBuffer);
@@ -102,6 +106,11 @@ namespace Vulkan::RayTracing
 		virtual void CreateSwapChain() {};
 		virtual void DeleteSwapChain() {};
 		virtual void Render(VkCommandBuffer commandBuffer, uint32_t imageIndex) {};
+
+		// the linear hdr accumulation target, left in general layout after Render
+		virtual const RenderImage* LinearOutput() const { return nullptr; }
+		virtual const RenderImage* AlbedoOutput() const { return nullptr; }
+		virtual const RenderImage* NormalOutput() const { return nullptr; }
 		
 		RayTracing::RayTraceBaseRenderer& baseRender_;
 
@@ -112,6 +121,7 @@ namespace Vulkan::RayTracing
 		class CommandPool& CommandPool() { return baseRender_.CommandPool(); }
 		const class DepthBuffer& DepthBuffer() const { return baseRender_.DepthBuffer(); }
 		const std::vector<Assets::UniformBuffer>& UniformBuffers() const { return baseRender_.UniformBuffers(); }
+		const std::vector<Assets::RayStatisticsBuffer>& RayStatisticsBuffers() const { return baseRender_.RayStatisticsBuffers(); }
 		class VulkanGpuTimer* GpuTimer() const {return baseRender_.GpuTimer();}
 		
 		const Assets::Scene& GetScene() {return baseRender_.GetScene();}
@@ -119,6 +129,8 @@ namespace Vulkan::RayTracing
 		int FrameCount() const {return baseRender_.FrameCount();}
 
 		bool VisualDebug() const {return baseRender_.VisualDebug();}
+		uint32_t SvgfIterations() const {return baseRender_.SvgfIterations();}
+		uint32_t RadianceCacheBounce() const {return baseRender_.RadianceCacheBounce();}
 
 		std::vector<TopLevelAccelerationStructure>& TLAS() { return baseRender_.TLAS(); }
 		std::vector<BottomLevelAccelerationStructure>& BLAS() { return baseRender_.BLAS(); }
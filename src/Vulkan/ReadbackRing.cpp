@@ -0,0 +1,162 @@
+#include "ReadbackRing.hpp"
+#include "Buffer.hpp"
+#include "Device.hpp"
+#include "DeviceMemory.hpp"
+#include "ImageMemoryBarrier.hpp"
+
+#include <chrono>
+#include <thread>
+
+namespace Vulkan
+{
+	ReadbackRing::ReadbackRing(const class Device& device, const uint32_t slotCount) :
+		device_(device)
+	{
+		for (uint32_t i = 0; i < slotCount; ++i)
+		{
+			slots_.emplace_back(new SlotStorage());
+		}
+	}
+
+	ReadbackRing::~ReadbackRing()
+	{
+		// consumers on worker threads may still read from the mapped memory
+		for (auto& slot : slots_)
+		{
+			while (slot->State.load() == ESlotState::Consuming)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			if (slot->StagingMemory)
+			{
+				slot->StagingMemory->Unmap();
+			}
+			slot->StagingBuffer.reset();
+			slot->StagingMemory.reset();
+		}
+	}
+
+	uint32_t ReadbackRing::FreeSlots() const
+	{
+		uint32_t count = 0;
+		for (const auto& slot : slots_)
+		{
+			count += slot->State.load() == ESlotState::Free ? 1 : 0;
+		}
+		return count;
+	}
+
+	bool ReadbackRing::Record(VkCommandBuffer commandBuffer, const std::vector<Region>& regions, const uint64_t serial, Callback callback)
+	{
+		SlotStorage* slot = nullptr;
+		uint32_t index = 0;
+		for (; index < slots_.size(); ++index)
+		{
+			if (slots_[index]->State.load() == ESlotState::Free)
+			{
+				slot = slots_[index].get();
+				break;
+			}
+		}
+
+		if (slot == nullptr)
+		{
+			return false;
+		}
+
+		size_t requiredBytes = 0;
+		for (const auto& region : regions)
+		{
+			requiredBytes += static_cast<size_t>(region.Extent.width) * region.Extent.height * region.BytesPerPixel;
+		}
+
+		// grow only, a resize keeps the slot on the bigger buffer afterwards
+		if (slot->Capacity < requiredBytes)
+		{
+			if (slot->StagingMemory)
+			{
+				slot->StagingMemory->Unmap();
+			}
+			slot->StagingBuffer.reset();
+			slot->StagingMemory.reset();
+
+			MemoryScope memoryScope(EMemoryCategory::Staging, "readback ring");
+			slot->StagingBuffer.reset(new Buffer(device_, requiredBytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT));
+			slot->StagingMemory.reset(new DeviceMemory(slot->StagingBuffer->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)));
+			slot->Mapped = static_cast<uint8_t*>(slot->StagingMemory->Map(0, requiredBytes));
+			slot->Capacity = requiredBytes;
+		}
+
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.baseMipLevel = 0;
+		subresourceRange.levelCount = 1;
+		subresourceRange.baseArrayLayer = 0;
+		subresourceRange.layerCount = 1;
+
+		slot->View.Index = index;
+		slot->View.Regions = regions;
+		slot->View.Data.clear();
+
+		size_t offset = 0;
+		for (const auto& region : regions)
+		{
+			ImageMemoryBarrier::Insert(commandBuffer, region.Image, subresourceRange,
+				VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, region.Layout,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+			VkBufferImageCopy copyRegion = {};
+			copyRegion.bufferOffset = offset;
+			copyRegion.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+			copyRegion.imageOffset = {0, 0, 0};
+			copyRegion.imageExtent = {region.Extent.width, region.Extent.height, 1};
+
+			vkCmdCopyImageToBuffer(commandBuffer, region.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot->StagingBuffer->Handle(), 1, &copyRegion);
+
+			ImageMemoryBarrier::Insert(commandBuffer, region.Image, subresourceRange,
+				VK_ACCESS_TRANSFER_READ_BIT, 0, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, region.Layout);
+
+			slot->View.Data.push_back(slot->Mapped + offset);
+			offset += static_cast<size_t>(region.Extent.width) * region.Extent.height * region.BytesPerPixel;
+		}
+
+		// make the transfer visible to the host once the frame fence signals
+		VkMemoryBarrier hostBarrier = {};
+		hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+
+		slot->Serial = serial;
+		slot->OnRetire = std::move(callback);
+		slot->State.store(ESlotState::InFlight);
+		return true;
+	}
+
+	void ReadbackRing::Retire(const uint64_t completedSerial)
+	{
+		for (auto& slot : slots_)
+		{
+			if (slot->State.load() == ESlotState::InFlight && slot->Serial <= completedSerial)
+			{
+				slot->State.store(ESlotState::Consuming);
+				const Callback callback = std::move(slot->OnRetire);
+				slot->OnRetire = nullptr;
+				if (callback)
+				{
+					callback(slot->View);
+				}
+				else
+				{
+					Release(slot->View.Index);
+				}
+			}
+		}
+	}
+
+	void ReadbackRing::Release(const uint32_t index)
+	{
+		slots_[index]->State.store(ESlotState::Free);
+	}
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Vulkan.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Vulkan
+{
+	class Buffer;
+	class Device;
+	class DeviceMemory;
+
+	// Copies images into persistently mapped host buffers from inside the frame's own command buffer.
+	// A slot is handed to its consumer once the submission that wrote it has retired, and returns to the
+	// ring when the consumer calls Release, which may happen on any thread. Nothing here waits on the gpu.
+	class ReadbackRing final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(ReadbackRing)
+
+		struct Region
+		{
+			VkImage Image;
+			// the layout the image is in when recorded, restored after the copy
+			VkImageLayout Layout;
+			VkExtent2D Extent;
+			VkFormat Format;
+			uint32_t BytesPerPixel;
+		};
+
+		struct Slot
+		{
+			uint32_t Index;
+			std::vector<Region> Regions;
+			std::vector<const uint8_t*> Data;
+		};
+
+		// runs on the render thread when the slot retires, the slot stays reserved until Release
+		using Callback = std::function<void(const Slot&)>;
+
+		ReadbackRing(const class Device& device, uint32_t slotCount);
+		~ReadbackRing();
+
+		// false when every slot is still in flight or held by a consumer, the caller decides to retry or drop
+		bool Record(VkCommandBuffer commandBuffer, const std::vector<Region>& regions, uint64_t serial, Callback callback);
+		void Retire(uint64_t completedSerial);
+		void Release(uint32_t index);
+
+		uint32_t SlotCount() const { return static_cast<uint32_t>(slots_.size()); }
+		uint32_t FreeSlots() const;
+
+	private:
+
+		enum class ESlotState : uint32_t
+		{
+			Free,
+			InFlight,
+			Consuming,
+		};
+
+		struct SlotStorage
+		{
+			std::unique_ptr<class Buffer> StagingBuffer;
+			std::unique_ptr<class DeviceMemory> StagingMemory;
+			uint8_t* Mapped{};
+			size_t Capacity{};
+			uint64_t Serial{};
+			std::atomic<ESlotState> State{ESlotState::Free};
+			Slot View{};
+			Callback OnRetire;
+		};
+
+		const class Device& device_;
+		std::vector<std::unique_ptr<SlotStorage>> slots_;
+	};
+
+}
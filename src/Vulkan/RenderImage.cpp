@@ -2,6 +2,7 @@
 #include "Buffer.hpp"
 #include "DepthBuffer.hpp"
 #include "Device.hpp"
+#include "DeviceMemory.hpp"
 #include "Image.hpp"
 #include "ImageMemoryBarrier.hpp"
 #include "ImageView.hpp"
@@ -18,6 +19,7 @@ namespace Vulkan {
         bool external,
         const char* debugName)
     {
+        MemoryScope memoryScope(EMemoryCategory::RenderTarget, debugName);
         image_.reset(new Image(device, extent, format, tiling, usage, external));
         imageMemory_.reset(
             new DeviceMemory(image_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, external)));
@@ -5,6 +5,7 @@
 #include "DebugUtilsMessenger.hpp"
 #include "DepthBuffer.hpp"
 #include "Device.hpp"
+#include "Enumerate.hpp"
 #include "Fence.hpp"
 #include "FrameBuffer.hpp"
 #include "GraphicsPipeline.hpp"
@@ -21,8 +22,13 @@
 #include "Assets/Texture.hpp"
 #include "Utilities/Exception.hpp"
 #include "Utilities/Console.hpp"
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <limits>
+#include <thread>
 #include <fmt/format.h>
+#include <glm/gtc/packing.hpp>
 
 #include "ImageMemoryBarrier.hpp"
 #include "Options.hpp"
@@ -143,34 +149,180 @@ VulkanBaseRenderer::VulkanBaseRenderer(Vulkan::Window* window, const VkPresentMo
 	uptime = std::chrono::high_resolution_clock::now().time_since_epoch().count();
 }
 
-VulkanGpuTimer::VulkanGpuTimer(VkDevice device, uint32_t totalCount, const VkPhysicalDeviceProperties& prop)
+VulkanGpuTimer::VulkanGpuTimer(VkDevice device, uint32_t framesInFlight, uint32_t queriesPerFrame, const VkPhysicalDeviceProperties& prop) :
+	cpuBegin_(Utilities::Profiler::MaxScopeIds),
+	cpuTime_(Utilities::Profiler::MaxScopeIds),
+	gpuTrack_(Utilities::Profiler::CreateTrack("gpu"))
 {
-	if(GOption->Benchmark)
-	{
-		return;
-	}
-	
 	device_ = device;
-	time_stamps.resize(totalCount);
 	timeStampPeriod_ = prop.limits.timestampPeriod;
+	pools_.resize(framesInFlight);
+	for(auto& pool : pools_)
+	{
+		CreatePool(pool, queriesPerFrame);
+	}
+}
+
+VulkanGpuTimer::~VulkanGpuTimer()
+{
+	for(auto& pool : pools_)
+	{
+		vkDestroyQueryPool(device_, pool.Pool, nullptr);
+	}
+}
+
+void VulkanGpuTimer::CreatePool(FramePool& pool, uint32_t capacity)
+{
+	if(pool.Pool != VK_NULL_HANDLE)
+	{
+		vkDestroyQueryPool(device_, pool.Pool, nullptr);
+	}
+
 	// Create the query pool object used to get the GPU time tamps
 	VkQueryPoolCreateInfo query_pool_info{};
 	query_pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
 	// We need to specify the query type for this pool, which in our case is for time stamps
 	query_pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
 	// Set the no. of queries in this pool
-	query_pool_info.queryCount = static_cast<uint32_t>(time_stamps.size());
-	Check( vkCreateQueryPool(device, &query_pool_info, nullptr, &query_pool_timestamps), "create timestamp pool");
+	query_pool_info.queryCount = capacity;
+	Check( vkCreateQueryPool(device_, &query_pool_info, nullptr, &pool.Pool), "create timestamp pool");
+	pool.Capacity = capacity;
 }
 
-VulkanGpuTimer::~VulkanGpuTimer()
+void VulkanGpuTimer::Reset(VkCommandBuffer commandBuffer)
 {
-	if(GOption->Benchmark)
+	FramePool& pool = pools_[frame_++ % pools_.size()];
+	recording_ = nullptr;
+	openScopes_.clear();
+
+	// the frame that used this pool last is still executing, this frame goes untimed rather than waiting for it
+	if(pool.Pending && !Collect(pool))
 	{
 		return;
 	}
-	
-	vkDestroyQueryPool(device_, query_pool_timestamps, nullptr);
+
+	// a frame ran out of queries, the pool is idle now so it can grow for the next use
+	if(pool.Overflowed)
+	{
+		CreatePool(pool, pool.Capacity * 2);
+		pool.Overflowed = false;
+	}
+
+	vkCmdResetQueryPool(commandBuffer, pool.Pool, 0, pool.Capacity);
+	pool.Used = 0;
+	pool.Frame = frame_;
+	pool.CpuBegin = Utilities::Profiler::Now();
+	pool.Scopes.clear();
+	recording_ = &pool;
+}
+
+void VulkanGpuTimer::FrameEnd(VkCommandBuffer commandBuffer)
+{
+	if(recording_ != nullptr)
+	{
+		recording_->Pending = !recording_->Scopes.empty();
+		recording_ = nullptr;
+	}
+
+	for(auto& pool : pools_)
+	{
+		if(pool.Pending)
+		{
+			Collect(pool);
+		}
+	}
+}
+
+void VulkanGpuTimer::Start(VkCommandBuffer commandBuffer, uint32_t scopeId)
+{
+	if(recording_ == nullptr)
+	{
+		return;
+	}
+
+	// end query included, a scope that does not fit is dropped with its children and the pool grows on its next use
+	if(recording_->Used + 2 + openScopes_.size() > recording_->Capacity)
+	{
+		recording_->Overflowed = true;
+		openScopes_.push_back(UINT32_MAX);
+		return;
+	}
+
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, recording_->Pool, recording_->Used);
+	openScopes_.push_back(static_cast<uint32_t>(recording_->Scopes.size()));
+	recording_->Scopes.push_back({scopeId, recording_->Used++, 0, static_cast<uint32_t>(openScopes_.size() - 1)});
+}
+
+void VulkanGpuTimer::End(VkCommandBuffer commandBuffer, uint32_t scopeId)
+{
+	if(recording_ == nullptr || openScopes_.empty())
+	{
+		return;
+	}
+
+	const uint32_t scope = openScopes_.back();
+	openScopes_.pop_back();
+	if(scope == UINT32_MAX)
+	{
+		return;
+	}
+
+	assert(recording_->Scopes[scope].Id == scopeId);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, recording_->Pool, recording_->Used);
+	recording_->Scopes[scope].EndQuery = recording_->Used++;
+}
+
+bool VulkanGpuTimer::Collect(FramePool& pool)
+{
+	// no VK_QUERY_RESULT_WAIT_BIT, NOT_READY just means the frame is still in flight and we look again next frame
+	timeStamps_.resize(pool.Used);
+	const VkResult result = vkGetQueryPoolResults(device_, pool.Pool, 0, pool.Used, timeStamps_.size() * sizeof(uint64_t),
+		timeStamps_.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+	if(result != VK_SUCCESS)
+	{
+		return false;
+	}
+	pool.Pending = false;
+
+	// pools finish in submission order, an older one never replaces a newer result
+	if(pool.Frame < collectedFrame_)
+	{
+		return true;
+	}
+	collectedFrame_ = pool.Frame;
+
+	// without calibrated timestamps the gpu timeline is pinned to the cpu time the frame started recording
+	const uint64_t origin = timeStamps_.empty() ? 0 : timeStamps_[0];
+	const auto toCpuTime = [&](uint64_t timeStamp)
+	{
+		return pool.CpuBegin + static_cast<int64_t>((timeStamp - origin) * static_cast<double>(timeStampPeriod_));
+	};
+
+	results_.clear();
+	for(const auto& scope : pool.Scopes)
+	{
+		const float time = (timeStamps_[scope.EndQuery] - timeStamps_[scope.StartQuery]) * timeStampPeriod_ * 1e-6f;
+		results_.push_back({scope.Id, time, scope.Depth});
+		gpuTrack_.Emit(scope.Id, toCpuTime(timeStamps_[scope.StartQuery]), toCpuTime(timeStamps_[scope.EndQuery]));
+	}
+	return true;
+}
+
+float VulkanGpuTimer::GetTime(const char* name) const
+{
+	const uint32_t scopeId = Utilities::Profiler::Find(name);
+	float time = 0;
+	for(const auto& result : results_)
+	{
+		time += result.Id == scopeId ? result.Time : 0;
+	}
+	return time;
+}
+
+float VulkanGpuTimer::GetCpuTime(const char* name) const
+{
+	const uint32_t scopeId = Utilities::Profiler::Find(name);
+	return scopeId < cpuTime_.size() ? cpuTime_[scopeId] * 1e-6f : 0;
 }
 
 VulkanBaseRenderer::~VulkanBaseRenderer()
@@ -178,6 +330,7 @@ VulkanBaseRenderer::~VulkanBaseRenderer()
 	VulkanBaseRenderer::DeleteSwapChain();
 
 	rtEditorViewport_.reset();
+	readbackRing_.reset();
 	gpuTimer_.reset();
 	globalTexturePool_.reset();
 	commandPool_.reset();
@@ -258,6 +411,33 @@ void VulkanBaseRenderer::End()
 {
 	device_->WaitIdle();
 	gpuTimer_.reset();
+
+	// requests made on the last frame still get their copy, the ring waits for its consumers before it goes away
+	if(readbackRing_)
+	{
+		while(!pendingReadbacks_.empty())
+		{
+			readbackRing_->Retire(std::numeric_limits<uint64_t>::max());
+			if(readbackRing_->FreeSlots() == 0)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				continue;
+			}
+			SingleTimeCommands::Submit(CommandPool(), [this](VkCommandBuffer commandBuffer)
+			{
+				RecordReadbacks(commandBuffer);
+			});
+		}
+		readbackRing_->Retire(std::numeric_limits<uint64_t>::max());
+
+		// the consumers' encode tasks hand their slots back through GetReadbackRing on the task threads, so the ring
+		// has to outlive every one of them
+		while(readbackRing_->FreeSlots() < readbackRing_->SlotCount())
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		readbackRing_.reset();
+	}
 }
 
 const Assets::Scene& VulkanBaseRenderer::GetScene()
@@ -330,11 +510,22 @@ void VulkanBaseRenderer::SetPhysicalDeviceImpl(
 	hostQueryResetFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_QUERY_RESET_FEATURES_EXT;
 	hostQueryResetFeatures.pNext = &bufferDeviceAddressFeatures;
 	hostQueryResetFeatures.hostQueryReset = true;
+
+	// per heap budget and usage for the memory statistics, not required
+	const auto availableExtensions = GetEnumerateVector(physicalDevice, static_cast<const char*>(nullptr), vkEnumerateDeviceExtensionProperties);
+	if (std::any_of(availableExtensions.begin(), availableExtensions.end(), [](const VkExtensionProperties& extension)
+	{
+		return std::string(extension.extensionName) == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+	}))
+	{
+		requiredExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
 	
 	device_.reset(new class Device(physicalDevice, *surface_, requiredExtensions, deviceFeatures, &hostQueryResetFeatures));
 	commandPool_.reset(new class CommandPool(*device_, device_->GraphicsFamilyIndex(), 0, true));
 	commandPool2_.reset(new class CommandPool(*device_, device_->TransferFamilyIndex(), 1, true));
-	gpuTimer_.reset(new VulkanGpuTimer(device_->Handle(), 10 * 2, device_->DeviceProperties()));
+	// DrawFrame waits for the previous frame before submitting, so two frames are on the gpu at most, the third pool is slack
+	gpuTimer_.reset(new VulkanGpuTimer(device_->Handle(), 3, 64, device_->DeviceProperties()));
 }
 
 void VulkanBaseRenderer::OnDeviceSet()
@@ -362,6 +553,7 @@ void VulkanBaseRenderer::CreateSwapChain()
 		renderFinishedSemaphores_.emplace_back(*device_);
 		inFlightFences_.emplace_back(*device_, true);
 		uniformBuffers_.emplace_back(*device_);
+		rayStatisticsBuffers_.emplace_back(*device_);
 	}
 
 	graphicsPipeline_.reset(new class GraphicsPipeline(*swapChain_, *depthBuffer_, uniformBuffers_, GetScene(), isWireFrame_));
@@ -376,9 +568,6 @@ void VulkanBaseRenderer::CreateSwapChain()
 
 	fence = nullptr;
 
-	screenShotImage_.reset(new Image(*device_, swapChain_->Extent(), swapChain_->Format(), VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_TRANSFER_DST_BIT));
-	screenShotImageMemory_.reset(new DeviceMemory(screenShotImage_->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)));
-
 	rtEditorViewport_.reset(new RenderImage(*device_, {1280,720}, swapChain_->Format(), VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT));
 
 	if(DelegateCreateSwapChain)
@@ -394,13 +583,13 @@ void VulkanBaseRenderer::DeleteSwapChain()
 		DelegateDeleteSwapChain();
 	}
 	
-	screenShotImageMemory_.reset();
-	screenShotImage_.reset();
 	commandBuffers_.reset();
 	swapChainFramebuffers_.clear();
 	graphicsPipeline_.reset();
 	bufferClearPipeline_.reset();
 	uniformBuffers_.clear();
+	rayStatisticsBuffers_.clear();
+	pendingRayStatistics_ = -1;
 	inFlightFences_.clear();
 	renderFinishedSemaphores_.clear();
 	imageAvailableSemaphores_.clear();
@@ -409,44 +598,108 @@ void VulkanBaseRenderer::DeleteSwapChain()
 	fence = nullptr;
 }
 
-void VulkanBaseRenderer::CaptureScreenShot()
+bool VulkanBaseRenderer::CaptureLinearOutput(std::vector<float>& rgba, VkExtent2D& extent)
 {
+	const RenderImage* output = GetLinearOutputImage();
+	if (output == nullptr || output->GetImage().Format() != VK_FORMAT_R16G16B16A16_SFLOAT)
+	{
+		return false;
+	}
+
+	extent = output->GetImage().Extent();
+	const size_t pixelCount = static_cast<size_t>(extent.width) * extent.height;
+	const size_t bufferSize = pixelCount * 4 * sizeof(uint16_t);
+
+	MemoryScope memoryScope(EMemoryCategory::Staging, "linear capture");
+	Buffer stagingBuffer(*device_, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+	DeviceMemory stagingMemory = stagingBuffer.AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
 	SingleTimeCommands::Submit(CommandPool(), [&](VkCommandBuffer commandBuffer)
 	{
-		const auto& image = swapChain_->Images()[currentImageIndex_];
+		output->InsertBarrier(commandBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
 
-		VkImageSubresourceRange subresourceRange = {};
-		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		subresourceRange.baseMipLevel = 0;
-		subresourceRange.levelCount = 1;
-		subresourceRange.baseArrayLayer = 0;
-		subresourceRange.layerCount = 1;
-	
-		ImageMemoryBarrier::Insert(commandBuffer, image, subresourceRange,
-					   0, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-					   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-
-		ImageMemoryBarrier::Insert(commandBuffer, screenShotImage_->Handle(), subresourceRange, 0,
-						   VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
-						   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-		// Copy output image into swap-chain image.
-		VkImageCopy copyRegion;
-		copyRegion.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
-		copyRegion.srcOffset = {0, 0, 0};
-		copyRegion.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
-		copyRegion.dstOffset = {0, 0, 0};
-		copyRegion.extent = {SwapChain().Extent().width, SwapChain().Extent().height, 1};
-
-		vkCmdCopyImage(commandBuffer,
-					   image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-					   screenShotImage_->Handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					   1, &copyRegion);
-
-		ImageMemoryBarrier::Insert(commandBuffer, SwapChain().Images()[currentImageIndex_], subresourceRange,
-							   VK_ACCESS_TRANSFER_READ_BIT,
-							   0, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+		VkBufferImageCopy region = {};
+		region.bufferOffset = 0;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+		region.imageOffset = {0, 0, 0};
+		region.imageExtent = {extent.width, extent.height, 1};
+
+		vkCmdCopyImageToBuffer(commandBuffer, output->GetImage().Handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, stagingBuffer.Handle(), 1, &region);
+
+		output->InsertBarrier(commandBuffer, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
 	});
+
+	const uint16_t* halfs = static_cast<const uint16_t*>(stagingMemory.Map(0, bufferSize));
+	rgba.resize(pixelCount * 4);
+	for (size_t i = 0; i < rgba.size(); ++i)
+	{
+		rgba[i] = glm::unpackHalf1x16(halfs[i]);
+	}
+	stagingMemory.Unmap();
+
+	return true;
+}
+
+void VulkanBaseRenderer::RequestReadback(EReadbackSource source, ReadbackRing::Callback callback, std::function<void()> dropped)
+{
+	ReserveReadbackSlots(3);
+	pendingReadbacks_.push_back({source, std::move(callback), std::move(dropped)});
+}
+
+void VulkanBaseRenderer::ReserveReadbackSlots(uint32_t slotCount)
+{
+	if(!readbackRing_ || (readbackRing_->SlotCount() < slotCount && readbackRing_->FreeSlots() == readbackRing_->SlotCount()))
+	{
+		readbackRing_.reset(new class ReadbackRing(*device_, std::max(slotCount, readbackRing_ ? readbackRing_->SlotCount() : 0u)));
+	}
+}
+
+void VulkanBaseRenderer::RecordReadbacks(VkCommandBuffer commandBuffer)
+{
+	for(auto it = pendingReadbacks_.begin(); it != pendingReadbacks_.end();)
+	{
+		std::vector<ReadbackRing::Region> regions;
+		const auto addRegion = [&regions](const RenderImage* image)
+		{
+			if(image != nullptr)
+			{
+				regions.push_back({image->GetImage().Handle(), VK_IMAGE_LAYOUT_GENERAL, image->GetImage().Extent(), image->GetImage().Format(), 4 * sizeof(uint16_t)});
+			}
+		};
+
+		if(it->Source == EReadbackSource::SwapChain)
+		{
+			regions.push_back({swapChain_->Images()[currentImageIndex_], VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, swapChain_->Extent(), swapChain_->Format(), 4});
+		}
+		else
+		{
+			addRegion(GetLinearOutputImage());
+		}
+		if(regions.empty())
+		{
+			fmt::print("readback dropped, the current renderer has no linear output\n");
+			if(it->Dropped)
+			{
+				it->Dropped();
+			}
+			it = pendingReadbacks_.erase(it);
+			continue;
+		}
+		if(it->Source == EReadbackSource::LinearOutputWithAov)
+		{
+			addRegion(GetAlbedoImage());
+			addRegion(GetNormalImage());
+		}
+
+		// ring full, keep the request for a later frame instead of waiting
+		if(!readbackRing_->Record(commandBuffer, regions, submitSerial_ + 1, it->Callback))
+		{
+			break;
+		}
+		it = pendingReadbacks_.erase(it);
+	}
 }
 
 void VulkanBaseRenderer::CaptureEditorViewport(VkCommandBuffer commandBuffer, const uint32_t imageIndex)
@@ -518,6 +771,36 @@ void VulkanBaseRenderer::ClearViewport(VkCommandBuffer commandBuffer, const uint
 	}
 }
 
+void VulkanBaseRenderer::ClearRayStatistics(VkCommandBuffer commandBuffer, const uint32_t imageIndex)
+{
+	const auto& buffer = rayStatisticsBuffers_[imageIndex].Buffer();
+	vkCmdFillBuffer(commandBuffer, buffer.Handle(), 0, VK_WHOLE_SIZE, 0);
+
+	VkBufferMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = buffer.Handle();
+	barrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void VulkanBaseRenderer::ReleaseRayStatistics(VkCommandBuffer commandBuffer, const uint32_t imageIndex)
+{
+	// make the counters visible to the host once the frame fence signals
+	VkBufferMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = rayStatisticsBuffers_[imageIndex].Buffer().Handle();
+	barrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
 void VulkanBaseRenderer::DrawFrame()
 {
 	{
@@ -558,12 +841,24 @@ void VulkanBaseRenderer::DrawFrame()
 			SCOPED_CPU_TIMER("render");
 			SCOPED_GPU_TIMER("gpu time");
 	
+			if(collectRayStatistics_)
+			{
+				ClearRayStatistics(commandBuffer, currentImageIndex_);
+			}
 			ClearViewport(commandBuffer, currentImageIndex_);
 			Render(commandBuffer, currentImageIndex_);
 			if(DelegatePostRender)
 			{
 				DelegatePostRender(commandBuffer, currentImageIndex_);
 			}
+			if(collectRayStatistics_)
+			{
+				ReleaseRayStatistics(commandBuffer, currentImageIndex_);
+			}
+			if(!pendingReadbacks_.empty())
+			{
+				RecordReadbacks(commandBuffer);
+			}
 		}
 
 		commandBuffers_->End(currentFrame_);
@@ -581,6 +876,15 @@ void VulkanBaseRenderer::DrawFrame()
 			SCOPED_CPU_TIMER("sync-wait");
 			fence->Wait(noTimeout);
 		}
+		if(readbackRing_)
+		{
+			readbackRing_->Retire(submitSerial_);
+		}
+		if(pendingRayStatistics_ >= 0)
+		{
+			lastRayStatistics_ = rayStatisticsBuffers_[pendingRayStatistics_].Read();
+		}
+		pendingRayStatistics_ = collectRayStatistics_ ? static_cast<int32_t>(currentImageIndex_) : -1;
 		fence = &(inFlightFences_[currentFrame_]);
 		
 		VkSubmitInfo submitInfo = {};
@@ -605,6 +909,7 @@ void VulkanBaseRenderer::DrawFrame()
 
 			Check(vkQueueSubmit(device_->GraphicsQueue(), 1, &submitInfo, fence->Handle()),
 				"submit draw command buffer");
+			submitSerial_++;
 		}
 		
 		{
@@ -638,7 +943,7 @@ void VulkanBaseRenderer::DrawFrame()
 		currentFrame_ = (currentFrame_ + 1) % inFlightFences_.size();
 		frameCount_++;
 	}
-	gpuTimer_->CpuFrameEnd();
+	Utilities::Profiler::MarkFrame(frameCount_);
 }
 
 void VulkanBaseRenderer::Render(VkCommandBuffer commandBuffer, const uint32_t imageIndex)
@@ -14,10 +14,11 @@
 
 #include "Image.hpp"
 #include "Options.hpp"
+#include "ReadbackRing.hpp"
+#include "Utilities/Profiler.hpp"
 
-#define SCOPED_GPU_TIMER(name) ScopedGpuTimer scopedGpuTimer(commandBuffer, GpuTimer(), name)
-#define SCOPED_CPU_TIMER(name) ScopedCpuTimer scopedCpuTimer(GpuTimer(), name)
-#define BENCH_MARK_CHECK() if(GOption->Benchmark) return
+#define SCOPED_GPU_TIMER(name) ScopedGpuTimer scopedGpuTimer(commandBuffer, GpuTimer(), PROFILER_SCOPE_ID(name))
+#define SCOPED_CPU_TIMER(name) ScopedCpuTimer scopedCpuTimer(GpuTimer(), PROFILER_SCOPE_ID(name))
 namespace Vulkan
 {
 	namespace PipelineCommon
@@ -45,148 +46,105 @@ namespace Vulkan
 		ERT_ModernDeferred,
 		ERT_LegacyDeferred,
 	};
+
+	enum class EReadbackSource
+	{
+		LinearOutput,
+		LinearOutputWithAov,
+		// the presented image, after the ui
+		SwapChain,
+	};
 	
 	class VulkanGpuTimer
 	{
 	public:
 		DEFAULT_NON_COPIABLE(VulkanGpuTimer)
 		
-		VulkanGpuTimer(VkDevice device, uint32_t totalCount, const VkPhysicalDeviceProperties& prop);
+		// one timestamp pool per frame in flight, read back without waiting once the gpu is done with it
+		VulkanGpuTimer(VkDevice device, uint32_t framesInFlight, uint32_t queriesPerFrame, const VkPhysicalDeviceProperties& prop);
 		virtual ~VulkanGpuTimer();
 
-		void Reset(VkCommandBuffer commandBuffer)
-		{
-			BENCH_MARK_CHECK();
-			vkCmdResetQueryPool(commandBuffer, query_pool_timestamps, 0, static_cast<uint32_t>(time_stamps.size()));
-			queryIdx = 0;
-			started_ = true;
-		}
+		// start recording the scopes of a new frame into the next pool, skipped if that pool is still on the gpu
+		void Reset(VkCommandBuffer commandBuffer);
 
-		void CpuFrameEnd()
-		{
-			// iterate the cpu_timer_query_map
-			for(auto& [name, query] : cpu_timer_query_map)
-			{
-				std::get<2>(cpu_timer_query_map[name]) = std::get<1>(cpu_timer_query_map[name]) - std::get<0>(cpu_timer_query_map[name]);
-			}
-		}
+		// collect every pool the gpu has finished, the newest one becomes the visible result
+		void FrameEnd(VkCommandBuffer commandBuffer);
 
-		void FrameEnd(VkCommandBuffer commandBuffer)
-		{
-			BENCH_MARK_CHECK();
-			if(started_)
-			{
-				started_ = false;
-			}
-			else
-			{
-				return;
-			}
-			uint32_t count = static_cast<uint32_t>(time_stamps.size());
-
-			// Fetch the time stamp results written in the command buffer submissions
-			// A note on the flags used:
-			//	VK_QUERY_RESULT_64_BIT: Results will have 64 bits. As time stamp values are on nano-seconds, this flag should always be used to avoid 32 bit overflows
-			//  VK_QUERY_RESULT_WAIT_BIT: Since we want to immediately display the results, we use this flag to have the CPU wait until the results are available
-			vkGetQueryPoolResults(
-				device_,
-				query_pool_timestamps,
-				0,
-				queryIdx,
-				time_stamps.size() * sizeof(uint64_t),
-				time_stamps.data(),
-				sizeof(uint64_t),
-				VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
-		}
+		// scopes nest, End closes the innermost open scope
+		void Start(VkCommandBuffer commandBuffer, uint32_t scopeId);
+		void End(VkCommandBuffer commandBuffer, uint32_t scopeId);
 
-		void Start(VkCommandBuffer commandBuffer, const char* name)
+		// render thread only, also recorded on the thread's profiler track
+		void StartCpuTimer(uint32_t scopeId)
 		{
-			BENCH_MARK_CHECK();
-			if( timer_query_map.find(name) == timer_query_map.end())
+			if(scopeId < cpuBegin_.size())
 			{
-				timer_query_map[name] = std::make_tuple(0, 0);
+				cpuBegin_[scopeId] = Utilities::Profiler::Now();
 			}
-			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, query_pool_timestamps, queryIdx);
-			std::get<0>(timer_query_map[name]) = queryIdx;
-			queryIdx++;
-		}
-		void End(VkCommandBuffer commandBuffer, const char* name)
-		{
-			BENCH_MARK_CHECK();
-			assert( timer_query_map.find(name) != timer_query_map.end() );
-			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, query_pool_timestamps, queryIdx);
-			std::get<1>(timer_query_map[name]) = queryIdx;
-			queryIdx++;
 		}
-		void StartCpuTimer(const char* name)
+		void EndCpuTimer(uint32_t scopeId)
 		{
-			BENCH_MARK_CHECK();
-			if( cpu_timer_query_map.find(name) == cpu_timer_query_map.end())
+			if(scopeId < cpuBegin_.size())
 			{
-				cpu_timer_query_map[name] = std::make_tuple(0, 0, 0);
+				const int64_t end = Utilities::Profiler::Now();
+				cpuTime_[scopeId] = end - cpuBegin_[scopeId];
+				Utilities::Profiler::ThreadTrack().Emit(scopeId, cpuBegin_[scopeId], end);
 			}
-			std::get<0>(cpu_timer_query_map[name]) = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-		}
-		void EndCpuTimer(const char* name)
-		{
-			BENCH_MARK_CHECK();
-			assert( cpu_timer_query_map.find(name) != cpu_timer_query_map.end() );
-			std::get<1>(cpu_timer_query_map[name]) = std::chrono::high_resolution_clock::now().time_since_epoch().count();
 		}
-		float GetTime(const char* name)
-		{
-			if(timer_query_map.find(name) == timer_query_map.end())
-			{
-				return 0;
-			}
-			return (time_stamps[ std::get<1>(timer_query_map[name]) ] - time_stamps[ std::get<0>(timer_query_map[name])]) * timeStampPeriod_ * 1e-6f;
-		}
-		float GetCpuTime(const char* name)
-		{
-			if(cpu_timer_query_map.find(name) == cpu_timer_query_map.end())
-			{
-				return 0;
-			}
-			return std::get<2>(cpu_timer_query_map[name]) * 1e-6f;
-		}
-		std::vector<std::tuple<std::string, float> > FetchAllTimes()
+
+		struct TimeResult
 		{
-			std::list<std::tuple<std::string, float, uint64_t, uint64_t> > order_list;
-			std::vector<std::tuple<std::string, float> > result;
-			for(auto& [name, query] : timer_query_map)
-			{
-				order_list.insert(order_list.begin(), (std::make_tuple(name, GetTime(name.c_str()), std::get<0>(query), std::get<1>(query))));
-			}
+			uint32_t Id;
+			float Time;
+			uint32_t Depth;
+		};
+
+		// milliseconds of the latest collected frame, summed over every scope of that name
+		float GetTime(const char* name) const;
+		// milliseconds of the last completed cpu scope of that name
+		float GetCpuTime(const char* name) const;
+		// scopes of the latest collected frame in recording order
+		const std::vector<TimeResult>& Results() const { return results_; }
+		// frame number Results() belongs to, advances once per collected frame
+		uint64_t CollectedFrame() const { return collectedFrame_; }
 
-			// sort by tuple 2
-			order_list.sort([](const std::tuple<std::string, float, uint64_t, uint64_t>& a, const std::tuple<std::string, float, uint64_t, uint64_t>& b) -> bool
-			{
-				return std::get<2>(a) < std::get<2>(b);
-			});
+	private:
 
-			uint64_t last_order = 99;
-			std::string prefix = "";
-			for(auto& [name, time, startIdx, endIdx] : order_list)
-			{
-				if( startIdx < last_order)
-				{
-					prefix += "  ";
-					last_order = endIdx;
-				}
-				result.push_back(std::make_tuple(prefix + name, time));
-			}
+		struct Scope
+		{
+			uint32_t Id;
+			uint32_t StartQuery;
+			uint32_t EndQuery;
+			uint32_t Depth;
+		};
+
+		struct FramePool
+		{
+			VkQueryPool Pool = VK_NULL_HANDLE;
+			uint32_t Capacity{};
+			uint32_t Used{};
+			bool Pending{};
+			bool Overflowed{};
+			uint64_t Frame{};
+			int64_t CpuBegin{};
+			std::vector<Scope> Scopes;
+		};
+
+		bool Collect(FramePool& pool);
+		void CreatePool(FramePool& pool, uint32_t capacity);
 
-			return result;
-		}
-		
-		VkQueryPool query_pool_timestamps = VK_NULL_HANDLE;
-		std::vector<uint64_t> time_stamps{};
-		std::unordered_map<std::string, std::tuple<uint64_t, uint64_t> > timer_query_map{};
-		std::unordered_map<std::string, std::tuple<uint64_t, uint64_t, uint64_t> > cpu_timer_query_map{};
 		VkDevice device_ = VK_NULL_HANDLE;
-		uint32_t queryIdx = 0;
 		float timeStampPeriod_ = 1;
-		bool started_ = false;
+		std::vector<FramePool> pools_;
+		FramePool* recording_{};
+		std::vector<uint32_t> openScopes_;
+		uint64_t frame_{};
+		uint64_t collectedFrame_{};
+		std::vector<uint64_t> timeStamps_;
+		std::vector<TimeResult> results_;
+		std::vector<int64_t> cpuBegin_;
+		std::vector<int64_t> cpuTime_;
+		Utilities::Profiler::Track& gpuTrack_;
 	};
 
 	class ScopedGpuTimer
@@ -194,17 +152,17 @@ namespace Vulkan
 	public:
 		DEFAULT_NON_COPIABLE(ScopedGpuTimer)
 		
-		ScopedGpuTimer(VkCommandBuffer commandBuffer, VulkanGpuTimer* timer, const char* name ):commandBuffer_(commandBuffer),timer_(timer), name_(name)
+		ScopedGpuTimer(VkCommandBuffer commandBuffer, VulkanGpuTimer* timer, uint32_t scopeId ):commandBuffer_(commandBuffer),timer_(timer), scopeId_(scopeId)
 		{
-			timer_->Start(commandBuffer_, name_.c_str());
+			timer_->Start(commandBuffer_, scopeId_);
 		}
 		virtual ~ScopedGpuTimer()
 		{
-			timer_->End(commandBuffer_, name_.c_str());
+			timer_->End(commandBuffer_, scopeId_);
 		}
 		VkCommandBuffer commandBuffer_;
 		VulkanGpuTimer* timer_;
-		std::string name_;
+		uint32_t scopeId_;
 	};
 
 	class ScopedCpuTimer
@@ -212,16 +170,16 @@ namespace Vulkan
 	public:
 		DEFAULT_NON_COPIABLE(ScopedCpuTimer)
 		
-		ScopedCpuTimer(VulkanGpuTimer* timer, const char* name ):timer_(timer), name_(name)
+		ScopedCpuTimer(VulkanGpuTimer* timer, uint32_t scopeId ):timer_(timer), scopeId_(scopeId)
 		{
-			timer_->StartCpuTimer(name_.c_str());
+			timer_->StartCpuTimer(scopeId_);
 		}
 		virtual ~ScopedCpuTimer()
 		{
-			timer_->EndCpuTimer( name_.c_str());
+			timer_->EndCpuTimer(scopeId_);
 		}
 		VulkanGpuTimer* timer_;
-		std::string name_;
+		uint32_t scopeId_;
 	};
 	
 	class VulkanBaseRenderer
@@ -251,7 +209,19 @@ namespace Vulkan
 		virtual bool GetLastRaycastResult(Assets::RayCastResult& result) const {return false;}
 		virtual void SetRaycastRay(glm::vec3 org, glm::vec3 dir) const {};
 		
-		void CaptureScreenShot();
+		// read back the linear accumulated output (pre tonemap / denoise) as rgba float, false if the renderer has none
+		bool CaptureLinearOutput(std::vector<float>& rgba, VkExtent2D& extent);
+		virtual const RenderImage* GetLinearOutputImage() const { return nullptr; }
+		virtual const RenderImage* GetAlbedoImage() const { return nullptr; }
+		virtual const RenderImage* GetNormalImage() const { return nullptr; }
+
+		// queue an async copy, recorded at the end of the next frame and handed to the callback once that frame retired,
+		// the callback owns the slot until it calls GetReadbackRing().Release. A request the renderer cannot serve is dropped
+		// and calls dropped instead, so callers counting their requests in flight do not wait for it forever
+		void RequestReadback(EReadbackSource source, ReadbackRing::Callback callback, std::function<void()> dropped = nullptr);
+		// grows the ring to at least slotCount once nothing is in flight, callers keeping several captures in flight reserve first
+		void ReserveReadbackSlots(uint32_t slotCount);
+		class ReadbackRing& GetReadbackRing() { return *readbackRing_; }
 		void CaptureEditorViewport(VkCommandBuffer commandBuffer, const uint32_t imageIndex);
 		void ClearViewport(VkCommandBuffer commandBuffer, const uint32_t imageIndex);
 		
@@ -266,6 +236,9 @@ namespace Vulkan
 		class CommandPool& CommandPool() { return *commandPool_; }
 		const class DepthBuffer& DepthBuffer() const { return *depthBuffer_; }
 		const std::vector<Assets::UniformBuffer>& UniformBuffers() const { return uniformBuffers_; }
+		const std::vector<Assets::RayStatisticsBuffer>& RayStatisticsBuffers() const { return rayStatisticsBuffers_; }
+		// the counters of the last retired frame with collectRayStatistics_ set, one frame behind
+		const Assets::RayStatistics& LastRayStatistics() const { return lastRayStatistics_; }
 		const class GraphicsPipeline& GraphicsPipeline() const { return *graphicsPipeline_; }
 		const class FrameBuffer& SwapChainFrameBuffer(const size_t i) const { return swapChainFramebuffers_[i]; }
 		const bool CheckerboxRendering() {return checkerboxRendering_;}
@@ -302,6 +275,8 @@ namespace Vulkan
 		virtual void OnPostLoadScene() {}
 
 		bool VisualDebug() const {return visualDebug_;}
+		uint32_t SvgfIterations() const {return svgfIterations_;}
+		uint32_t RadianceCacheBounce() const {return radianceCacheBounce_;}
 
 		virtual void RegisterLogicRenderer(ERendererType type) {};
 		virtual void SwitchLogicRenderer(ERendererType type) {};
@@ -318,7 +293,6 @@ namespace Vulkan
 		// std::function<void()> OnDropFile;
 		// std::function<void()> OnFocus;
 
-		DeviceMemory* GetScreenShotMemory() const {return screenShotImageMemory_.get();}
 	
 		std::weak_ptr<Assets::Scene> scene_;
 		
@@ -330,6 +304,9 @@ namespace Vulkan
 		int frameCount_{};
 		bool forceSDR_{};
 		bool visualDebug_{};
+		bool collectRayStatistics_{};
+		uint32_t svgfIterations_{};
+		uint32_t radianceCacheBounce_{};
 	protected:
 		Assets::UniformBufferObject lastUBO;
 
@@ -337,6 +314,9 @@ namespace Vulkan
 	private:
 
 		void UpdateUniformBuffer(uint32_t imageIndex);
+		void RecordReadbacks(VkCommandBuffer commandBuffer);
+		void ClearRayStatistics(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+		void ReleaseRayStatistics(VkCommandBuffer commandBuffer, uint32_t imageIndex);
 		void RecreateSwapChain();
 
 		const VkPresentModeKHR presentMode_;
@@ -348,6 +328,10 @@ namespace Vulkan
 		std::unique_ptr<class Device> device_;
 		std::unique_ptr<class SwapChain> swapChain_;
 		std::vector<Assets::UniformBuffer> uniformBuffers_;
+		std::vector<Assets::RayStatisticsBuffer> rayStatisticsBuffers_;
+		Assets::RayStatistics lastRayStatistics_{};
+		// the buffer written by the frame in flight, -1 when it does not collect
+		int32_t pendingRayStatistics_{-1};
 		std::unique_ptr<class DepthBuffer> depthBuffer_;
 		std::unique_ptr<class GraphicsPipeline> graphicsPipeline_;
 		std::unique_ptr<PipelineCommon::BufferClearPipeline> bufferClearPipeline_;
@@ -359,12 +343,19 @@ namespace Vulkan
 		std::vector<class Semaphore> renderFinishedSemaphores_;
 		std::vector<class Fence> inFlightFences_;
 
-		std::unique_ptr<Image> screenShotImage_;
-		std::unique_ptr<DeviceMemory> screenShotImageMemory_;
-		std::unique_ptr<ImageView> screenShotImageView_;
 
 		std::unique_ptr<RenderImage> rtEditorViewport_;
 
+		struct PendingReadback
+		{
+			EReadbackSource Source;
+			ReadbackRing::Callback Callback;
+			std::function<void()> Dropped;
+		};
+		std::vector<PendingReadback> pendingReadbacks_;
+		std::unique_ptr<class ReadbackRing> readbackRing_;
+		uint64_t submitSerial_{};
+
 		std::unique_ptr<VulkanGpuTimer> gpuTimer_;
 
 		std::unique_ptr<Assets::GlobalTexturePool> globalTexturePool_;
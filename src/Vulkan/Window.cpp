@@ -255,6 +255,12 @@ void Window::Maximum() {
 #endif
 }
 
+void Window::Resize(uint32_t width, uint32_t height) {
+#if !ANDROID
+	glfwSetWindowSize(window_, static_cast<int>(width), static_cast<int>(height));
+#endif
+}
+
 constexpr double CLOSE_AREA_WIDTH = 0;
 constexpr double TITLE_AREA_HEIGHT = 55;	
 void Window::attemptDragWindow() {
@@ -48,6 +48,8 @@ namespace Vulkan
 
 		void Minimize();
 		void Maximum();
+		// window size in screen coordinates, the swapchain follows on its next recreation
+		void Resize(uint32_t width, uint32_t height);
 
 		void attemptDragWindow();
 	private: